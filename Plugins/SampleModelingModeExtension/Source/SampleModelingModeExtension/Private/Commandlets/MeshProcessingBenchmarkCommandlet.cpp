@@ -0,0 +1,524 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Commandlets/MeshProcessingBenchmarkCommandlet.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "Operations/MeshNoiseOp.h"
+#include "Operations/MeshPlaneCutOp.h"
+#include "Tools/MeshNoiseTool.h"
+#include "Tools/MeshProcessingBPTool.h"
+#include "Spatial/ActorBoundsTree.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Generators/SphereGenerator.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/HitResult.h"
+#include "Math/RandomStream.h"
+#include "Util/ProgressCancel.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+using namespace UE::Geometry;
+
+
+namespace Local
+{
+
+struct FBenchmarkMesh
+{
+	FString Name;
+	TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Mesh;
+	TSharedPtr<FMeshNormals, ESPMode::ThreadSafe> VertexNormals;
+};
+
+struct FBenchmarkCase
+{
+	FString Name;
+	TFunction<TUniquePtr<FMeshProcessingOperator>(const FBenchmarkMesh&)> MakeOperator;
+	// if set, the maximum vertex deviation from the result of this (earlier) case is reported
+	FString ReferenceCase;
+	// if true, the maximum normal deviation from the ReferenceCase result is reported as well
+	bool bCompareNormals = false;
+};
+
+
+// @return maximum distance between corresponding vertices of two results of the same vertex-displacement operator
+static double GetMaxVertexDeviation(const FDynamicMesh3& Mesh, const FDynamicMesh3& ReferenceMesh)
+{
+	double MaxDistSqr = 0;
+	for (int32 vid : Mesh.VertexIndicesItr())
+	{
+		if (ReferenceMesh.IsVertex(vid))
+		{
+			MaxDistSqr = FMath::Max(MaxDistSqr, DistanceSquared(Mesh.GetVertex(vid), ReferenceMesh.GetVertex(vid)));
+		}
+	}
+	return FMath::Sqrt(MaxDistSqr);
+}
+
+
+// @return maximum angle in degrees between the corresponding primary normals of two results with the same topology, or -1 if either has no normals
+static double GetMaxNormalDeviation(const FDynamicMesh3& Mesh, const FDynamicMesh3& ReferenceMesh)
+{
+	const FDynamicMeshNormalOverlay* Normals = (Mesh.HasAttributes()) ? Mesh.Attributes()->PrimaryNormals() : nullptr;
+	const FDynamicMeshNormalOverlay* ReferenceNormals = (ReferenceMesh.HasAttributes()) ? ReferenceMesh.Attributes()->PrimaryNormals() : nullptr;
+	if (Normals == nullptr || ReferenceNormals == nullptr)
+	{
+		return -1.0;
+	}
+	double MinCosAngle = 1.0;
+	for (int32 tid : Mesh.TriangleIndicesItr())
+	{
+		if (ReferenceMesh.IsTriangle(tid) && Normals->IsSetTriangle(tid) && ReferenceNormals->IsSetTriangle(tid))
+		{
+			FIndex3i Elements = Normals->GetTriangle(tid);
+			FIndex3i ReferenceElements = ReferenceNormals->GetTriangle(tid);
+			for (int32 j = 0; j < 3; ++j)
+			{
+				FVector3d Normal = Normalized((FVector3d)Normals->GetElement(Elements[j]));
+				FVector3d ReferenceNormal = Normalized((FVector3d)ReferenceNormals->GetElement(ReferenceElements[j]));
+				MinCosAngle = FMath::Min(MinCosAngle, Normal.Dot(ReferenceNormal));
+			}
+		}
+	}
+	return FMathd::RadToDeg * FMath::Acos(FMath::Clamp(MinCosAngle, -1.0, 1.0));
+}
+
+
+static bool LoadStaticMeshAsset(const TCHAR* AssetPath, const FString& Name, FDynamicMesh3& MeshOut)
+{
+	UStaticMesh* StaticMesh = LoadObject<UStaticMesh>(nullptr, AssetPath);
+	const FMeshDescription* MeshDescription = (StaticMesh != nullptr) ? StaticMesh->GetMeshDescription(0) : nullptr;
+	if (MeshDescription == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingBenchmark: could not load %s, skipping %s"), AssetPath, *Name);
+		return false;
+	}
+	FMeshDescriptionToDynamicMesh Converter;
+	Converter.Convert(MeshDescription, MeshOut);
+	return true;
+}
+
+
+static void GenerateSphere(int32 TargetTriangleCount, FDynamicMesh3& MeshOut)
+{
+	// the sphere generator emits roughly 2 * NumPhi * NumTheta triangles
+	int32 Resolution = FMath::Max(3, (int32)FMath::Sqrt((double)TargetTriangleCount / 2.0));
+	FSphereGenerator Generator;
+	Generator.Radius = 100.0;
+	Generator.NumPhi = Resolution;
+	Generator.NumTheta = Resolution;
+	MeshOut = FDynamicMesh3(&Generator.Generate());
+}
+
+
+static FBenchmarkMesh MakeBenchmarkMesh(const FString& Name, FDynamicMesh3&& Mesh)
+{
+	FBenchmarkMesh Result;
+	Result.Name = Name;
+	TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> SharedMesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>(MoveTemp(Mesh));
+	Result.VertexNormals = MakeShared<FMeshNormals, ESPMode::ThreadSafe>(SharedMesh.Get());
+	Result.VertexNormals->ComputeVertexNormals();
+	Result.Mesh = SharedMesh;
+	return Result;
+}
+
+
+static TSharedRef<FJsonObject> MakeStageJson(const FMeshProcessingOperator::FStageStats& Stage, int32 TriangleCount)
+{
+	TSharedRef<FJsonObject> StageObject = MakeShared<FJsonObject>();
+	StageObject->SetStringField(TEXT("Name"), Stage.Name);
+	StageObject->SetNumberField(TEXT("Seconds"), Stage.Seconds);
+	StageObject->SetNumberField(TEXT("TrianglesPerSecond"), (Stage.Seconds > 0) ? (double)TriangleCount / Stage.Seconds : 0.0);
+	StageObject->SetNumberField(TEXT("UsedPhysicalDelta"), (double)Stage.UsedPhysicalDelta);
+	StageObject->SetNumberField(TEXT("TrackedPeakMemory"), (double)Stage.TrackedPeakMemory);
+	return StageObject;
+}
+
+
+struct FFindHitStats
+{
+	int32 NumActors = 0;
+	double BuildSeconds = 0;
+	double AverageMs = 0;
+	double MaxMs = 0;
+	int32 NumHits = 0;
+};
+
+// time the UActorClickedBPTool hit test, ie FActorBoundsTree::FindNearestHit(), in a temporary world of NumActors cubes on a grid
+static bool BenchmarkFindHit(int32 NumActors, int32 NumRays, FFindHitStats& StatsOut)
+{
+	UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (CubeMesh == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingBenchmark: could not load /Engine/BasicShapes/Cube"));
+		return false;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Editor, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+	WorldContext.SetCurrentWorld(World);
+
+	// 100cm cubes with 100cm gaps
+	const double Spacing = 200.0;
+	int32 GridSize = FMath::CeilToInt(FMath::Sqrt((double)NumActors));
+	for (int32 k = 0; k < NumActors; ++k)
+	{
+		FVector Location((k % GridSize) * Spacing, (k / GridSize) * Spacing, 0.0);
+		AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator);
+		Actor->GetStaticMeshComponent()->SetStaticMesh(CubeMesh);
+	}
+
+	FActorBoundsTree ActorTree;
+	double StartTime = FPlatformTime::Seconds();
+	ActorTree.Build(World);
+	StatsOut.BuildSeconds = FPlatformTime::Seconds() - StartTime;
+	StatsOut.NumActors = ActorTree.GetNumActors();
+
+	// vertical click rays at random positions over the grid, about a quarter of them hit a cube
+	FRandomStream Random(31337);
+	double TotalSeconds = 0;
+	for (int32 k = 0; k < NumRays; ++k)
+	{
+		FVector Origin(Random.FRandRange(-Spacing, GridSize * Spacing), Random.FRandRange(-Spacing, GridSize * Spacing), 10000.0);
+		FRay Ray(Origin, FVector(0, 0, -1));
+		FHitResult Hit;
+		double RayStartTime = FPlatformTime::Seconds();
+		bool bHit = ActorTree.FindNearestHit(Ray, HALF_WORLD_MAX, Hit);
+		double RaySeconds = FPlatformTime::Seconds() - RayStartTime;
+		TotalSeconds += RaySeconds;
+		StatsOut.MaxMs = FMath::Max(StatsOut.MaxMs, RaySeconds * 1000.0);
+		StatsOut.NumHits += (bHit) ? 1 : 0;
+	}
+	StatsOut.AverageMs = (NumRays > 0) ? (TotalSeconds * 1000.0 / NumRays) : 0.0;
+
+	ActorTree.Reset();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+}
+
+
+
+UMeshProcessingBenchmarkCommandlet::UMeshProcessingBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Benchmark the SampleModelingModeExtension Tool operators and write the results to a JSON file");
+	HelpUsage = TEXT("-run=MeshProcessingBenchmark [-Sizes=10000,100000,1000000,10000000] [-Iterations=3] [-MaxTessellatedTriangles=4000000] [-FindHitActors=100000] [-Output=<path.json>]");
+}
+
+
+int32 UMeshProcessingBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString SizesString = TEXT("10000,100000,1000000,10000000");
+	FParse::Value(*Params, TEXT("Sizes="), SizesString);
+	int32 Iterations = 3;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	Iterations = FMath::Max(1, Iterations);
+	int32 MaxTessellatedTriangles = 4000000;
+	FParse::Value(*Params, TEXT("MaxTessellatedTriangles="), MaxTessellatedTriangles);
+	int32 FindHitActors = 100000;
+	FParse::Value(*Params, TEXT("FindHitActors="), FindHitActors);
+	FString OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"),
+		FString::Printf(TEXT("MeshProcessing-%s.json"), *FDateTime::Now().ToString()));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	//
+	// build the set of test meshes
+	//
+	TArray<Local::FBenchmarkMesh> Meshes;
+	{
+		FDynamicMesh3 AssetMesh;
+		if (Local::LoadStaticMeshAsset(TEXT("/Game/SM_Bunny.SM_Bunny"), TEXT("SM_Bunny"), AssetMesh))
+		{
+			Meshes.Add(Local::MakeBenchmarkMesh(TEXT("SM_Bunny"), MoveTemp(AssetMesh)));
+		}
+	}
+	{
+		FDynamicMesh3 AssetMesh;
+		if (Local::LoadStaticMeshAsset(TEXT("/Game/SM_Sphere.SM_Sphere"), TEXT("SM_Sphere"), AssetMesh))
+		{
+			Meshes.Add(Local::MakeBenchmarkMesh(TEXT("SM_Sphere"), MoveTemp(AssetMesh)));
+		}
+	}
+	TArray<FString> SizeStrings;
+	SizesString.ParseIntoArray(SizeStrings, TEXT(","));
+	for (const FString& SizeString : SizeStrings)
+	{
+		int32 TriangleCount = FCString::Atoi(*SizeString);
+		if (TriangleCount > 0)
+		{
+			FDynamicMesh3 SphereMesh;
+			Local::GenerateSphere(TriangleCount, SphereMesh);
+			Meshes.Add(Local::MakeBenchmarkMesh(FString::Printf(TEXT("Sphere_%d"), TriangleCount), MoveTemp(SphereMesh)));
+		}
+	}
+
+	//
+	// operator configurations
+	//
+	TArray<Local::FBenchmarkCase> Cases;
+	Cases.Add({ TEXT("Noise"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	} });
+	Cases.Add({ TEXT("NoiseIndexed"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		// the per-vertex indexed displacement, for comparison with the batched displacement of the Noise case
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		Options.bBatchedDisplacement = false;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	} });
+	Cases.Add({ TEXT("NoiseRecomputedNormals"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		// the normals recomputed from the displaced mesh, for comparison with the analytic normals of the Noise case
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		Options.bAnalyticNormals = false;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	}, TEXT("Noise"), true });
+	Cases.Add({ TEXT("NoiseFloat"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		// the single-precision displacement used for Tool previews, compared against the double-precision Noise case
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		Options.bSinglePrecision = true;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	}, TEXT("Noise") });
+	Cases.Add({ TEXT("NoiseChunked"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		// the displacement in chunks of bounded memory, the deviation from the Noise case must be zero
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		Options.BatchMemoryBudget = 4 * 1024 * 1024;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	}, TEXT("Noise") });
+	Cases.Add({ TEXT("NoiseScratchFile"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		// the chunked displacement with the analytic normals in a scratch file, the tracked peak stays within the budget
+		// and the deviation from the Noise case, including the normals, must be zero
+		FMeshNoiseOp::FOptions Options;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		Options.BatchMemoryBudget = 4 * 1024 * 1024;
+		Options.ScratchFileDirectory = FScratchFile::GetDefaultDirectory();
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	}, TEXT("Noise"), true });
+	Cases.Add({ TEXT("NoiseTessellated"), [MaxTessellatedTriangles](const Local::FBenchmarkMesh& Mesh)
+	{
+		// a tessellation level of 1 produces 4x the input triangles
+		if ((int64)Mesh.Mesh->TriangleCount() * 4 > (int64)MaxTessellatedTriangles)
+		{
+			return TUniquePtr<FMeshProcessingOperator>();
+		}
+		FMeshNoiseOp::FOptions Options;
+		Options.Subdivisions = 1;
+		Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+		Options.Magnitude = 1.0;
+		TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+		Op->BaseMeshNormals = Mesh.VertexNormals;
+		return TUniquePtr<FMeshProcessingOperator>(MoveTemp(Op));
+	} });
+	Cases.Add({ TEXT("PlaneCut"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		FMeshPlaneCutOp::FOptions Options;
+		Options.LocalToWorld = FTransform::Identity;
+		Options.WorldPlane = FTransform(Mesh.Mesh->GetBounds().Center());
+		Options.bFillHole = true;
+		return TUniquePtr<FMeshProcessingOperator>(MakeUnique<FMeshPlaneCutOp>(Options));
+	} });
+	Cases.Add({ TEXT("Chain"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		FMeshProcessingOperationChain Chain;
+		Chain.AddOperation(GetDefault<UMeshProcessingRecomputeNormalsChainStep>()->MakeOperation(FMeshProcessingBPToolParameters()));
+		return UMeshProcessingBPTool::MakeNativeChainOperator(Chain);
+	} });
+	Cases.Add({ TEXT("ChainChunked"), [](const Local::FBenchmarkMesh& Mesh)
+	{
+		FMeshProcessingOperationChain Chain;
+		Chain.AddOperation(GetDefault<UMeshProcessingRecomputeNormalsChainStep>()->MakeOperation(FMeshProcessingBPToolParameters()));
+		FMeshChunkedExecutionOptions ChunkOptions;
+		return UMeshProcessingBPTool::MakeNativeChainOperator(Chain, &ChunkOptions);
+	} });
+
+	//
+	// run the benchmarks, the fastest iteration of each case is reported
+	//
+	TArray<TSharedPtr<FJsonValue>> ResultValues;
+	for (const Local::FBenchmarkMesh& Mesh : Meshes)
+	{
+		int32 TriangleCount = Mesh.Mesh->TriangleCount();
+		// results of the cases that are referenced by other cases, for this mesh
+		TMap<FString, TUniquePtr<FDynamicMesh3>> ReferenceResults;
+		for (const Local::FBenchmarkCase& Case : Cases)
+		{
+			double BestSeconds = TNumericLimits<double>::Max();
+			TArray<FMeshProcessingOperator::FStageStats> BestStages;
+			// the memory tracked by the operator, as the process peak is dominated by the test meshes
+			uint64 TrackedPeakMemory = 0;
+			bool bSkipped = false;
+			TUniquePtr<FDynamicMesh3> LastResult;
+			for (int32 Iteration = 0; Iteration < Iterations && bSkipped == false; ++Iteration)
+			{
+				TUniquePtr<FMeshProcessingOperator> Operator = Case.MakeOperator(Mesh);
+				if (Operator.IsValid() == false)
+				{
+					bSkipped = true;
+					break;
+				}
+				Operator->SetInputMesh(Mesh.Mesh);
+				Operator->SetTransform(FTransformSRT3d::Identity());
+				Operator->bCollectStageStats = true;
+
+				FProgressCancel Progress;
+				double StartTime = FPlatformTime::Seconds();
+				Operator->CalculateResult(&Progress);
+				double Seconds = FPlatformTime::Seconds() - StartTime;
+
+				TrackedPeakMemory = FMath::Max(TrackedPeakMemory, Operator->GetTrackedPeakMemory());
+				if (Seconds < BestSeconds)
+				{
+					BestSeconds = Seconds;
+					BestStages = Operator->GetStageStats();
+				}
+				LastResult = Operator->ExtractResult();
+			}
+			if (bSkipped)
+			{
+				UE_LOG(LogSampleModelingModeExtension, Display, TEXT("%-16s %-18s skipped"), *Mesh.Name, *Case.Name);
+				continue;
+			}
+
+			double MaxDeviation = -1.0;
+			double MaxNormalDeviation = -1.0;
+			const TUniquePtr<FDynamicMesh3>* ReferenceResult = ReferenceResults.Find(Case.ReferenceCase);
+			if (Case.ReferenceCase.IsEmpty() == false && ReferenceResult != nullptr && ReferenceResult->IsValid() && LastResult.IsValid())
+			{
+				MaxDeviation = Local::GetMaxVertexDeviation(*LastResult, **ReferenceResult);
+				if (Case.bCompareNormals)
+				{
+					MaxNormalDeviation = Local::GetMaxNormalDeviation(*LastResult, **ReferenceResult);
+				}
+			}
+			if (Cases.ContainsByPredicate([&Case](const Local::FBenchmarkCase& Other) { return Other.ReferenceCase == Case.Name; }))
+			{
+				ReferenceResults.Add(Case.Name, MoveTemp(LastResult));
+			}
+
+			double TrianglesPerSecond = (BestSeconds > 0) ? (double)TriangleCount / BestSeconds : 0.0;
+			UE_LOG(LogSampleModelingModeExtension, Display, TEXT("%-16s %-18s %10d tris  %10.4fs  %12.0f tris/s  peak %6.1f MB"),
+				*Mesh.Name, *Case.Name, TriangleCount, BestSeconds, TrianglesPerSecond, (double)TrackedPeakMemory / (1024.0 * 1024.0));
+			if (MaxDeviation >= 0)
+			{
+				UE_LOG(LogSampleModelingModeExtension, Display, TEXT("%-16s %-18s max deviation from %s: %g"), *Mesh.Name, *Case.Name, *Case.ReferenceCase, MaxDeviation);
+			}
+			if (MaxNormalDeviation >= 0)
+			{
+				UE_LOG(LogSampleModelingModeExtension, Display, TEXT("%-16s %-18s max normal deviation from %s: %g degrees"), *Mesh.Name, *Case.Name, *Case.ReferenceCase, MaxNormalDeviation);
+			}
+
+			TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+			ResultObject->SetStringField(TEXT("Mesh"), Mesh.Name);
+			ResultObject->SetStringField(TEXT("Operator"), Case.Name);
+			ResultObject->SetNumberField(TEXT("Triangles"), TriangleCount);
+			ResultObject->SetNumberField(TEXT("Vertices"), Mesh.Mesh->VertexCount());
+			ResultObject->SetNumberField(TEXT("Seconds"), BestSeconds);
+			ResultObject->SetNumberField(TEXT("TrianglesPerSecond"), TrianglesPerSecond);
+			ResultObject->SetNumberField(TEXT("TrackedPeakMemory"), (double)TrackedPeakMemory);
+			if (MaxDeviation >= 0)
+			{
+				ResultObject->SetStringField(TEXT("ReferenceOperator"), Case.ReferenceCase);
+				ResultObject->SetNumberField(TEXT("MaxDeviation"), MaxDeviation);
+			}
+			if (MaxNormalDeviation >= 0)
+			{
+				ResultObject->SetNumberField(TEXT("MaxNormalDeviationDegrees"), MaxNormalDeviation);
+			}
+			TArray<TSharedPtr<FJsonValue>> StageValues;
+			for (const FMeshProcessingOperator::FStageStats& Stage : BestStages)
+			{
+				StageValues.Add(MakeShared<FJsonValueObject>(Local::MakeStageJson(Stage, TriangleCount)));
+			}
+			ResultObject->SetArrayField(TEXT("Stages"), StageValues);
+			ResultValues.Add(MakeShared<FJsonValueObject>(ResultObject));
+		}
+	}
+
+	//
+	// click hit test of UActorClickedBPTool in a dense level, the target is below 1 ms per click
+	//
+	TSharedPtr<FJsonObject> FindHitObject;
+	Local::FFindHitStats FindHitStats;
+	if (FindHitActors > 0 && Local::BenchmarkFindHit(FindHitActors, 1000, FindHitStats))
+	{
+		const double TargetMs = 1.0;
+		UE_LOG(LogSampleModelingModeExtension, Display, TEXT("%-16s %d actors: build %.3f s, %.4f ms average, %.4f ms max, %d hits%s"),
+			TEXT("FindHit"), FindHitStats.NumActors, FindHitStats.BuildSeconds, FindHitStats.AverageMs, FindHitStats.MaxMs, FindHitStats.NumHits,
+			(FindHitStats.AverageMs < TargetMs) ? TEXT("") : TEXT(" (over the 1 ms target)"));
+		FindHitObject = MakeShared<FJsonObject>();
+		FindHitObject->SetNumberField(TEXT("Actors"), FindHitStats.NumActors);
+		FindHitObject->SetNumberField(TEXT("BuildSeconds"), FindHitStats.BuildSeconds);
+		FindHitObject->SetNumberField(TEXT("AverageMs"), FindHitStats.AverageMs);
+		FindHitObject->SetNumberField(TEXT("MaxMs"), FindHitStats.MaxMs);
+		FindHitObject->SetNumberField(TEXT("TargetMs"), TargetMs);
+	}
+
+	TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetNumberField(TEXT("Version"), 2);
+	RootObject->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	RootObject->SetStringField(TEXT("CPU"), FPlatformMisc::GetCPUBrand());
+	RootObject->SetNumberField(TEXT("NumCores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	RootObject->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+	RootObject->SetNumberField(TEXT("Iterations"), Iterations);
+	RootObject->SetArrayField(TEXT("Results"), ResultValues);
+	if (FindHitObject.IsValid())
+	{
+		RootObject->SetObjectField(TEXT("FindHit"), FindHitObject);
+	}
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	FJsonSerializer::Serialize(RootObject, Writer);
+	if (FFileHelper::SaveStringToFile(JsonString, *OutputPath) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingBenchmark: could not write %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBenchmark: wrote %s"), *OutputPath);
+
+	return 0;
+}
@@ -0,0 +1,465 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Commandlets/MeshProcessingBulkCommandlet.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "Operations/MeshProcessingPreset.h"
+#include "Operations/MeshProcessingWorkerPool.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "DynamicMeshToMeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "Engine/StaticMesh.h"
+#include "UDynamicMesh.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "UObject/SavePackage.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Util/ProgressCancel.h"
+#include "Async/Async.h"
+#include "Misc/PackageName.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include <atomic>
+
+using namespace UE::Geometry;
+
+
+namespace Local
+{
+
+enum class EBulkItemStage : uint8
+{
+	// conversion and operator, on a worker thread
+	Processing,
+	// Blueprint chain that must be executed on the game thread
+	WaitingForGameThread,
+	// executed by a worker process, a dedicated thread waits for the result
+	InWorkerProcess,
+	// conversion of the result back to a MeshDescription, on a worker thread
+	Converting,
+	ReadyToSave,
+	Failed
+};
+
+
+/**
+ * Operation configuration shared by all assets. This is created on the game thread before processing
+ * starts, and only read by the worker threads.
+ */
+struct FBulkSettings
+{
+	FMeshProcessingPreset Preset;
+
+	// if not empty, the operators are executed by FMeshProcessingWorkerPool with this preset
+	FString WorkerPresetJson;
+	double WorkerTimeoutSeconds = 0;
+};
+
+
+struct FBulkItem
+{
+	FAssetData AssetData;
+	TStrongObjectPtr<UStaticMesh> StaticMesh;
+	const FMeshDescription* SourceDescription = nullptr;
+
+	// mesh between the worker stages and the game thread Blueprint stage
+	FDynamicMesh3 Mesh;
+	TStrongObjectPtr<UDynamicMesh> TempMesh;
+	// Blueprint chain of this item, if the chain of the preset cannot be executed by several worker threads at once
+	FMeshProcessingOperationChain Chain;
+	TArray<TStrongObjectPtr<UMeshProcessingBPToolOperation>> BlueprintInstances;
+	FMeshDescription ResultDescription;
+
+	int32 InputTriangles = 0;
+	int32 ResultTriangles = 0;
+	double WorkerSeconds = 0;
+	FString Error;
+
+	std::atomic<EBulkItemStage> Stage{ EBulkItemStage::Processing };
+};
+typedef TSharedPtr<FBulkItem, ESPMode::ThreadSafe> FBulkItemPtr;
+
+
+static bool InitializeSettings(const FString& Params, FBulkSettings& Settings)
+{
+	TSharedPtr<FJsonObject> PresetJson;
+	FString Preset;
+	if (FParse::Value(*Params, TEXT("Preset="), Preset) && FMeshProcessingPreset::LoadPresetJson(Preset, PresetJson) == false)
+	{
+		return false;
+	}
+
+	// the command line overrides the Operation of the preset
+	FString OperationName;
+	FParse::Value(*Params, TEXT("Operation="), OperationName);
+	if (Settings.Preset.Initialize(PresetJson, OperationName) == false)
+	{
+		return false;
+	}
+
+	// the worker processes are configured with the same preset, so that they create the same operators
+	if (FParse::Param(*Params, TEXT("OutOfProcess")))
+	{
+		TSharedRef<FJsonObject> WorkerJson = (PresetJson.IsValid()) ? PresetJson.ToSharedRef() : MakeShared<FJsonObject>();
+		if (OperationName.IsEmpty() == false)
+		{
+			WorkerJson->SetStringField(TEXT("Operation"), OperationName);
+		}
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Settings.WorkerPresetJson);
+		FJsonSerializer::Serialize(WorkerJson, Writer);
+		Settings.WorkerTimeoutSeconds = GetDefault<USampleModelingModeExtensionSettings>()->WorkerProcessTimeoutSeconds;
+		FParse::Value(*Params, TEXT("WorkerTimeout="), Settings.WorkerTimeoutSeconds);
+	}
+	return true;
+}
+
+
+// worker stage: convert the result mesh back to a MeshDescription
+static void ConvertResult(FBulkItem& Item)
+{
+	Item.ResultTriangles = Item.Mesh.TriangleCount();
+	if (Item.ResultTriangles == 0)
+	{
+		Item.Error = TEXT("empty result mesh");
+		Item.Stage = EBulkItemStage::Failed;
+		return;
+	}
+
+	FStaticMeshAttributes Attributes(Item.ResultDescription);
+	Attributes.Register();
+	FDynamicMeshToMeshDescription Converter;
+	Converter.Convert(&Item.Mesh, Item.ResultDescription);
+	Item.Mesh.Clear();
+	Item.Stage = EBulkItemStage::ReadyToSave;
+}
+
+
+// worker stage: convert the source MeshDescription and run the operator
+static void ProcessItem(FBulkItem& Item, const FBulkSettings& Settings)
+{
+	double StartTime = FPlatformTime::Seconds();
+
+	TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> InputMesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>();
+	FMeshDescriptionToDynamicMesh Converter;
+	Converter.Convert(Item.SourceDescription, *InputMesh);
+	Item.InputTriangles = InputMesh->TriangleCount();
+
+	if (Settings.WorkerPresetJson.IsEmpty() == false)
+	{
+		// the worker process executes all operations including game-thread Blueprints, see LaunchWorkerProcessStage()
+		Item.Mesh = MoveTemp(*InputMesh);
+		Item.WorkerSeconds += FPlatformTime::Seconds() - StartTime;
+		Item.Stage = EBulkItemStage::InWorkerProcess;
+		return;
+	}
+	else if (Settings.Preset.RequiresChainExecution())
+	{
+		Item.Mesh = MoveTemp(*InputMesh);
+		if (Settings.Preset.Chain.IsThreadSafe() == false)
+		{
+			Item.WorkerSeconds += FPlatformTime::Seconds() - StartTime;
+			Item.Stage = EBulkItemStage::WaitingForGameThread;
+			return;
+		}
+		// thread-safe chains never dispatch to the game thread
+		const FMeshProcessingOperationChain& Chain = (Item.Chain.IsEmpty()) ? Settings.Preset.Chain : Item.Chain;
+		Chain.Execute(Item.Mesh, nullptr, Item.TempMesh.Get(), [](TFunctionRef<void()>) { checkNoEntry(); });
+	}
+	else
+	{
+		TUniquePtr<FMeshProcessingOperator> Operator = Settings.Preset.MakeOperator(InputMesh);
+		if (Operator.IsValid() == false)
+		{
+			Item.Error = TEXT("could not create operator");
+			Item.Stage = EBulkItemStage::Failed;
+			return;
+		}
+		FProgressCancel Progress;
+		Operator->CalculateResult(&Progress);
+		TUniquePtr<FDynamicMesh3> ResultMesh = Operator->ExtractResult();
+		if (ResultMesh.IsValid() == false)
+		{
+			Item.Error = TEXT("operator did not return a result");
+			Item.Stage = EBulkItemStage::Failed;
+			return;
+		}
+		Item.Mesh = MoveTemp(*ResultMesh);
+	}
+	InputMesh.Reset();
+
+	ConvertResult(Item);
+	Item.WorkerSeconds += FPlatformTime::Seconds() - StartTime;
+}
+
+
+static void LaunchWorkerProcessStage(const FBulkItemPtr& Item, const FBulkSettings& Settings);
+
+static void LaunchWorkerStage(const FBulkItemPtr& Item, const FBulkSettings& Settings)
+{
+	Async(EAsyncExecution::ThreadPool, [Item, &Settings]()
+	{
+		if (Item->Stage == EBulkItemStage::Converting)
+		{
+			double StartTime = FPlatformTime::Seconds();
+			ConvertResult(*Item);
+			Item->WorkerSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+		else
+		{
+			ProcessItem(*Item, Settings);
+			if (Item->Stage == EBulkItemStage::InWorkerProcess)
+			{
+				LaunchWorkerProcessStage(Item, Settings);
+			}
+		}
+	});
+}
+
+// wait for a worker process on a dedicated thread, so that the thread pool keeps converting the other items meanwhile
+static void LaunchWorkerProcessStage(const FBulkItemPtr& Item, const FBulkSettings& Settings)
+{
+	Async(EAsyncExecution::Thread, [Item, &Settings]()
+	{
+		FString Error;
+		FDynamicMesh3 ResultMesh;
+		FMeshProcessingWorkerPool::EResult Result = FMeshProcessingWorkerPool::Get().Execute(Settings.WorkerPresetJson, Item->Mesh, ResultMesh, Settings.WorkerTimeoutSeconds, TFunction<bool()>(), TFunction<bool()>(), Error);
+		if (Result != FMeshProcessingWorkerPool::EResult::Success)
+		{
+			Item->Error = FString::Printf(TEXT("worker process: %s"), *Error);
+			Item->Stage = EBulkItemStage::Failed;
+			return;
+		}
+		Item->Mesh = MoveTemp(ResultMesh);
+		Item->Stage = EBulkItemStage::Converting;
+		LaunchWorkerStage(Item, Settings);
+	});
+}
+
+
+// game thread stage: write the result into the asset and save its package
+static bool SaveItem(FBulkItem& Item, bool bBuild, bool bSave)
+{
+	UStaticMesh* StaticMesh = Item.StaticMesh.Get();
+
+	// keep the imported material slot names of the existing polygon groups
+	FStaticMeshAttributes Attributes(Item.ResultDescription);
+	TPolygonGroupAttributesRef<FName> SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+	const TArray<FStaticMaterial>& StaticMaterials = StaticMesh->GetStaticMaterials();
+	for (FPolygonGroupID GroupID : Item.ResultDescription.PolygonGroups().GetElementIDs())
+	{
+		if (StaticMaterials.IsValidIndex(GroupID.GetValue()))
+		{
+			SlotNames[GroupID] = StaticMaterials[GroupID.GetValue()].ImportedMaterialSlotName;
+		}
+	}
+
+	FMeshDescription* MeshDescription = StaticMesh->CreateMeshDescription(0, MoveTemp(Item.ResultDescription));
+	if (MeshDescription == nullptr)
+	{
+		Item.Error = TEXT("could not replace MeshDescription");
+		return false;
+	}
+	StaticMesh->CommitMeshDescription(0);
+	if (bBuild)
+	{
+		StaticMesh->Build(true);
+	}
+	StaticMesh->MarkPackageDirty();
+
+	if (bSave == false)
+	{
+		return true;
+	}
+
+	UPackage* Package = StaticMesh->GetOutermost();
+	FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+	if (IFileManager::Get().IsReadOnly(*Filename))
+	{
+		Item.Error = FString::Printf(TEXT("%s is read-only"), *Filename);
+		return false;
+	}
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	SaveArgs.SaveFlags = SAVE_NoError;
+	if (UPackage::SavePackage(Package, nullptr, *Filename, SaveArgs) == false)
+	{
+		Item.Error = FString::Printf(TEXT("could not save %s"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+}
+
+
+
+UMeshProcessingBulkCommandlet::UMeshProcessingBulkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Apply a SampleModelingModeExtension mesh processing operation to all Static Mesh assets under a content path");
+	HelpUsage = TEXT("-run=MeshProcessingBulk -Path=/Game/Meshes (-Preset=<name or path.json> | -Operation=Noise|PlaneCut|BP) [-MaxInFlight=<N>] [-OutOfProcess [-WorkerTimeout=<seconds>]] [-Build] [-NoSave]");
+}
+
+
+int32 UMeshProcessingBulkCommandlet::Main(const FString& Params)
+{
+	FString ContentPath;
+	if (FParse::Value(*Params, TEXT("Path="), ContentPath) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingBulk: -Path is required. Usage: %s"), *HelpUsage);
+		return 1;
+	}
+	int32 MaxInFlight = 2 * FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn());
+	FParse::Value(*Params, TEXT("MaxInFlight="), MaxInFlight);
+	MaxInFlight = FMath::Max(1, MaxInFlight);
+	bool bBuild = FParse::Param(*Params, TEXT("Build"));
+	bool bSave = FParse::Param(*Params, TEXT("NoSave")) == false;
+	const int32 GarbageCollectInterval = 64;
+
+	Local::FBulkSettings Settings;
+	if (Local::InitializeSettings(Params, Settings) == false)
+	{
+		return 1;
+	}
+	bool bOutOfProcess = (Settings.WorkerPresetJson.IsEmpty() == false);
+	bool bWorkerUsesUObjects = (bOutOfProcess == false && Settings.Preset.RequiresChainExecution() && Settings.Preset.Chain.IsThreadSafe());
+
+	//
+	// find the assets
+	//
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+	FARFilter Filter;
+	Filter.PackagePaths.Add(FName(*ContentPath));
+	Filter.bRecursivePaths = true;
+	Filter.ClassNames.Add(UStaticMesh::StaticClass()->GetFName());
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssets(Filter, Assets);
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: processing %d Static Meshes in %s with up to %d in flight"), Assets.Num(), *ContentPath, MaxInFlight);
+
+	//
+	// pipeline: the game thread loads, runs game-thread Blueprints and saves, while the
+	// conversion and operator stages of the other in-flight assets run on the thread pool
+	//
+	TArray<Local::FBulkItemPtr> InFlight;
+	int32 NextAsset = 0, NumSucceeded = 0, NumFailed = 0, SavedSinceGC = 0;
+	int64 InputTriangles = 0, ResultTriangles = 0;
+	double LoadSeconds = 0, GameThreadSeconds = 0, SaveSeconds = 0, WorkerSeconds = 0;
+	double StartTime = FPlatformTime::Seconds();
+	double LastReportTime = StartTime;
+
+	while (NextAsset < Assets.Num() || InFlight.Num() > 0)
+	{
+		bool bDidWork = false;
+
+		for (int32 k = 0; k < InFlight.Num(); ++k)
+		{
+			Local::FBulkItemPtr Item = InFlight[k];
+			Local::EBulkItemStage Stage = Item->Stage;
+			if (Stage == Local::EBulkItemStage::WaitingForGameThread)
+			{
+				double StageStart = FPlatformTime::Seconds();
+				Settings.Preset.Chain.Execute(Item->Mesh, nullptr, Item->TempMesh.Get(), [](TFunctionRef<void()> Work) { Work(); });
+				GameThreadSeconds += FPlatformTime::Seconds() - StageStart;
+				Item->Stage = Local::EBulkItemStage::Converting;
+				Local::LaunchWorkerStage(Item, Settings);
+				bDidWork = true;
+			}
+			else if (Stage == Local::EBulkItemStage::ReadyToSave || Stage == Local::EBulkItemStage::Failed)
+			{
+				double StageStart = FPlatformTime::Seconds();
+				bool bSuccess = (Stage == Local::EBulkItemStage::ReadyToSave) && Local::SaveItem(*Item, bBuild, bSave);
+				SaveSeconds += FPlatformTime::Seconds() - StageStart;
+				WorkerSeconds += Item->WorkerSeconds;
+				if (bSuccess)
+				{
+					NumSucceeded++;
+					InputTriangles += Item->InputTriangles;
+					ResultTriangles += Item->ResultTriangles;
+				}
+				else
+				{
+					NumFailed++;
+					UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingBulk: %s failed: %s"), *Item->AssetData.ObjectPath.ToString(), *Item->Error);
+				}
+				InFlight.RemoveAt(k--);
+				SavedSinceGC++;
+				bDidWork = true;
+			}
+		}
+
+		// Blueprints executing on a worker thread must not run concurrently with garbage collection, so once a
+		// collection is due, no new items are admitted until the ones in flight have drained
+		bool bGarbageCollectDue = (SavedSinceGC >= GarbageCollectInterval);
+		if (NextAsset < Assets.Num() && InFlight.Num() < MaxInFlight && (bGarbageCollectDue == false || bWorkerUsesUObjects == false))
+		{
+			double StageStart = FPlatformTime::Seconds();
+			Local::FBulkItemPtr Item = MakeShared<Local::FBulkItem, ESPMode::ThreadSafe>();
+			Item->AssetData = Assets[NextAsset++];
+			UStaticMesh* StaticMesh = Cast<UStaticMesh>(Item->AssetData.GetAsset());
+			Item->SourceDescription = (StaticMesh != nullptr) ? StaticMesh->GetMeshDescription(0) : nullptr;
+			LoadSeconds += FPlatformTime::Seconds() - StageStart;
+			if (Item->SourceDescription == nullptr)
+			{
+				NumFailed++;
+				UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingBulk: could not load %s"), *Item->AssetData.ObjectPath.ToString());
+			}
+			else
+			{
+				Item->StaticMesh.Reset(StaticMesh);
+				if (bOutOfProcess == false && Settings.Preset.RequiresChainExecution() && Settings.Preset.Chain.RequiresDynamicMeshObject())
+				{
+					Item->TempMesh.Reset(NewObject<UDynamicMesh>());
+				}
+				// the items are processed concurrently, so each needs its own Blueprint instances
+				if (bWorkerUsesUObjects && Settings.Preset.Chain.CanExecuteConcurrently() == false)
+				{
+					Settings.Preset.MakeBlueprintChain(Item->Chain, Item->BlueprintInstances);
+				}
+				InFlight.Add(Item);
+				Local::LaunchWorkerStage(Item, Settings);
+			}
+			bDidWork = true;
+		}
+
+		if (bGarbageCollectDue && (bWorkerUsesUObjects == false || InFlight.Num() == 0))
+		{
+			CollectGarbage(RF_NoFlags);
+			SavedSinceGC = 0;
+		}
+
+		double Now = FPlatformTime::Seconds();
+		if (Now - LastReportTime > 5.0)
+		{
+			int32 NumDone = NumSucceeded + NumFailed;
+			UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: %d of %d assets, %.1f assets/s"), NumDone, Assets.Num(), (double)NumDone / (Now - StartTime));
+			LastReportTime = Now;
+		}
+
+		if (bDidWork == false)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+	}
+
+	double TotalSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, SMALL_NUMBER);
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: %d assets processed, %d failed in %.2fs"), NumSucceeded, NumFailed, TotalSeconds);
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: %.2f assets/s, %.0f input tris/s, %.0f result tris/s"),
+		(double)NumSucceeded / TotalSeconds, (double)InputTriangles / TotalSeconds, (double)ResultTriangles / TotalSeconds);
+	if (bOutOfProcess)
+	{
+		FMeshProcessingWorkerPool::FMetrics Metrics = FMeshProcessingWorkerPool::Get().GetMetrics();
+		UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: %d worker processes started, %lld requests failed, %lld timed out, %lld crashed"),
+			Metrics.NumStarted, Metrics.NumFailed, Metrics.NumTimedOut, Metrics.NumCrashed);
+		FMeshProcessingWorkerPool::Get().Shutdown();
+	}
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingBulk: stage time load %.2fs, game thread Blueprint %.2fs, save %.2fs, worker %.2fs (%.1f cores busy)"),
+		LoadSeconds, GameThreadSeconds, SaveSeconds, WorkerSeconds, WorkerSeconds / TotalSeconds);
+
+	return (NumFailed > 0) ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Commandlets/MeshProcessingWorkerCommandlet.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "Operations/MeshProcessingWorkerPool.h"
+
+
+UMeshProcessingWorkerCommandlet::UMeshProcessingWorkerCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Worker process of the SampleModelingModeExtension out-of-process mesh processing, started by the editor or the bulk commandlet");
+	HelpUsage = TEXT("-run=MeshProcessingWorker -Control=<control region name> [-HostPID=<process ID>]");
+}
+
+
+int32 UMeshProcessingWorkerCommandlet::Main(const FString& Params)
+{
+	FString ControlRegionName;
+	if (FParse::Value(*Params, TEXT("Control="), ControlRegionName) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorker: -Control is required. Usage: %s"), *HelpUsage);
+		return 1;
+	}
+	uint32 HostProcessID = 0;
+	FParse::Value(*Params, TEXT("HostPID="), HostProcessID);
+
+	return FMeshProcessingWorkerPool::RunWorker(ControlRegionName, HostProcessID);
+}
@@ -0,0 +1,479 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshChunkedExecution.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "DynamicMesh/DynamicMeshAABBTree3.h"
+#include "DynamicMeshEditor.h"
+#include "Operations/MergeCoincidentMeshEdges.h"
+#include "Async/ParallelFor.h"
+#include "Util/ProgressCancel.h"
+
+using namespace UE::Geometry;
+
+
+namespace Local
+{
+
+// name of the polygroup layer that carries the input triangle ID of each chunk triangle through the Operations
+static const FName SourceTriangleLayerName(TEXT("ChunkSourceTriangle"));
+
+// A chunk is a cell of the spatial partition, ie the triangles whose centroids are inside the cell
+struct FMeshChunk
+{
+	TArray<int32> OwnedTriangles;
+
+	// per-chunk results
+	FDynamicMesh3 Mesh;
+	FMeshIndexMappings IndexMaps;
+	bool bTopologyPreserved = true;
+	// index of the source triangle layer in the chunk mesh, or InvalidID if the mesh has no attributes to carry it
+	int32 SourceTriangleLayer = IndexConstants::InvalidID;
+};
+
+
+// recursively split Triangles at the centroid median of the longest axis, until NumParts cells have been created
+static void PartitionTriangles(const TArray<FVector3d>& Centroids, TArray<int32>& Triangles, int32 NumParts, TArray<FMeshChunk>& ChunksOut)
+{
+	if (NumParts <= 1 || Triangles.Num() < 2)
+	{
+		if (Triangles.Num() > 0)
+		{
+			FMeshChunk& Chunk = ChunksOut.AddDefaulted_GetRef();
+			Chunk.OwnedTriangles = MoveTemp(Triangles);
+		}
+		return;
+	}
+
+	FAxisAlignedBox3d Bounds = FAxisAlignedBox3d::Empty();
+	for (int32 tid : Triangles)
+	{
+		Bounds.Contain(Centroids[tid]);
+	}
+	FVector3d Diagonal = Bounds.Diagonal();
+	int32 Axis = (Diagonal.X >= Diagonal.Y && Diagonal.X >= Diagonal.Z) ? 0 : ((Diagonal.Y >= Diagonal.Z) ? 1 : 2);
+
+	int32 NumLeftParts = NumParts / 2;
+	Triangles.Sort([&Centroids, Axis](int32 A, int32 B) { return Centroids[A][Axis] < Centroids[B][Axis]; });
+	int32 SplitIndex = (int32)(((int64)Triangles.Num() * (int64)NumLeftParts) / (int64)NumParts);
+	double SplitValue = Centroids[Triangles[SplitIndex]][Axis];
+
+	TArray<int32> LeftTriangles, RightTriangles;
+	for (int32 tid : Triangles)
+	{
+		if (Centroids[tid][Axis] < SplitValue)
+		{
+			LeftTriangles.Add(tid);
+		}
+		else
+		{
+			RightTriangles.Add(tid);
+		}
+	}
+	Triangles.Empty();
+
+	PartitionTriangles(Centroids, LeftTriangles, NumLeftParts, ChunksOut);
+	PartitionTriangles(Centroids, RightTriangles, NumParts - NumLeftParts, ChunksOut);
+}
+
+
+// add the source triangle layer to the chunk mesh, with the input triangle ID of each chunk triangle. Polygroup layers are
+// propagated by the mesh edits (eg splits and collapses), so each output triangle can be traced back to an input triangle.
+static void AddSourceTriangleLayer(FMeshChunk& Chunk, TArrayView<const int32> SourceTriangles)
+{
+	if (Chunk.Mesh.HasAttributes() == false)
+	{
+		return;
+	}
+	FDynamicMeshAttributeSet* Attributes = Chunk.Mesh.Attributes();
+	Chunk.SourceTriangleLayer = Attributes->NumPolygroupLayers();
+	Attributes->SetNumPolygroupLayers(Chunk.SourceTriangleLayer + 1);
+	FDynamicMeshPolygroupAttribute* SourceLayer = Attributes->GetPolygroupLayer(Chunk.SourceTriangleLayer);
+	SourceLayer->SetName(SourceTriangleLayerName);
+	for (int32 SourceTID : SourceTriangles)
+	{
+		SourceLayer->SetValue(Chunk.IndexMaps.GetNewTriangle(SourceTID), SourceTID);
+	}
+}
+
+
+// @return the source triangle layer of the processed chunk mesh, or null if the mesh has none or an Operation has removed it
+static const FDynamicMeshPolygroupAttribute* FindSourceTriangleLayer(const FMeshChunk& Chunk)
+{
+	const FDynamicMeshAttributeSet* Attributes = Chunk.Mesh.Attributes();
+	if (Chunk.SourceTriangleLayer == IndexConstants::InvalidID || Attributes == nullptr || Attributes->NumPolygroupLayers() <= Chunk.SourceTriangleLayer)
+	{
+		return nullptr;
+	}
+	const FDynamicMeshPolygroupAttribute* SourceLayer = Attributes->GetPolygroupLayer(Chunk.SourceTriangleLayer);
+	return (SourceLayer->GetName() == SourceTriangleLayerName) ? SourceLayer : nullptr;
+}
+
+
+// check that Operations did not modify the topology of the chunk mesh
+static bool IsTopologyPreserved(const FDynamicMesh3& Before, const FDynamicMesh3& After)
+{
+	if (Before.MaxVertexID() != After.MaxVertexID() || Before.MaxTriangleID() != After.MaxTriangleID()
+		|| Before.VertexCount() != After.VertexCount() || Before.TriangleCount() != After.TriangleCount())
+	{
+		return false;
+	}
+	for (int32 tid : Before.TriangleIndicesItr())
+	{
+		if (After.IsTriangle(tid) == false || After.GetTriangle(tid) != Before.GetTriangle(tid))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// copy the overlay values of the SourceTID triangle of the Source overlay to the TargetTID triangle of the Target overlay
+template<typename OverlayType>
+static void CopyOverlayTriangle(const OverlayType* Source, int32 SourceTID, OverlayType* Target, int32 TargetTID)
+{
+	if (Source->IsSetTriangle(SourceTID) && Target->IsSetTriangle(TargetTID))
+	{
+		FIndex3i SourceElements = Source->GetTriangle(SourceTID);
+		FIndex3i TargetElements = Target->GetTriangle(TargetTID);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Target->SetElement(TargetElements[j], Source->GetElement(SourceElements[j]));
+		}
+	}
+}
+
+
+// write the vertex and overlay values of the owned region of the Chunk back into the Mesh
+static void WriteBackChunk(const FMeshChunk& Chunk, int32 ChunkIndex, const TArray<int32>& VertexOwner, FDynamicMesh3& Mesh)
+{
+	const FDynamicMesh3& ChunkMesh = Chunk.Mesh;
+	for (int32 BaseTID : Chunk.OwnedTriangles)
+	{
+		int32 ChunkTID = Chunk.IndexMaps.GetNewTriangle(BaseTID);
+
+		FIndex3i BaseTri = Mesh.GetTriangle(BaseTID);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			int32 BaseVID = BaseTri[j];
+			if (VertexOwner[BaseVID] == ChunkIndex)
+			{
+				int32 ChunkVID = Chunk.IndexMaps.GetNewVertex(BaseVID);
+				Mesh.SetVertex(BaseVID, ChunkMesh.GetVertex(ChunkVID));
+				if (Mesh.HasVertexNormals())
+				{
+					Mesh.SetVertexNormal(BaseVID, ChunkMesh.GetVertexNormal(ChunkVID));
+				}
+				if (Mesh.HasVertexColors())
+				{
+					Mesh.SetVertexColor(BaseVID, ChunkMesh.GetVertexColor(ChunkVID));
+				}
+				if (Mesh.HasVertexUVs())
+				{
+					Mesh.SetVertexUV(BaseVID, ChunkMesh.GetVertexUV(ChunkVID));
+				}
+			}
+		}
+
+		if (Mesh.HasAttributes())
+		{
+			FDynamicMeshAttributeSet* Attributes = Mesh.Attributes();
+			const FDynamicMeshAttributeSet* ChunkAttributes = ChunkMesh.Attributes();
+			for (int32 k = 0; k < Attributes->NumUVLayers(); ++k)
+			{
+				CopyOverlayTriangle(ChunkAttributes->GetUVLayer(k), ChunkTID, Attributes->GetUVLayer(k), BaseTID);
+			}
+			for (int32 k = 0; k < Attributes->NumNormalLayers(); ++k)
+			{
+				CopyOverlayTriangle(ChunkAttributes->GetNormalLayer(k), ChunkTID, Attributes->GetNormalLayer(k), BaseTID);
+			}
+			if (Attributes->HasPrimaryColors())
+			{
+				CopyOverlayTriangle(ChunkAttributes->PrimaryColors(), ChunkTID, Attributes->PrimaryColors(), BaseTID);
+			}
+		}
+	}
+}
+
+
+static void InitializeMatchingMesh(FDynamicMesh3& Mesh, const FDynamicMesh3& ToMatch)
+{
+	Mesh.EnableMeshComponents(ToMatch.GetComponentsFlags());
+	if (ToMatch.HasAttributes())
+	{
+		Mesh.EnableMatchingAttributes(ToMatch);
+	}
+}
+
+
+static void Validate(const FMeshProcessingOperationChain& Chain, const FDynamicMesh3& ChunkedResult, FDynamicMesh3& Reference,
+	FProgressCancel* Progress, UDynamicMesh* TempMesh, FMeshChunkedExecutionInfo& Info)
+{
+	Chain.Execute(Reference, Progress, TempMesh, [](TFunctionRef<void()>) { ensure(false); });
+	if (Progress && Progress->Cancelled())
+	{
+		return;
+	}
+
+	Info.bValidated = true;
+	Info.bValidationTopologyMatched = IsTopologyPreserved(Reference, ChunkedResult);
+	Info.ValidationMaxDeviation = 0;
+	if (Info.bValidationTopologyMatched)
+	{
+		for (int32 vid : Reference.VertexIndicesItr())
+		{
+			double Deviation = Distance(Reference.GetVertex(vid), ChunkedResult.GetVertex(vid));
+			Info.ValidationMaxDeviation = FMathd::Max(Info.ValidationMaxDeviation, Deviation);
+		}
+	}
+	else
+	{
+		// topology differs, so measure the one-sided distance from the chunked result to the reference surface
+		FDynamicMeshAABBTree3 Spatial(&Reference);
+		for (int32 vid : ChunkedResult.VertexIndicesItr())
+		{
+			double NearestDistSqr = 0;
+			Spatial.FindNearestTriangle(ChunkedResult.GetVertex(vid), NearestDistSqr);
+			Info.ValidationMaxDeviation = FMathd::Max(Info.ValidationMaxDeviation, FMathd::Sqrt(NearestDistSqr));
+		}
+	}
+
+	UE_LOG(LogSampleModelingModeExtension, Log, TEXT("Chunked execution validation: %d chunks, topology %s whole-mesh result, max deviation %g"),
+		Info.NumChunks, Info.bValidationTopologyMatched ? TEXT("matches") : TEXT("differs from"), Info.ValidationMaxDeviation);
+}
+
+}
+
+
+
+bool FMeshChunkedExecution::CanExecuteChunked(const FMeshProcessingOperationChain& Chain)
+{
+	return Chain.IsEmpty() == false && Chain.IsThreadSafe() && Chain.IsLocal();
+}
+
+
+bool FMeshChunkedExecution::Execute(
+	const FMeshProcessingOperationChain& Chain,
+	FDynamicMesh3& Mesh,
+	const FMeshChunkedExecutionOptions& Options,
+	FProgressCancel* Progress,
+	TArrayView<UDynamicMesh*> ChunkTempMeshes,
+	TArrayView<const FMeshProcessingOperationChain> ChunkChains,
+	FMeshChunkedExecutionInfo* InfoOut)
+{
+	auto IsCancelled = [Progress]() { return Progress != nullptr && Progress->Cancelled(); };
+	// chunked chains are thread-safe, so there is never anything to dispatch to the game thread
+	auto NoGameThreadDispatch = [](TFunctionRef<void()>) { ensure(false); };
+
+	FMeshChunkedExecutionInfo Info;
+	if (!ensure(CanExecuteChunked(Chain)))
+	{
+		return false;
+	}
+	bool bRequiresTempMeshes = Chain.RequiresDynamicMeshObject();
+	// Operations with per-instance state (eg Blueprints) must not be executed by several chunks at once
+	bool bRequiresChunkChains = Chain.CanExecuteConcurrently() == false;
+	if (bRequiresChunkChains && !ensure(ChunkChains.Num() > 0))
+	{
+		return false;
+	}
+	int32 MaxChunks = (bRequiresTempMeshes) ? ChunkTempMeshes.Num() : Options.NumChunks;
+	if (bRequiresChunkChains)
+	{
+		MaxChunks = FMath::Min(MaxChunks, ChunkChains.Num());
+	}
+	int32 NumChunks = FMath::Clamp(Options.NumChunks, 1, FMath::Max(1, MaxChunks));
+
+	// keep a copy of the input for validation
+	TUniquePtr<FDynamicMesh3> ReferenceMesh;
+	if (Options.bValidate)
+	{
+		ReferenceMesh = MakeUnique<FDynamicMesh3>(Mesh);
+	}
+
+	// partition the triangles into spatial chunks
+	TArray<FVector3d> Centroids;
+	Centroids.SetNumUninitialized(Mesh.MaxTriangleID());
+	TArray<int32> AllTriangles;
+	AllTriangles.Reserve(Mesh.TriangleCount());
+	for (int32 tid : Mesh.TriangleIndicesItr())
+	{
+		Centroids[tid] = Mesh.GetTriCentroid(tid);
+		AllTriangles.Add(tid);
+	}
+	TArray<Local::FMeshChunk> Chunks;
+	Local::PartitionTriangles(Centroids, AllTriangles, NumChunks, Chunks);
+	Info.NumChunks = Chunks.Num();
+	if (IsCancelled())
+	{
+		return false;
+	}
+
+	// the halo must cover what the Operations read around the owned region
+	int32 HaloRings = FMath::Max(Options.HaloRings, Chain.GetRequiredHaloRings());
+
+	// extract each chunk plus halo into its own mesh, and execute the chain on it
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+	{
+		if (IsCancelled())
+		{
+			return;
+		}
+		Local::FMeshChunk& Chunk = Chunks[ChunkIndex];
+
+		TBitArray<> InChunk(false, Mesh.MaxTriangleID());
+		TArray<int32> ChunkTriangles = Chunk.OwnedTriangles;
+		for (int32 tid : ChunkTriangles)
+		{
+			InChunk[tid] = true;
+		}
+		TArray<int32> Frontier = ChunkTriangles, NextFrontier;
+		for (int32 Ring = 0; Ring < HaloRings; ++Ring)
+		{
+			NextFrontier.Reset();
+			for (int32 tid : Frontier)
+			{
+				FIndex3i Tri = Mesh.GetTriangle(tid);
+				for (int32 j = 0; j < 3; ++j)
+				{
+					for (int32 RingTID : Mesh.VtxTrianglesItr(Tri[j]))
+					{
+						if (InChunk[RingTID] == false)
+						{
+							InChunk[RingTID] = true;
+							NextFrontier.Add(RingTID);
+							ChunkTriangles.Add(RingTID);
+						}
+					}
+				}
+			}
+			Swap(Frontier, NextFrontier);
+		}
+
+		Local::InitializeMatchingMesh(Chunk.Mesh, Mesh);
+		Chunk.IndexMaps.Initialize(Chunk.Mesh);
+		FDynamicEditResult EditResult;
+		FDynamicMeshEditor Editor(&Chunk.Mesh);
+		Editor.AppendTriangles(&Mesh, ChunkTriangles, Chunk.IndexMaps, EditResult);
+		Local::AddSourceTriangleLayer(Chunk, ChunkTriangles);
+
+		FDynamicMesh3 InputChunkMesh(Chunk.Mesh);
+		UDynamicMesh* TempMesh = (bRequiresTempMeshes) ? ChunkTempMeshes[ChunkIndex] : nullptr;
+		const FMeshProcessingOperationChain& ChunkChain = (bRequiresChunkChains) ? ChunkChains[ChunkIndex] : Chain;
+		ChunkChain.Execute(Chunk.Mesh, Progress, TempMesh, NoGameThreadDispatch);
+
+		Chunk.bTopologyPreserved = Local::IsTopologyPreserved(InputChunkMesh, Chunk.Mesh);
+	});
+	if (IsCancelled())
+	{
+		return false;
+	}
+
+	Info.bTopologyPreserved = true;
+	for (const Local::FMeshChunk& Chunk : Chunks)
+	{
+		Info.bTopologyPreserved = Info.bTopologyPreserved && Chunk.bTopologyPreserved;
+	}
+
+	// the chunks partition the input triangles
+	TArray<int32> TriangleOwner;
+	TriangleOwner.Init(IndexConstants::InvalidID, Mesh.MaxTriangleID());
+	for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+	{
+		for (int32 tid : Chunks[ChunkIndex].OwnedTriangles)
+		{
+			TriangleOwner[tid] = ChunkIndex;
+		}
+	}
+
+	// the output triangles of a chunk can only be assigned to their owner if their source triangles were carried through
+	bool bSourceTrianglesKnown = true;
+	for (const Local::FMeshChunk& Chunk : Chunks)
+	{
+		bSourceTrianglesKnown = bSourceTrianglesKnown && Local::FindSourceTriangleLayer(Chunk) != nullptr;
+	}
+
+	if (Info.bTopologyPreserved)
+	{
+		// each vertex is written back by the chunk that owns the lowest-index triangle in its one-ring
+		TArray<int32> VertexOwner;
+		VertexOwner.Init(IndexConstants::InvalidID, Mesh.MaxVertexID());
+		ParallelFor(Mesh.MaxVertexID(), [&](int32 vid)
+		{
+			if (Mesh.IsVertex(vid))
+			{
+				int32 MinTID = TNumericLimits<int32>::Max();
+				for (int32 tid : Mesh.VtxTrianglesItr(vid))
+				{
+					MinTID = FMath::Min(MinTID, tid);
+				}
+				VertexOwner[vid] = (MinTID < TNumericLimits<int32>::Max()) ? TriangleOwner[MinTID] : IndexConstants::InvalidID;
+			}
+		});
+
+		// chunks share overlay elements along their borders, so write back sequentially
+		for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+		{
+			Local::WriteBackChunk(Chunks[ChunkIndex], ChunkIndex, VertexOwner, Mesh);
+		}
+	}
+	else if (bSourceTrianglesKnown == false)
+	{
+		// eg a mesh without attributes, or an Operation that replaced the mesh. The owned output triangles are unknown, so the
+		// chain is executed on the whole mesh instead, which has not been modified yet.
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("Chunked execution: the Operations changed the topology and did not keep the source triangles, executing on the whole mesh"));
+		UDynamicMesh* TempMesh = (bRequiresTempMeshes) ? ChunkTempMeshes[0] : nullptr;
+		const FMeshProcessingOperationChain& WholeChain = (bRequiresChunkChains) ? ChunkChains[0] : Chain;
+		WholeChain.Execute(Mesh, Progress, TempMesh, NoGameThreadDispatch);
+	}
+	else
+	{
+		// append the output triangles of each chunk whose source triangle it owns to a new mesh, and weld the seams. As the
+		// chunks partition the input triangles, each output triangle is appended exactly once.
+		FDynamicMesh3 CombinedMesh;
+		Local::InitializeMatchingMesh(CombinedMesh, Mesh);
+		FDynamicMeshEditor Editor(&CombinedMesh);
+		for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex)
+		{
+			Local::FMeshChunk& Chunk = Chunks[ChunkIndex];
+			const FDynamicMeshPolygroupAttribute* SourceLayer = Local::FindSourceTriangleLayer(Chunk);
+			TArray<int32> OwnedOutputTriangles;
+			for (int32 tid : Chunk.Mesh.TriangleIndicesItr())
+			{
+				int32 SourceTID = SourceLayer->GetValue(tid);
+				if (TriangleOwner.IsValidIndex(SourceTID) && TriangleOwner[SourceTID] == ChunkIndex)
+				{
+					OwnedOutputTriangles.Add(tid);
+				}
+			}
+			// the source layer (and any layer an Operation added after it) is not part of the combined mesh
+			Chunk.Mesh.Attributes()->SetNumPolygroupLayers(Chunk.SourceTriangleLayer);
+
+			FMeshIndexMappings IndexMaps;
+			IndexMaps.Initialize(CombinedMesh);
+			FDynamicEditResult EditResult;
+			Editor.AppendTriangles(&Chunk.Mesh, OwnedOutputTriangles, IndexMaps, EditResult);
+		}
+
+		FMergeCoincidentMeshEdges Weld(&CombinedMesh);
+		Weld.MergeVertexTolerance = Options.WeldTolerance;
+		Weld.MergeSearchTolerance = 2.0 * Options.WeldTolerance;
+		Weld.Apply();
+
+		Mesh = MoveTemp(CombinedMesh);
+	}
+
+	if (ReferenceMesh.IsValid() && IsCancelled() == false)
+	{
+		UDynamicMesh* TempMesh = (bRequiresTempMeshes) ? ChunkTempMeshes[0] : nullptr;
+		Local::Validate(Chain, Mesh, *ReferenceMesh, Progress, TempMesh, Info);
+	}
+
+	if (InfoOut)
+	{
+		*InfoOut = Info;
+	}
+	return IsCancelled() == false;
+}
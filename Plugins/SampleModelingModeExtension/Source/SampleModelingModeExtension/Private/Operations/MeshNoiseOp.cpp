@@ -0,0 +1,861 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshNoiseOp.h"
+#include "Tools/MeshNoiseTool.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Operations/PNTriangles.h"
+#include "Operations/VertexBatch.h"
+#include "Operations/PerlinNoise.h"
+#include "Operations/TessellationDiskCache.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "Async/ParallelFor.h"
+#include "Util/ProgressCancel.h"
+#include "SampleModelingModeExtensionModule.h"
+
+using namespace UE::Geometry;
+
+#define LOCTEXT_NAMESPACE "MeshNoiseOp"
+
+DECLARE_CYCLE_STAT(TEXT("Noise Tessellate"), STAT_MeshNoiseOp_Tessellate, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Noise Copy Tessellation"), STAT_MeshNoiseOp_CopyTessellation, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Noise Load Tessellation"), STAT_MeshNoiseOp_LoadTessellation, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Noise Displace"), STAT_MeshNoiseOp_Displace, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Noise Normals"), STAT_MeshNoiseOp_Normals, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Noise Mask"), STAT_MeshNoiseOp_Mask, STATGROUP_SampleModelingModeExtension);
+
+
+namespace Local
+{
+
+/**
+ * @return the normal of the surface that is displaced along Normal by a height field with the spatial gradient HeightGradient,
+ * ie the base normal tilted against the tangential part of the gradient
+ */
+static FORCEINLINE FVector3d GetDisplacedNormal(const FVector3d& Normal, const FVector3d& HeightGradient)
+{
+	FVector3d TangentGradient = HeightGradient - HeightGradient.Dot(Normal) * Normal;
+	return Normalized(Normal - TangentGradient);
+}
+
+/**
+ * Recompute the normals of the vertices whose one-ring contains a displaced vertex, ie the displaced vertices and their
+ * neighbours, with the same weighting as FMeshNormals::QuickRecomputeOverlayNormals(). For a mesh with attributes the
+ * normal overlay elements of these vertices are updated, otherwise the vertex normals.
+ */
+static void RecomputeMaskedNormals(FDynamicMesh3& Mesh, const TArray<int32>& DisplacedVertexIDs)
+{
+	FDynamicMeshNormalOverlay* Overlay = (Mesh.HasAttributes()) ? Mesh.Attributes()->PrimaryNormals() : nullptr;
+
+	TBitArray<> InRegion(false, Mesh.MaxVertexID());
+	TArray<int32> VertexIDs;
+	for (int32 vid : DisplacedVertexIDs)
+	{
+		for (int32 nbrvid : Mesh.VtxVerticesItr(vid))
+		{
+			if (InRegion[nbrvid] == false)
+			{
+				InRegion[nbrvid] = true;
+				VertexIDs.Add(nbrvid);
+			}
+		}
+		if (InRegion[vid] == false)
+		{
+			InRegion[vid] = true;
+			VertexIDs.Add(vid);
+		}
+	}
+
+	// each normal element belongs to a single vertex, so the vertices can be updated in parallel
+	ParallelFor(VertexIDs.Num(), [&Mesh, Overlay, &VertexIDs](int32 k)
+	{
+		int32 vid = VertexIDs[k];
+		TArray<TPair<int32, FVector3d>, TInlineAllocator<8>> ElementNormals;
+		FVector3d VertexNormal = FVector3d::Zero();
+		for (int32 tid : Mesh.VtxTrianglesItr(vid))
+		{
+			FVector3d TriNormal, TriCentroid;
+			double TriArea;
+			Mesh.GetTriInfo(tid, TriNormal, TriArea, TriCentroid);
+			int32 Corner = Mesh.GetTriangle(tid).IndexOf(vid);
+			FVector3d Weighted = FMeshNormals::GetVertexWeightsOnTriangle(&Mesh, tid, TriArea, true, true)[Corner] * TriNormal;
+			VertexNormal += Weighted;
+			if (Overlay != nullptr && Overlay->IsSetTriangle(tid))
+			{
+				int32 ElementID = Overlay->GetTriangle(tid)[Corner];
+				TPair<int32, FVector3d>* Found = ElementNormals.FindByPredicate([ElementID](const TPair<int32, FVector3d>& Pair) { return Pair.Key == ElementID; });
+				if (Found != nullptr)
+				{
+					Found->Value += Weighted;
+				}
+				else
+				{
+					ElementNormals.Add(TPair<int32, FVector3d>(ElementID, Weighted));
+				}
+			}
+		}
+
+		if (Overlay != nullptr)
+		{
+			for (const TPair<int32, FVector3d>& Pair : ElementNormals)
+			{
+				Overlay->SetElement(Pair.Key, (FVector3f)Normalized(Pair.Value));
+			}
+		}
+		else
+		{
+			Mesh.SetVertexNormal(vid, (FVector3f)Normalized(VertexNormal));
+		}
+	});
+}
+
+}
+
+
+void FMeshNoiseOp::CalculateResult(FProgressCancel* Progress)
+{
+	ResultInfo = FGeometryResult();
+
+	bool bReuseTessellation = CanReuseTessellation();
+	if (bReuseTessellation)
+	{
+		// the tessellation of an earlier operator is copied, so only the displacement is computed
+		if (CheckStageCancelled(Progress))
+		{
+			return;
+		}
+		{
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_CopyTessellation);
+			FScopedStage Stage(*this, TEXT("CopyTessellation"));
+			ResultMesh->Copy(*Tessellation.Mesh);
+		}
+		UpdateTrackedMemory();
+	}
+	// the tessellation is loaded directly into the output mesh, without the copy of the input mesh
+	else if (UseTessellationDiskCache() && LoadCachedTessellation(Progress))
+	{
+		bReuseTessellation = true;
+	}
+	// copy the shared input mesh into the output mesh, here rather than on the game thread
+	else if (CopyInputMesh(Progress) == false)
+	{
+		return;
+	}
+
+	ComputeFromResultMesh(bReuseTessellation, Progress);
+}
+
+
+bool FMeshNoiseOp::ApplyToMesh(FDynamicMesh3& Mesh, const FOptions& Options, FProgressCancel* Progress)
+{
+	FMeshNoiseOp Op(Options);
+	if (Options.Subdivisions <= 0)
+	{
+		// only the normals array is used, so it stays valid when the mesh is moved into the operator below
+		TSharedPtr<FMeshNormals, ESPMode::ThreadSafe> VertexNormals = MakeShared<FMeshNormals, ESPMode::ThreadSafe>(&Mesh);
+		VertexNormals->ComputeVertexNormals();
+		Op.BaseMeshNormals = VertexNormals;
+	}
+
+	// the mesh is moved in and out of the operator rather than copied
+	*Op.ResultMesh = MoveTemp(Mesh);
+	Op.ComputeFromResultMesh(false, Progress);
+	Mesh = MoveTemp(*Op.ResultMesh);
+	return Op.ResultInfo.Result == EGeometryResultType::Success;
+}
+
+
+void FMeshNoiseOp::ComputeFromResultMesh(bool bReuseTessellation, FProgressCancel* Progress)
+{
+	FMeshNormals SubdividedMeshNormals;
+	// the normals of a kept tessellation are moved out of SubdividedMeshNormals rather than copied
+	TSharedPtr<const TArray<FVector3d>, ESPMode::ThreadSafe> KeptNormals;
+	bool bTessellated = false;
+
+	// If subdivisions were requested, compute it, unless an earlier tessellation is reused
+	if (UseOptions.Subdivisions > 0 && bReuseTessellation == false)
+	{
+		{
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_Tessellate);
+			FScopedStage Stage(*this, TEXT("Tessellate"));
+			FPNTriangles PNTriangles(ResultMesh.Get());
+			PNTriangles.TessellationLevel = UseOptions.Subdivisions;
+			PNTriangles.Progress = Progress;
+			bTessellated = (PNTriangles.Validate() == EOperationValidationResult::Ok);
+			if (bTessellated)
+			{
+				PNTriangles.Compute();
+			}
+		}
+
+		UpdateTrackedMemory();
+
+		// once we have subdivided, we will need to recompute vertex normals on the base mesh...
+		if (CheckStageCancelled(Progress) == false)
+		{
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_Normals);
+			FScopedStage Stage(*this, TEXT("TessellatedNormals"));
+			SubdividedMeshNormals = FMeshNormals(ResultMesh.Get());
+			SubdividedMeshNormals.ComputeVertexNormals();
+			UpdateTrackedMemory((uint64)SubdividedMeshNormals.GetNormals().Num() * sizeof(FVector3d));
+		}
+
+		// the kept tessellation is shared with the caller, and not modified by the displacement below.
+		// It is also shared with the write to the disk cache, which must not see the displacement either.
+		bool bStoreTessellation = bTessellated && InputMeshHash != 0 && UseTessellationDiskCache();
+		if ((UseOptions.bKeepTessellation || bStoreTessellation) && CheckStageCancelled(Progress) == false)
+		{
+			FScopedStage Stage(*this, TEXT("KeepTessellation"));
+			Tessellation.Subdivisions = UseOptions.Subdivisions;
+			Tessellation.Mesh = MakeShared<const FDynamicMesh3, ESPMode::ThreadSafe>(*ResultMesh);
+			KeptNormals = MakeShared<const TArray<FVector3d>, ESPMode::ThreadSafe>(MoveTemp(SubdividedMeshNormals.GetNormals()));
+			Tessellation.VertexNormals = KeptNormals;
+			UpdateTrackedMemory(EstimateMeshMemory(*Tessellation.Mesh) + (uint64)KeptNormals->Num() * sizeof(FVector3d));
+
+			if (bStoreTessellation)
+			{
+				FTessellationDiskCache::Get().StoreAsync(InputMeshHash, UseOptions.Subdivisions, Tessellation.Mesh, Tessellation.VertexNormals);
+				if (UseOptions.bKeepTessellation == false)
+				{
+					// the write keeps its own references
+					Tessellation = FTessellation();
+				}
+			}
+		}
+	}
+
+	// abort if we were cancelled or superseded
+	if (CheckStageCancelled(Progress))
+	{
+		return;
+	}
+
+	// the mask is computed on the (tessellated) mesh that is displaced
+	FVertexMask Mask;
+	bool bMasked = IsMasked();
+	if (bMasked)
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_Mask);
+		FScopedStage Stage(*this, TEXT("Mask"));
+		ComputeMask(Mask);
+		UpdateTrackedMemory((uint64)Mask.Weights.GetAllocatedSize() + (uint64)Mask.VertexIDs.GetAllocatedSize());
+		if (CheckStageCancelled(Progress))
+		{
+			return;
+		}
+	}
+
+	// the analytic normals are written by the displacement kernel, and copied into the mesh normals below
+	FDisplacedNormals DisplacedNormals;
+	bool bAnalyticNormals = CanUseAnalyticNormals();
+	if (bAnalyticNormals)
+	{
+		InitializeDisplacedNormals(DisplacedNormals);
+	}
+
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_Displace);
+		FScopedStage Stage(*this, TEXT("Displace"));
+		const TArray<FVector3d>& VertexNormals = (UseOptions.Subdivisions <= 0) ? BaseMeshNormals->GetNormals() :
+			(bReuseTessellation) ? *Tessellation.VertexNormals : (KeptNormals.IsValid()) ? *KeptNormals : SubdividedMeshNormals.GetNormals();
+		const FVertexMask* UseMask = (bMasked) ? &Mask : nullptr;
+		FDisplacedNormals* UseNormals = (bAnalyticNormals) ? &DisplacedNormals : nullptr;
+		bool bCompleted = (UseOptions.bBatchedDisplacement == false) ? DisplaceIndexed(VertexNormals, UseMask, UseNormals, Progress) :
+			(UseOptions.bSinglePrecision) ? DisplaceBatched<float>(VertexNormals, UseMask, UseNormals, Progress) : DisplaceBatched<double>(VertexNormals, UseMask, UseNormals, Progress);
+		if (bCompleted == false)
+		{
+			return;
+		}
+	}
+
+	// recalculate normals
+	if (CheckStageCancelled(Progress))
+	{
+		return;
+	}
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_Normals);
+		FScopedStage Stage(*this, TEXT("Normals"));
+		if (bAnalyticNormals && SetAnalyticNormals(DisplacedNormals) == false)
+		{
+			ResultMesh->Clear();
+			ResultInfo.AddError(FGeometryError(0, LOCTEXT("ScratchFileMapFailed", "could not map the normals scratch file")));
+			ResultInfo.SetSuccess(false, Progress);
+			return;
+		}
+		else if (bMasked && (ResultMesh->HasAttributes() || ResultMesh->HasVertexNormals()))
+		{
+			Local::RecomputeMaskedNormals(*ResultMesh, Mask.VertexIDs);
+		}
+		else if (ResultMesh->HasAttributes())
+		{
+			FMeshNormals::QuickRecomputeOverlayNormals(*ResultMesh);
+		}
+		else
+		{
+			FMeshNormals::QuickComputeVertexNormals(*ResultMesh);
+		}
+	}
+
+	// the subdivided normals are released when this function returns
+	UpdateTrackedMemory();
+
+	ResultInfo.SetSuccess(true, Progress);
+}
+
+
+bool FMeshNoiseOp::DisplaceIndexed(const TArray<FVector3d>& VertexNormals, const FVertexMask* Mask, FDisplacedNormals* DisplacedNormals, FProgressCancel* Progress)
+{
+	// create stream for randomization
+	FRandomStream Stream(UseOptions.RandomSeed);
+
+	// Loop over vertices and update positions in-place. Masked displacements are scaled by the mask weight.
+	auto DisplaceVertex = [this, &VertexNormals, &Stream, DisplacedNormals](int32 vid, double Weight)
+	{
+		FVector3d Position = ResultMesh->GetVertex(vid);
+		FVector3d Normal = Weight * VertexNormals[vid];
+
+		FVector3d NewPosition = Position;
+		if (UseOptions.NoiseType == EMeshNoiseToolNoiseType::Random)
+		{
+			double RandomAlpha = Stream.GetFraction();
+			NewPosition = Position + (UseOptions.Magnitude * RandomAlpha * Normal);
+		}
+		else
+		{
+			// Frequency is manipulated here to provide a nicer range for the slider. This is scale-dependent, though!
+			double Scale = FMathd::Pow(UseOptions.Frequency * 0.1, 2.0);
+			FVector3d NoiseGradient;
+			double NoiseValue = (DisplacedNormals != nullptr) ? FPerlinNoise::EvaluateWithGradient(Scale * Position, NoiseGradient) : FPerlinNoise::Evaluate(Scale * Position);
+			NewPosition = Position + (UseOptions.Magnitude * NoiseValue * Normal);
+			if (DisplacedNormals != nullptr)
+			{
+				(*DisplacedNormals)[vid] = (FVector3f)Local::GetDisplacedNormal(VertexNormals[vid], (Weight * UseOptions.Magnitude * Scale) * NoiseGradient);
+			}
+		}
+		
+		ResultMesh->SetVertex(vid, NewPosition);
+	};
+
+	int32 Count = 0;
+	if (Mask != nullptr)
+	{
+		for (int32 vid : Mask->VertexIDs)
+		{
+			DisplaceVertex(vid, (double)Mask->Weights[vid]);
+			// don't check for cancel every iteration because it is somewhat expensive
+			if (++Count % 1000 == 0 && CheckStageCancelled(Progress))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	for (int32 vid : ResultMesh->VertexIndicesItr())
+	{
+		DisplaceVertex(vid, 1.0);
+		if ( vid % 1000 == 0 && CheckStageCancelled(Progress))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+template<typename RealType>
+int32 FMeshNoiseOp::GetBatchVertexIDs(int32 MaxVertexID, bool bNormalsWindow) const
+{
+	uint64 BytesPerVertex = TVertexBatch<RealType>::EstimateMemory(1, true) + sizeof(RealType) + ((bNormalsWindow) ? sizeof(FVector3f) : 0);
+	if (UseOptions.BatchMemoryBudget == 0 || BytesPerVertex * (uint64)MaxVertexID <= UseOptions.BatchMemoryBudget)
+	{
+		return MaxVertexID;
+	}
+	// chunks are at least a few ParallelExecute() blocks, so that each chunk is still displaced in parallel
+	uint64 ChunkVertexIDs = FMath::Max(UseOptions.BatchMemoryBudget / BytesPerVertex, (uint64)(4 * TVertexBatch<RealType>().BlockSize));
+	return (int32)FMath::Min(ChunkVertexIDs, (uint64)MaxVertexID);
+}
+
+
+template<typename RealType>
+bool FMeshNoiseOp::DisplaceBatched(const TArray<FVector3d>& VertexNormals, const FVertexMask* Mask, FDisplacedNormals* DisplacedNormals, FProgressCancel* Progress)
+{
+	// single-precision positions are relative to the bounds center, to keep precision for meshes far from the world origin
+	FVector3d Origin = (TIsSame<RealType, float>::Value) ? ResultMesh->GetBounds().Center() : FVector3d::Zero();
+
+	// the random stream is sequential, in the same vertex order as the indexed path, over all the chunks
+	FRandomStream Stream(UseOptions.RandomSeed);
+	RealType Scale = (RealType)FMathd::Pow(UseOptions.Frequency * 0.1, 2.0);
+	FVector3d ScaledOrigin = (double)Scale * Origin;
+	double Magnitude = UseOptions.Magnitude;
+
+	// the vertices are displaced in chunks of vertex IDs if the batch would exceed the memory budget. Each vertex is
+	// computed the same way in either case, so the result does not depend on the chunk size. Masked operators
+	// only gather the masked vertices, in chunks of the masked vertex list.
+	int32 NumToDisplace = (Mask != nullptr) ? Mask->VertexIDs.Num() : ResultMesh->MaxVertexID();
+	bool bNormalsWindow = (DisplacedNormals != nullptr && DisplacedNormals->ScratchFile.IsValid());
+	int32 ChunkVertexIDs = FMath::Max(1, GetBatchVertexIDs<RealType>(NumToDisplace, bNormalsWindow));
+
+	TVertexBatch<RealType> Batch;
+	TArray<RealType> Displacement;
+	for (int32 ChunkStart = 0; ChunkStart < NumToDisplace; ChunkStart += ChunkVertexIDs)
+	{
+		if (Mask != nullptr)
+		{
+			TArrayView<const int32> ChunkIDs = MakeArrayView(Mask->VertexIDs).Slice(ChunkStart, FMath::Min(ChunkVertexIDs, NumToDisplace - ChunkStart));
+			Batch.Gather(*ResultMesh, &VertexNormals, Origin, ChunkIDs);
+		}
+		else
+		{
+			Batch.Gather(*ResultMesh, &VertexNormals, Origin, ChunkStart, ChunkStart + ChunkVertexIDs);
+			// the analytic normals are only computed without a mask, so the chunk is a range of vertex IDs
+			if (DisplacedNormals != nullptr && DisplacedNormals->MapWindow(ChunkStart, FMath::Min(ChunkStart + ChunkVertexIDs, NumToDisplace)) == false)
+			{
+				ResultMesh->Clear();
+				ResultInfo.AddError(FGeometryError(0, LOCTEXT("ScratchFileMapFailed", "could not map the normals scratch file")));
+				ResultInfo.SetSuccess(false, Progress);
+				return false;
+			}
+		}
+		UpdateTrackedMemory(TVertexBatch<RealType>::EstimateMemory(Batch.Num(), true) + (uint64)Batch.Num() * sizeof(RealType));
+
+		// the kernel only computes a scalar displacement per vertex, which is applied along the normal below
+		Displacement.SetNumUninitialized(Batch.Num());
+		if (UseOptions.NoiseType == EMeshNoiseToolNoiseType::Random)
+		{
+			for (int32 Index = 0; Index < Batch.Num(); ++Index)
+			{
+				Displacement[Index] = (RealType)(UseOptions.Magnitude * Stream.GetFraction());
+			}
+		}
+		else
+		{
+			// the noise is evaluated at the absolute position, ie the scaled origin is added back. The gradient of the
+			// displacement height Magnitude * Noise(Scale * p) is Magnitude * Scale * Gradient(Scale * p).
+			double GradientScale = Magnitude * (double)Scale;
+			bool bCompleted = Batch.ParallelExecute([&Batch, &Displacement, DisplacedNormals, Scale, ScaledOrigin, Magnitude, GradientScale](int32 StartIndex, int32 EndIndex)
+			{
+				for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+				{
+					FVector3d Position(
+						ScaledOrigin.X + (double)(Scale * Batch.PositionX[Index]),
+						ScaledOrigin.Y + (double)(Scale * Batch.PositionY[Index]),
+						ScaledOrigin.Z + (double)(Scale * Batch.PositionZ[Index]));
+					if (DisplacedNormals != nullptr)
+					{
+						FVector3d NoiseGradient;
+						Displacement[Index] = (RealType)(Magnitude * FPerlinNoise::EvaluateWithGradient(Position, NoiseGradient));
+						FVector3d Normal((double)Batch.NormalX[Index], (double)Batch.NormalY[Index], (double)Batch.NormalZ[Index]);
+						(*DisplacedNormals)[Batch.VertexIDs[Index]] = (FVector3f)Local::GetDisplacedNormal(Normal, GradientScale * NoiseGradient);
+					}
+					else
+					{
+						Displacement[Index] = (RealType)(Magnitude * FPerlinNoise::Evaluate(Position));
+					}
+				}
+			}, [this, Progress]() { return IsSuperseded() || (Progress != nullptr && Progress->Cancelled()); });
+			if (bCompleted == false)
+			{
+				CheckStageCancelled(Progress);
+				return false;
+			}
+		}
+
+		if (Mask != nullptr)
+		{
+			for (int32 Index = 0; Index < Batch.Num(); ++Index)
+			{
+				Displacement[Index] *= (RealType)Mask->Weights[Batch.VertexIDs[Index]];
+			}
+		}
+
+		Batch.ParallelExecute([&Batch, &Displacement](int32 StartIndex, int32 EndIndex)
+		{
+			RealType* RESTRICT PositionX = Batch.PositionX.GetData();
+			RealType* RESTRICT PositionY = Batch.PositionY.GetData();
+			RealType* RESTRICT PositionZ = Batch.PositionZ.GetData();
+			const RealType* RESTRICT NormalX = Batch.NormalX.GetData();
+			const RealType* RESTRICT NormalY = Batch.NormalY.GetData();
+			const RealType* RESTRICT NormalZ = Batch.NormalZ.GetData();
+			const RealType* RESTRICT Scalar = Displacement.GetData();
+			for (int32 Index = StartIndex; Index < EndIndex; ++Index)
+			{
+				PositionX[Index] += Scalar[Index] * NormalX[Index];
+				PositionY[Index] += Scalar[Index] * NormalY[Index];
+				PositionZ[Index] += Scalar[Index] * NormalZ[Index];
+			}
+		});
+
+		if (CheckStageCancelled(Progress))
+		{
+			return false;
+		}
+		Batch.Scatter(*ResultMesh);
+	}
+	return true;
+}
+
+
+uint64 FMeshNoiseOp::EstimateBatchMemory(int64 NumVertices) const
+{
+	if (UseOptions.bBatchedDisplacement == false)
+	{
+		return 0;
+	}
+	// the displacement batch holds positions, normals and the scalar displacement of each vertex
+	uint64 BatchBytes = (UseOptions.bSinglePrecision) ?
+		TVertexBatch<float>::EstimateMemory(NumVertices, true) + (uint64)NumVertices * sizeof(float) :
+		TVertexBatch<double>::EstimateMemory(NumVertices, true) + (uint64)NumVertices * sizeof(double);
+	return (UseOptions.BatchMemoryBudget > 0) ? FMath::Min(BatchBytes, UseOptions.BatchMemoryBudget) : BatchBytes;
+}
+
+
+bool FMeshNoiseOp::IsMasked() const
+{
+	return UseOptions.Mask.Type != EMeshNoiseToolMaskType::None;
+}
+
+
+void FMeshNoiseOp::ComputeMask(FVertexMask& Mask) const
+{
+	const FMaskOptions& Options = UseOptions.Mask;
+	const FDynamicMesh3& Mesh = *ResultMesh;
+	int32 MaxVertexID = Mesh.MaxVertexID();
+	Mask.Weights.Init(0.0f, MaxVertexID);
+
+	// a mesh without the masking attribute has no masked vertices
+	const FDynamicMeshWeightAttribute* WeightLayer = (Options.Type == EMeshNoiseToolMaskType::WeightLayer && Mesh.HasAttributes()
+		&& Options.WeightLayer < Mesh.Attributes()->NumWeightLayers()) ? Mesh.Attributes()->GetWeightLayer(Options.WeightLayer) : nullptr;
+	bool bGroups = Options.Type == EMeshNoiseToolMaskType::PolyGroup && Mesh.HasTriangleGroups();
+
+	ParallelFor(MaxVertexID, [&](int32 vid)
+	{
+		if (Mesh.IsVertex(vid) == false)
+		{
+			return;
+		}
+		float Weight = 0;
+		if (Options.Type == EMeshNoiseToolMaskType::Volume)
+		{
+			FVector3d BoxPosition = Options.VolumeTransform.InverseTransformPosition(ResultTransform.TransformPosition(Mesh.GetVertex(vid)));
+			FVector3d Outside(
+				FMathd::Max(FMathd::Abs(BoxPosition.X) - Options.VolumeExtents.X, 0.0),
+				FMathd::Max(FMathd::Abs(BoxPosition.Y) - Options.VolumeExtents.Y, 0.0),
+				FMathd::Max(FMathd::Abs(BoxPosition.Z) - Options.VolumeExtents.Z, 0.0));
+			double Distance = Outside.Length();
+			Weight = (Distance == 0) ? 1.0f : (Options.VolumeFalloff > 0) ? (float)FMathd::Max(0.0, 1.0 - Distance / Options.VolumeFalloff) : 0.0f;
+		}
+		else if (WeightLayer != nullptr)
+		{
+			WeightLayer->GetValue(vid, &Weight);
+			Weight = FMath::Clamp(Weight, 0.0f, 1.0f);
+		}
+		else if (bGroups)
+		{
+			for (int32 tid : Mesh.VtxTrianglesItr(vid))
+			{
+				if (Mesh.GetTriangleGroup(tid) == Options.PolyGroupID)
+				{
+					Weight = 1.0f;
+					break;
+				}
+			}
+		}
+		Mask.Weights[vid] = Weight;
+	});
+
+	for (int32 vid = 0; vid < MaxVertexID; ++vid)
+	{
+		if (Mask.Weights[vid] > 0)
+		{
+			Mask.VertexIDs.Add(vid);
+		}
+	}
+
+	// grow the mask by BlendRings rings of vertices, fading linearly to zero. Only the vertices added by the previous
+	// ring are expanded, so this scales with the size of the masked region.
+	int32 NumRings = FMath::Max(0, Options.BlendRings);
+	TArray<int32> Front = Mask.VertexIDs;
+	TArray<int32> NextFront;
+	for (int32 Ring = 1; Ring <= NumRings && Front.Num() > 0; ++Ring)
+	{
+		float RingScale = (float)(NumRings + 1 - Ring) / (float)(NumRings + 2 - Ring);
+		NextFront.Reset();
+		for (int32 vid : Front)
+		{
+			for (int32 nbrvid : Mesh.VtxVerticesItr(vid))
+			{
+				if (Mask.Weights[nbrvid] == 0)
+				{
+					NextFront.Add(nbrvid);
+				}
+			}
+		}
+		// vertices of the new ring take the largest weight of their neighbours in the previous ring
+		for (int32 vid : NextFront)
+		{
+			if (Mask.Weights[vid] > 0)
+			{
+				continue;
+			}
+			float RingWeight = 0;
+			for (int32 nbrvid : Mesh.VtxVerticesItr(vid))
+			{
+				RingWeight = FMath::Max(RingWeight, Mask.Weights[nbrvid]);
+			}
+			Mask.Weights[vid] = -RingWeight * RingScale;
+		}
+		// weights of the current ring are negative until the ring is complete, so that they are not used as sources above
+		Front.Reset();
+		for (int32 vid : NextFront)
+		{
+			if (Mask.Weights[vid] < 0)
+			{
+				Mask.Weights[vid] = -Mask.Weights[vid];
+				Front.Add(vid);
+				Mask.VertexIDs.Add(vid);
+			}
+		}
+	}
+
+	// the displacement gathers the vertices in increasing ID order
+	Mask.VertexIDs.Sort();
+}
+
+
+uint64 FMeshNoiseOp::EstimateMaskMemory(int64 NumVertices) const
+{
+	// per-vertex weights, and the masked vertex IDs which are at most all of the vertices
+	return (IsMasked()) ? (uint64)NumVertices * (sizeof(float) + sizeof(int32)) : 0;
+}
+
+
+bool FMeshNoiseOp::CanUseAnalyticNormals() const
+{
+	if (UseOptions.bAnalyticNormals == false || UseOptions.NoiseType != EMeshNoiseToolNoiseType::Perlin || IsMasked())
+	{
+		return false;
+	}
+	if (ResultMesh->HasAttributes())
+	{
+		// at most one element per vertex, ie no split normals that would each need their own displaced normal. Comparing the
+		// element and vertex counts is not enough, a vertex without an element would hide a split vertex.
+		const FDynamicMeshNormalOverlay* Overlay = ResultMesh->Attributes()->PrimaryNormals();
+		if (Overlay == nullptr)
+		{
+			return false;
+		}
+		TBitArray<> HasElement(false, ResultMesh->MaxVertexID());
+		for (int32 ElementID : Overlay->ElementIndicesItr())
+		{
+			int32 ParentVID = Overlay->GetParentVertex(ElementID);
+			if (HasElement[ParentVID])
+			{
+				return false;
+			}
+			HasElement[ParentVID] = true;
+		}
+		return true;
+	}
+	return ResultMesh->HasVertexNormals();
+}
+
+
+uint64 FMeshNoiseOp::EstimateAnalyticNormalsMemory(int64 NumVertices) const
+{
+	// this does not know whether the mesh has split normals, so it assumes that it does not
+	bool bAnalyticNormals = UseOptions.bAnalyticNormals && UseOptions.NoiseType == EMeshNoiseToolNoiseType::Perlin && IsMasked() == false;
+	if (bAnalyticNormals && UseNormalsScratchFile(NumVertices))
+	{
+		// only the window of a chunk is resident
+		int32 MaxVertexID = (int32)FMath::Min(NumVertices, (int64)MAX_int32);
+		return (uint64)((UseOptions.bSinglePrecision) ? GetBatchVertexIDs<float>(MaxVertexID, true) : GetBatchVertexIDs<double>(MaxVertexID, true)) * sizeof(FVector3f);
+	}
+	return (bAnalyticNormals) ? (uint64)NumVertices * sizeof(FVector3f) : 0;
+}
+
+
+bool FMeshNoiseOp::UseNormalsScratchFile(int64 NumVertices) const
+{
+	if (UseOptions.ScratchFileDirectory.IsEmpty() || UseOptions.bBatchedDisplacement == false || UseOptions.BatchMemoryBudget == 0)
+	{
+		return false;
+	}
+	return EstimateBatchMemory(NumVertices) + (uint64)NumVertices * sizeof(FVector3f) > UseOptions.BatchMemoryBudget;
+}
+
+
+void FMeshNoiseOp::InitializeDisplacedNormals(FDisplacedNormals& DisplacedNormals)
+{
+	int32 MaxVertexID = ResultMesh->MaxVertexID();
+	if (UseNormalsScratchFile(MaxVertexID))
+	{
+		// the windows are the displacement chunks, so each chunk maps its own range once
+		DisplacedNormals.WindowVertexIDs = FMath::Max(1, (UseOptions.bSinglePrecision) ? GetBatchVertexIDs<float>(MaxVertexID, true) : GetBatchVertexIDs<double>(MaxVertexID, true));
+		DisplacedNormals.ScratchFile = MakeUnique<FScratchFile>();
+		if (DisplacedNormals.ScratchFile->Create(UseOptions.ScratchFileDirectory, (uint64)MaxVertexID * sizeof(FVector3f)))
+		{
+			UpdateTrackedMemory((uint64)DisplacedNormals.WindowVertexIDs * sizeof(FVector3f));
+			return;
+		}
+		DisplacedNormals.ScratchFile.Reset();
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshNoiseOp: no scratch file, keeping the normals of %d vertices in memory"), MaxVertexID);
+	}
+	DisplacedNormals.Normals.SetNumUninitialized(MaxVertexID);
+	DisplacedNormals.Window = MakeArrayView(DisplacedNormals.Normals);
+	DisplacedNormals.WindowStart = 0;
+	DisplacedNormals.WindowVertexIDs = FMath::Max(1, MaxVertexID);
+	UpdateTrackedMemory((uint64)DisplacedNormals.Normals.GetAllocatedSize());
+}
+
+
+bool FMeshNoiseOp::FDisplacedNormals::MapWindow(int32 StartVertexID, int32 EndVertexID)
+{
+	if (ScratchFile.IsValid() == false || (StartVertexID == WindowStart && EndVertexID - StartVertexID == Window.Num()))
+	{
+		return true;
+	}
+	Window = ScratchFile->MapElements<FVector3f>(StartVertexID, EndVertexID - StartVertexID);
+	WindowStart = StartVertexID;
+	return Window.Num() == EndVertexID - StartVertexID;
+}
+
+
+bool FMeshNoiseOp::SetAnalyticNormals(FDisplacedNormals& DisplacedNormals)
+{
+	// one pass for the in-memory normals, one per window for the scratch file, in which case the overlay elements are
+	// visited once per window, which is cheap compared to faulting in the normals at random
+	int32 MaxVertexID = ResultMesh->MaxVertexID();
+	for (int32 WindowStart = 0; WindowStart < MaxVertexID; WindowStart += DisplacedNormals.WindowVertexIDs)
+	{
+		int32 WindowEnd = FMath::Min(WindowStart + DisplacedNormals.WindowVertexIDs, MaxVertexID);
+		if (DisplacedNormals.MapWindow(WindowStart, WindowEnd) == false)
+		{
+			return false;
+		}
+		if (ResultMesh->HasAttributes())
+		{
+			FDynamicMeshNormalOverlay* Overlay = ResultMesh->Attributes()->PrimaryNormals();
+			for (int32 ElementID : Overlay->ElementIndicesItr())
+			{
+				int32 ParentVID = Overlay->GetParentVertex(ElementID);
+				if (ParentVID >= WindowStart && ParentVID < WindowEnd)
+				{
+					Overlay->SetElement(ElementID, DisplacedNormals[ParentVID]);
+				}
+			}
+		}
+		else
+		{
+			for (int32 vid = WindowStart; vid < WindowEnd; ++vid)
+			{
+				if (ResultMesh->IsVertex(vid))
+				{
+					ResultMesh->SetVertexNormal(vid, DisplacedNormals[vid]);
+				}
+			}
+		}
+	}
+	if (DisplacedNormals.ScratchFile.IsValid())
+	{
+		DisplacedNormals.ScratchFile->UnmapWindow();
+	}
+	return true;
+}
+
+
+bool FMeshNoiseOp::CanReuseTessellation() const
+{
+	return UseOptions.Subdivisions > 0 && Tessellation.Subdivisions == UseOptions.Subdivisions
+		&& Tessellation.Mesh.IsValid() && Tessellation.VertexNormals.IsValid();
+}
+
+
+bool FMeshNoiseOp::UseTessellationDiskCache() const
+{
+	return UseOptions.bTessellationDiskCache && UseOptions.Subdivisions > 0 && InputMesh.IsValid()
+		&& FTessellationDiskCache::IsWorthCaching(InputMesh->TriangleCount(), UseOptions.Subdivisions);
+}
+
+
+bool FMeshNoiseOp::LoadCachedTessellation(FProgressCancel* Progress)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshNoiseOp_LoadTessellation);
+	FScopedStage Stage(*this, TEXT("LoadTessellation"));
+
+	if (InputMeshHash == 0)
+	{
+		InputMeshHash = FTessellationDiskCache::HashMesh(*InputMesh);
+	}
+	if (CheckStageCancelled(Progress))
+	{
+		return false;
+	}
+
+	TSharedPtr<TArray<FVector3d>, ESPMode::ThreadSafe> VertexNormals = MakeShared<TArray<FVector3d>, ESPMode::ThreadSafe>();
+	if (FTessellationDiskCache::Get().Load(InputMeshHash, UseOptions.Subdivisions, *ResultMesh, *VertexNormals) == false)
+	{
+		return false;
+	}
+	UpdateTrackedMemory((uint64)VertexNormals->GetAllocatedSize());
+
+	// the displacement reads the normals from Tessellation, the mesh is only kept if requested
+	Tessellation.Subdivisions = UseOptions.Subdivisions;
+	Tessellation.VertexNormals = VertexNormals;
+	Tessellation.Mesh.Reset();
+	if (UseOptions.bKeepTessellation)
+	{
+		Tessellation.Mesh = MakeShared<const FDynamicMesh3, ESPMode::ThreadSafe>(*ResultMesh);
+	}
+	UpdateTrackedMemory();
+	return true;
+}
+
+
+uint64 FMeshNoiseOp::EstimatePeakMemory() const
+{
+	if (InputMesh.IsValid() == false)
+	{
+		return 0;
+	}
+
+	if (CanReuseTessellation())
+	{
+		// only the copy of the tessellation is allocated
+		return EstimateMeshMemory(*Tessellation.Mesh) + EstimateBatchMemory(Tessellation.Mesh->VertexCount()) + EstimateMaskMemory(Tessellation.Mesh->MaxVertexID())
+			+ EstimateAnalyticNormalsMemory(Tessellation.Mesh->MaxVertexID());
+	}
+
+	uint64 CopyBytes = EstimateMeshMemory(*InputMesh);
+	if (UseOptions.Subdivisions <= 0)
+	{
+		return CopyBytes + EstimateBatchMemory(InputMesh->VertexCount()) + EstimateMaskMemory(InputMesh->MaxVertexID())
+			+ EstimateAnalyticNormalsMemory(InputMesh->MaxVertexID());
+	}
+
+	// PN tessellation at level N splits each triangle into (N+1)^2 triangles, with about half as many vertices.
+	// The tessellation is built alongside the input copy, and the vertex normals are computed for the result.
+	int64 Factor = (int64)(UseOptions.Subdivisions + 1) * (int64)(UseOptions.Subdivisions + 1);
+	int64 NumTriangles = (int64)InputMesh->TriangleCount() * Factor;
+	int64 NumVertices = (int64)InputMesh->VertexCount() + NumTriangles / 2;
+	uint64 TessellatedBytes = EstimateMeshMemory(NumVertices, NumTriangles, InputMesh->HasAttributes());
+	uint64 NormalsBytes = (uint64)NumVertices * sizeof(FVector3d);
+	// a kept tessellation is a second copy of the tessellated mesh, as is a tessellation that is written to the disk cache. The normals are shared.
+	uint64 KeptBytes = (UseOptions.bKeepTessellation || UseTessellationDiskCache()) ? TessellatedBytes : 0;
+	return CopyBytes + TessellatedBytes + NormalsBytes + KeptBytes + EstimateBatchMemory(NumVertices) + EstimateMaskMemory(NumVertices)
+		+ EstimateAnalyticNormalsMemory(NumVertices);
+}
+
+
+bool FMeshNoiseOp::Downgrade()
+{
+	if (UseOptions.Subdivisions > 0)
+	{
+		UseOptions.Subdivisions--;
+		return true;
+	}
+	return false;
+}
+
+
+#undef LOCTEXT_NAMESPACE
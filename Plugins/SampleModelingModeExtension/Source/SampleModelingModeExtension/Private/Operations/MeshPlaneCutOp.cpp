@@ -0,0 +1,82 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshPlaneCutOp.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/MeshTransforms.h"
+#include "Operations/MeshPlaneCut.h"
+#include "ConstrainedDelaunay2.h"
+#include "Util/ProgressCancel.h"
+#include "SampleModelingModeExtensionModule.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("PlaneCut Cut"), STAT_MeshPlaneCutOp_Cut, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("PlaneCut HoleFill"), STAT_MeshPlaneCutOp_HoleFill, STATGROUP_SampleModelingModeExtension);
+
+
+void FMeshPlaneCutOp::CalculateResult(FProgressCancel* Progress)
+{
+	ResultInfo = FGeometryResult();
+
+	if (CopyInputMesh(Progress) == false)
+	{
+		return;
+	}
+
+	ComputeFromResultMesh(Progress);
+}
+
+
+bool FMeshPlaneCutOp::ApplyToMesh(FDynamicMesh3& Mesh, const FOptions& Options, FProgressCancel* Progress)
+{
+	// the mesh is moved in and out of the operator rather than copied
+	FMeshPlaneCutOp Op(Options);
+	*Op.ResultMesh = MoveTemp(Mesh);
+	Op.ComputeFromResultMesh(Progress);
+	Mesh = MoveTemp(*Op.ResultMesh);
+	return Op.ResultInfo.Result == EGeometryResultType::Success;
+}
+
+
+void FMeshPlaneCutOp::ComputeFromResultMesh(FProgressCancel* Progress)
+{
+	FFrame3d Frame(UseOptions.WorldPlane);
+	FMeshPlaneCut Cut(ResultMesh.Get(), Frame.Origin, Frame.Z());
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshPlaneCutOp_Cut);
+		FScopedStage Stage(*this, TEXT("Cut"));
+
+		// transform mesh to world space because that is where plane is (this will correctly handle nonuniform scale)
+		MeshTransforms::ApplyTransform(*ResultMesh, (FTransformSRT3d)UseOptions.LocalToWorld);
+
+		Cut.Cut();
+	}
+	UpdateTrackedMemory();
+
+	// the hole fill is comparatively expensive, skip it if this result is no longer wanted
+	if (CheckStageCancelled(Progress))
+	{
+		return;
+	}
+
+	if (UseOptions.bFillHole)
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshPlaneCutOp_HoleFill);
+		FScopedStage Stage(*this, TEXT("HoleFill"));
+		Cut.HoleFill(ConstrainedDelaunayTriangulate<double>, false);
+		UpdateTrackedMemory();
+	}
+
+	MeshTransforms::ApplyTransformInverse(*ResultMesh, (FTransformSRT3d)UseOptions.LocalToWorld);
+
+	ResultInfo.SetSuccess(true, Progress);
+}
+
+
+uint64 FMeshPlaneCutOp::EstimatePeakMemory() const
+{
+	// the cut adds vertices and triangles along the plane, and the cut loops and hole fill triangulation are
+	// comparatively small, so allow some headroom over the mesh copy
+	return (InputMesh.IsValid()) ? (EstimateMeshMemory(*InputMesh) * 3) / 2 : 0;
+}
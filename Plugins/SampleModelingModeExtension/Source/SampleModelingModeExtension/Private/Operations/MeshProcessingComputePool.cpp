@@ -0,0 +1,251 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingComputePool.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compute Pool Queue Depth"), STAT_MeshProcessingComputePool_QueueDepth, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compute Pool Running"), STAT_MeshProcessingComputePool_Running, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Compute Pool Dropped Tasks"), STAT_MeshProcessingComputePool_Dropped, STATGROUP_SampleModelingModeExtension);
+
+TRACE_DECLARE_INT_COUNTER(MeshProcessingComputePool_QueueDepth, TEXT("ModelingModeExtension/ComputePoolQueueDepth"));
+TRACE_DECLARE_INT_COUNTER(MeshProcessingComputePool_Running, TEXT("ModelingModeExtension/ComputePoolRunning"));
+
+
+class FMeshProcessingComputePool::FWorker : public FRunnable
+{
+public:
+	FWorker(FMeshProcessingComputePool& PoolIn)
+		: Pool(PoolIn)
+	{
+		WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+
+	virtual ~FWorker() override
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (Pool.bStopping == false)
+		{
+			TUniqueFunction<void()> Task;
+			if (Pool.DequeueTask(Task))
+			{
+				Pool.NumRunning++;
+				Pool.UpdateQueueStats();
+				Task();
+				// the task state is released on this thread rather than under the queue lock
+				Task.Reset();
+				Pool.NumRunning--;
+				Pool.NumCompleted++;
+				Pool.UpdateQueueStats();
+			}
+			else
+			{
+				WorkEvent->Wait();
+			}
+		}
+		return 0;
+	}
+
+	FMeshProcessingComputePool& Pool;
+	FEvent* WorkEvent = nullptr;
+};
+
+
+namespace Local
+{
+
+static EThreadPriority GetThreadPriority(EMeshProcessingComputePriority Priority)
+{
+	switch (Priority)
+	{
+	case EMeshProcessingComputePriority::Normal:
+		return TPri_Normal;
+	case EMeshProcessingComputePriority::Lowest:
+		return TPri_Lowest;
+	default:
+		return TPri_BelowNormal;
+	}
+}
+
+}
+
+
+FMeshProcessingComputePool& FMeshProcessingComputePool::Get()
+{
+	static FMeshProcessingComputePool Pool;
+	return Pool;
+}
+
+
+FMeshProcessingComputePool::~FMeshProcessingComputePool()
+{
+	Shutdown();
+}
+
+
+void FMeshProcessingComputePool::StartThreads()
+{
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	int32 NumThreads = (Settings->ComputePoolMaxThreads > 0) ? Settings->ComputePoolMaxThreads
+		: FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() / 2);
+	uint64 AffinityMask = (Settings->ComputePoolAffinityMask != 0) ? (uint64)Settings->ComputePoolAffinityMask : FPlatformAffinity::GetNoAffinityMask();
+	EThreadPriority Priority = Local::GetThreadPriority(Settings->ComputePoolPriority);
+
+	bStopping = false;
+	for (int32 k = 0; k < NumThreads; ++k)
+	{
+		FWorker* Worker = new FWorker(*this);
+		FRunnableThread* Thread = FRunnableThread::Create(Worker, *FString::Printf(TEXT("MeshProcessingCompute%d"), k), 0, Priority, AffinityMask);
+		if (Thread == nullptr)
+		{
+			delete Worker;
+			break;
+		}
+		Workers.Add(Worker);
+		Threads.Add(Thread);
+	}
+	UE_LOG(LogSampleModelingModeExtension, Log, TEXT("Mesh processing compute pool started with %d threads"), Threads.Num());
+}
+
+
+void FMeshProcessingComputePool::Submit(const void* Channel, TUniqueFunction<void()> Task)
+{
+	// a replaced task is destroyed outside of the lock, as releasing its state may take locks of its own
+	TUniqueFunction<void()> DroppedTask;
+	{
+		FScopeLock ScopeLock(&QueueLock);
+		if (Threads.Num() == 0)
+		{
+			StartThreads();
+		}
+
+		FQueuedTask* Existing = (Channel != nullptr) ?
+			Queue.FindByPredicate([Channel](const FQueuedTask& Queued) { return Queued.Channel == Channel; }) : nullptr;
+		if (Existing != nullptr)
+		{
+			// the replacement keeps the queue position of the superseded request
+			DroppedTask = MoveTemp(Existing->Task);
+			Existing->Task = MoveTemp(Task);
+			NumDropped++;
+			INC_DWORD_STAT(STAT_MeshProcessingComputePool_Dropped);
+		}
+		else
+		{
+			Queue.Add(FQueuedTask{ Channel, MoveTemp(Task) });
+			PeakQueueDepth = FMath::Max(PeakQueueDepth, Queue.Num());
+		}
+	}
+	UpdateQueueStats();
+	WakeWorkers();
+}
+
+
+void FMeshProcessingComputePool::CancelQueued(const void* Channel)
+{
+	TUniqueFunction<void()> DroppedTask;
+	{
+		FScopeLock ScopeLock(&QueueLock);
+		int32 Index = Queue.IndexOfByPredicate([Channel](const FQueuedTask& Queued) { return Queued.Channel == Channel; });
+		if (Index == INDEX_NONE)
+		{
+			return;
+		}
+		DroppedTask = MoveTemp(Queue[Index].Task);
+		Queue.RemoveAt(Index);
+		NumDropped++;
+		INC_DWORD_STAT(STAT_MeshProcessingComputePool_Dropped);
+	}
+	UpdateQueueStats();
+}
+
+
+bool FMeshProcessingComputePool::DequeueTask(TUniqueFunction<void()>& TaskOut)
+{
+	FScopeLock ScopeLock(&QueueLock);
+	if (Queue.Num() == 0)
+	{
+		return false;
+	}
+	TaskOut = MoveTemp(Queue[0].Task);
+	Queue.RemoveAt(0);
+	return true;
+}
+
+
+void FMeshProcessingComputePool::WakeWorkers()
+{
+	FScopeLock ScopeLock(&QueueLock);
+	for (FWorker* Worker : Workers)
+	{
+		Worker->WorkEvent->Trigger();
+	}
+}
+
+
+void FMeshProcessingComputePool::Shutdown()
+{
+	TArray<FQueuedTask> DroppedTasks;
+	TArray<FWorker*> StoppedWorkers;
+	TArray<FRunnableThread*> StoppedThreads;
+	{
+		FScopeLock ScopeLock(&QueueLock);
+		DroppedTasks = MoveTemp(Queue);
+		NumDropped += DroppedTasks.Num();
+		StoppedWorkers = MoveTemp(Workers);
+		StoppedThreads = MoveTemp(Threads);
+		bStopping = true;
+		for (FWorker* Worker : StoppedWorkers)
+		{
+			Worker->WorkEvent->Trigger();
+		}
+	}
+
+	// the workers finish their running task before they exit
+	for (int32 k = 0; k < StoppedThreads.Num(); ++k)
+	{
+		StoppedThreads[k]->WaitForCompletion();
+		delete StoppedThreads[k];
+		delete StoppedWorkers[k];
+	}
+	DroppedTasks.Reset();
+	UpdateQueueStats();
+}
+
+
+FMeshProcessingComputePool::FMetrics FMeshProcessingComputePool::GetMetrics() const
+{
+	FScopeLock ScopeLock(&QueueLock);
+	FMetrics Metrics;
+	Metrics.NumThreads = Threads.Num();
+	Metrics.QueueDepth = Queue.Num();
+	Metrics.PeakQueueDepth = PeakQueueDepth;
+	Metrics.NumRunning = NumRunning.load();
+	Metrics.NumCompleted = NumCompleted.load();
+	Metrics.NumDropped = NumDropped;
+	return Metrics;
+}
+
+
+void FMeshProcessingComputePool::UpdateQueueStats()
+{
+	int32 QueueDepth = 0;
+	{
+		FScopeLock ScopeLock(&QueueLock);
+		QueueDepth = Queue.Num();
+	}
+	SET_DWORD_STAT(STAT_MeshProcessingComputePool_QueueDepth, QueueDepth);
+	SET_DWORD_STAT(STAT_MeshProcessingComputePool_Running, NumRunning.load());
+	TRACE_COUNTER_SET(MeshProcessingComputePool_QueueDepth, QueueDepth);
+	TRACE_COUNTER_SET(MeshProcessingComputePool_Running, NumRunning.load());
+}
@@ -0,0 +1,70 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingFunctionLibrary.h"
+#include "Operations/MeshNoiseOp.h"
+#include "Operations/MeshPlaneCutOp.h"
+#include "UDynamicMesh.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+
+using namespace UE::Geometry;
+
+
+UDynamicMesh* UMeshProcessingFunctionLibrary::ApplyMeshNoise(
+	UDynamicMesh* TargetMesh,
+	int Subdivisions,
+	EMeshNoiseToolNoiseType NoiseType,
+	float Scale,
+	float Frequency,
+	int Seed,
+	bool bSinglePrecision)
+{
+	if (TargetMesh == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("ApplyMeshNoise: TargetMesh is null"));
+		return TargetMesh;
+	}
+
+	FMeshNoiseOp::FOptions Options;
+	Options.Subdivisions = FMath::Clamp(Subdivisions, 0, 10);
+	Options.NoiseType = NoiseType;
+	Options.Magnitude = Scale;
+	Options.Frequency = Frequency;
+	Options.RandomSeed = Seed;
+	Options.bSinglePrecision = bSinglePrecision;
+	Options.BatchMemoryBudget = (uint64)FMath::Max(0, GetDefault<USampleModelingModeExtensionSettings>()->DisplacementBatchBudgetMB) * 1024 * 1024;
+
+	TargetMesh->EditMesh([&Options](FDynamicMesh3& EditMesh)
+	{
+		FMeshNoiseOp::ApplyToMesh(EditMesh, Options);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+
+	return TargetMesh;
+}
+
+
+UDynamicMesh* UMeshProcessingFunctionLibrary::ApplyMeshPlaneCut(
+	UDynamicMesh* TargetMesh,
+	FTransform CutPlane,
+	bool bFillHole)
+{
+	if (TargetMesh == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("ApplyMeshPlaneCut: TargetMesh is null"));
+		return TargetMesh;
+	}
+
+	// the plane is given in the space of the mesh, so the mesh does not need to be transformed
+	FMeshPlaneCutOp::FOptions Options;
+	Options.LocalToWorld = FTransform::Identity;
+	Options.WorldPlane = CutPlane;
+	Options.bFillHole = bFillHole;
+
+	TargetMesh->EditMesh([&Options](FDynamicMesh3& EditMesh)
+	{
+		FMeshPlaneCutOp::ApplyToMesh(EditMesh, Options);
+	}, EDynamicMeshChangeType::GeneralEdit, EDynamicMeshAttributeChangeFlags::Unknown, false);
+
+	return TargetMesh;
+}
@@ -0,0 +1,141 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingOperationChain.h"
+#include "UDynamicMesh.h"
+#include "Util/ProgressCancel.h"
+
+using namespace UE::Geometry;
+
+
+void FMeshProcessingOperationChain::AddOperation(TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> Operation)
+{
+	if (ensure(Operation.IsValid()))
+	{
+		Operations.Add(Operation);
+	}
+}
+
+
+bool FMeshProcessingOperationChain::IsThreadSafe() const
+{
+	for (const TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>& Operation : Operations)
+	{
+		if (Operation->GetThreading() != EMeshProcessingOperationThreading::AnyThread)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool FMeshProcessingOperationChain::CanExecuteConcurrently() const
+{
+	for (const TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>& Operation : Operations)
+	{
+		if (Operation->CanExecuteConcurrently() == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool FMeshProcessingOperationChain::IsLocal() const
+{
+	for (const TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>& Operation : Operations)
+	{
+		if (Operation->IsLocalOperation() == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+int32 FMeshProcessingOperationChain::GetRequiredHaloRings() const
+{
+	int32 HaloRings = 0;
+	for (const TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>& Operation : Operations)
+	{
+		HaloRings += Operation->GetRequiredHaloRings();
+	}
+	return HaloRings;
+}
+
+
+bool FMeshProcessingOperationChain::RequiresDynamicMeshObject() const
+{
+	for (const TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>& Operation : Operations)
+	{
+		if (Operation->RequiresDynamicMeshObject())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool FMeshProcessingOperationChain::Execute(FDynamicMesh3& Mesh, FProgressCancel* Progress, UDynamicMesh* TempMesh, FGameThreadDispatcher RunOnGameThread) const
+{
+	auto IsCancelled = [Progress]() { return Progress != nullptr && Progress->Cancelled(); };
+
+	int32 NumOperations = Operations.Num();
+	int32 RunStart = 0;
+	while (RunStart < NumOperations && IsCancelled() == false)
+	{
+		// find the run of consecutive operations that have the same threading and mesh-container requirements
+		EMeshProcessingOperationThreading RunThreading = Operations[RunStart]->GetThreading();
+		bool bRunRequiresDynamicMesh = Operations[RunStart]->RequiresDynamicMeshObject();
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd < NumOperations
+			&& Operations[RunEnd]->GetThreading() == RunThreading
+			&& Operations[RunEnd]->RequiresDynamicMeshObject() == bRunRequiresDynamicMesh)
+		{
+			RunEnd++;
+		}
+
+		auto ExecuteRun = [&]()
+		{
+			if (bRunRequiresDynamicMesh)
+			{
+				if (!ensure(TempMesh != nullptr))
+				{
+					return;
+				}
+				// move the mesh into the UDynamicMesh once for the entire run, and back out at the end
+				TempMesh->SetMesh(MoveTemp(Mesh));
+				for (int32 k = RunStart; k < RunEnd && IsCancelled() == false; ++k)
+				{
+					Operations[k]->ApplyToDynamicMesh(TempMesh, Progress);
+				}
+				TUniquePtr<FDynamicMesh3> EditedMesh = TempMesh->ExtractMesh();
+				Mesh = MoveTemp(*EditedMesh);
+			}
+			else
+			{
+				for (int32 k = RunStart; k < RunEnd && IsCancelled() == false; ++k)
+				{
+					Operations[k]->Apply(Mesh, Progress);
+				}
+			}
+		};
+
+		if (RunThreading == EMeshProcessingOperationThreading::GameThread && IsInGameThread() == false)
+		{
+			RunOnGameThread(ExecuteRun);
+		}
+		else
+		{
+			ExecuteRun();
+		}
+
+		RunStart = RunEnd;
+	}
+
+	return IsCancelled() == false;
+}
@@ -0,0 +1,148 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingOperator.h"
+#include "Util/ProgressCancel.h"
+#include "HAL/PlatformMemory.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Operator Copy"), STAT_MeshProcessingOperator_Copy, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cancelled Operators"), STAT_MeshProcessingOperator_Cancelled, STATGROUP_SampleModelingModeExtension);
+
+TRACE_DECLARE_INT_COUNTER(MeshProcessingOperator_Cancelled, TEXT("ModelingModeExtension/CancelledOperators"));
+
+
+void FMeshProcessingOperator::SetGenerationCounter(TSharedPtr<FOperatorGenerationCounter, ESPMode::ThreadSafe> CounterIn)
+{
+	GenerationCounter = CounterIn;
+	Generation = (GenerationCounter.IsValid()) ? GenerationCounter->GetCurrent() : 0;
+}
+
+
+bool FMeshProcessingOperator::IsSuperseded() const
+{
+	return GenerationCounter.IsValid() && GenerationCounter->GetCurrent() != Generation;
+}
+
+
+bool FMeshProcessingOperator::CheckStageCancelled(FProgressCancel* Progress)
+{
+	bool bSuperseded = IsSuperseded();
+	if (bSuperseded == false && (Progress == nullptr || Progress->Cancelled() == false))
+	{
+		return false;
+	}
+
+	if (bSuperseded && bRecordedStaleExit == false)
+	{
+		GenerationCounter->RecordStaleExit();
+		bRecordedStaleExit = true;
+	}
+	if (ResultInfo.Result != EGeometryResultType::Cancelled)
+	{
+		INC_DWORD_STAT(STAT_MeshProcessingOperator_Cancelled);
+		TRACE_COUNTER_INCREMENT(MeshProcessingOperator_Cancelled);
+	}
+	ResultInfo.Result = EGeometryResultType::Cancelled;
+	return true;
+}
+
+
+bool FMeshProcessingOperator::CopyInputMesh(FProgressCancel* Progress)
+{
+	if (CheckStageCancelled(Progress) || !ensure(InputMesh.IsValid()))
+	{
+		return false;
+	}
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingOperator_Copy);
+		FScopedStage Stage(*this, TEXT("Copy"));
+		ResultMesh->Copy(*InputMesh);
+	}
+	UpdateTrackedMemory();
+	return CheckStageCancelled(Progress) == false;
+}
+
+
+FMeshProcessingOperator::FScopedStage::FScopedStage(FMeshProcessingOperator& OperatorIn, const TCHAR* NameIn)
+	: Operator(OperatorIn), Name(NameIn)
+{
+	if (Operator.bCollectStageStats)
+	{
+		StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		StartTime = FPlatformTime::Seconds();
+	}
+}
+
+FMeshProcessingOperator::FScopedStage::~FScopedStage()
+{
+	if (Operator.bCollectStageStats)
+	{
+		FStageStats Stats;
+		Stats.Name = Name;
+		Stats.Seconds = FPlatformTime::Seconds() - StartTime;
+		FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		Stats.UsedPhysical = MemoryStats.UsedPhysical;
+		Stats.UsedPhysicalDelta = (int64)MemoryStats.UsedPhysical - (int64)StartUsedPhysical;
+		Stats.TrackedPeakMemory = Operator.GetTrackedPeakMemory();
+		Operator.StageStats.Add(Stats);
+	}
+}
+
+
+uint64 FMeshProcessingOperator::EstimatePeakMemory() const
+{
+	// by default the only large allocation is the copy of the input mesh
+	return (InputMesh.IsValid()) ? EstimateMeshMemory(*InputMesh) : 0;
+}
+
+
+uint64 FMeshProcessingOperator::EstimateMeshMemory(int64 NumVertices, int64 NumTriangles, bool bHasAttributes)
+{
+	// vertex position, refcount and edge list; triangle vertices, edges, refcount and group; ~1.5 edges per triangle
+	uint64 Bytes = (uint64)NumVertices * 56 + (uint64)NumTriangles * (32 + 36);
+	if (bHasAttributes)
+	{
+		// one UV and one normal overlay, with up to 3 elements per triangle
+		Bytes += (uint64)NumTriangles * (3 * (8 + 8) + 12) + (uint64)NumTriangles * (3 * (12 + 8) + 12);
+	}
+	return Bytes;
+}
+
+
+uint64 FMeshProcessingOperator::EstimateMeshMemory(const FDynamicMesh3& Mesh)
+{
+	uint64 Bytes = EstimateMeshMemory(Mesh.MaxVertexID(), Mesh.MaxTriangleID(), false);
+	if (const FDynamicMeshAttributeSet* Attributes = Mesh.Attributes())
+	{
+		uint64 NumTriangles = (uint64)Mesh.MaxTriangleID();
+		for (int32 k = 0; k < Attributes->NumUVLayers(); ++k)
+		{
+			Bytes += (uint64)Attributes->GetUVLayer(k)->MaxElementID() * (8 + 8) + NumTriangles * 12;
+		}
+		for (int32 k = 0; k < Attributes->NumNormalLayers(); ++k)
+		{
+			Bytes += (uint64)Attributes->GetNormalLayer(k)->MaxElementID() * (12 + 8) + NumTriangles * 12;
+		}
+		if (Attributes->HasPrimaryColors())
+		{
+			Bytes += (uint64)Attributes->PrimaryColors()->MaxElementID() * (16 + 8) + NumTriangles * 12;
+		}
+	}
+	return Bytes;
+}
+
+
+void FMeshProcessingOperator::UpdateTrackedMemory(uint64 AdditionalBytes)
+{
+	uint64 Current = EstimateMeshMemory(*ResultMesh) + AdditionalBytes;
+	TrackedCurrentMemory = Current;
+	if (Current > TrackedPeakMemory.load())
+	{
+		TrackedPeakMemory = Current;
+	}
+}
@@ -0,0 +1,250 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingPreset.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "Tools/MeshNoiseTool.h"
+#include "Tools/MeshPlaneCutTool.h"
+#include "Tools/MeshProcessingBPTool.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "JsonObjectConverter.h"
+
+using namespace UE::Geometry;
+
+
+bool FMeshProcessingPreset::ParseOperation(const FString& Name, EOperation& OperationOut)
+{
+	if (Name.Equals(TEXT("Noise"), ESearchCase::IgnoreCase))
+	{
+		OperationOut = EOperation::Noise;
+		return true;
+	}
+	if (Name.Equals(TEXT("PlaneCut"), ESearchCase::IgnoreCase))
+	{
+		OperationOut = EOperation::PlaneCut;
+		return true;
+	}
+	if (Name.Equals(TEXT("BP"), ESearchCase::IgnoreCase) || Name.Equals(TEXT("Blueprint"), ESearchCase::IgnoreCase))
+	{
+		OperationOut = EOperation::Blueprint;
+		return true;
+	}
+	return false;
+}
+
+
+bool FMeshProcessingPreset::LoadPresetJson(const FString& Preset, TSharedPtr<FJsonObject>& JsonOut)
+{
+	FString PresetPath = Preset;
+	if (FPaths::FileExists(PresetPath) == false)
+	{
+		PresetPath = FPaths::Combine(FPaths::ProjectConfigDir(), TEXT("MeshProcessingPresets"), Preset + TEXT(".json"));
+	}
+	FString JsonString;
+	if (FFileHelper::LoadFileToString(JsonString, *PresetPath) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: could not read preset %s"), *Preset);
+		return false;
+	}
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if (FJsonSerializer::Deserialize(Reader, JsonOut) == false || JsonOut.IsValid() == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: could not parse preset %s"), *PresetPath);
+		return false;
+	}
+	return true;
+}
+
+
+FString FMeshProcessingPreset::MakePresetJsonString(EOperation OperationIn, const UInteractiveToolPropertySet* ToolProperties)
+{
+	TSharedRef<FJsonObject> PresetJson = MakeShared<FJsonObject>();
+	PresetJson->SetStringField(TEXT("Operation"), (OperationIn == EOperation::Noise) ? TEXT("Noise") : (OperationIn == EOperation::PlaneCut) ? TEXT("PlaneCut") : TEXT("BP"));
+
+	TSharedRef<FJsonObject> PropertiesJson = MakeShared<FJsonObject>();
+	FJsonObjectConverter::UStructToJsonObject(ToolProperties->GetClass(), ToolProperties, PropertiesJson, 0, 0);
+
+	// instanced AdditionalSteps cannot be created by the JSON converter, they are written as their class and settings instead (see Initialize())
+	if (const UMeshProcessingBPToolProperties* BPProperties = Cast<UMeshProcessingBPToolProperties>(ToolProperties))
+	{
+		PropertiesJson->RemoveField(GET_MEMBER_NAME_STRING_CHECKED(UMeshProcessingBPToolProperties, AdditionalSteps));
+		TArray<TSharedPtr<FJsonValue>> StepsJson;
+		for (const UMeshProcessingChainStep* Step : BPProperties->AdditionalSteps)
+		{
+			if (Step != nullptr)
+			{
+				TSharedRef<FJsonObject> StepJson = MakeShared<FJsonObject>();
+				StepJson->SetStringField(TEXT("Class"), Step->GetClass()->GetName());
+				TSharedRef<FJsonObject> StepPropertiesJson = MakeShared<FJsonObject>();
+				FJsonObjectConverter::UStructToJsonObject(Step->GetClass(), Step, StepPropertiesJson, 0, 0);
+				StepJson->SetObjectField(TEXT("Properties"), StepPropertiesJson);
+				StepsJson.Add(MakeShared<FJsonValueObject>(StepJson));
+			}
+		}
+		PresetJson->SetArrayField(TEXT("Steps"), StepsJson);
+	}
+	PresetJson->SetObjectField(TEXT("Properties"), PropertiesJson);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+	FJsonSerializer::Serialize(PresetJson, Writer);
+	return JsonString;
+}
+
+
+bool FMeshProcessingPreset::Initialize(const TSharedPtr<FJsonObject>& PresetJson, const FString& OperationNameIn)
+{
+	check(IsInGameThread());
+
+	FString OperationName = OperationNameIn;
+	if (OperationName.IsEmpty() && PresetJson.IsValid())
+	{
+		PresetJson->TryGetStringField(TEXT("Operation"), OperationName);
+	}
+	if (ParseOperation(OperationName, Operation) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: unknown Operation '%s', expected Noise, PlaneCut or BP"), *OperationName);
+		return false;
+	}
+
+	UClass* PropertiesClass = (Operation == EOperation::Noise) ? UMeshNoiseProperties::StaticClass() :
+		(Operation == EOperation::PlaneCut) ? UMeshPlaneCutProperties::StaticClass() : UMeshProcessingBPToolProperties::StaticClass();
+	Properties.Reset(NewObject<UInteractiveToolPropertySet>(GetTransientPackage(), PropertiesClass));
+
+	// the preset Properties use the same names as the Tool settings
+	const TSharedPtr<FJsonObject>* PropertiesJson = nullptr;
+	if (PresetJson.IsValid() && PresetJson->TryGetObjectField(TEXT("Properties"), PropertiesJson))
+	{
+		if (FJsonObjectConverter::JsonObjectToUStruct(PropertiesJson->ToSharedRef(), PropertiesClass, Properties.Get()) == false)
+		{
+			UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: invalid Properties"));
+			return false;
+		}
+	}
+
+	if (Operation == EOperation::Noise)
+	{
+		NoiseOptions = UMeshNoiseTool::MakeOperatorOptions(CastChecked<UMeshNoiseProperties>(Properties.Get()));
+	}
+	else if (Operation == EOperation::PlaneCut)
+	{
+		// meshes are processed in their local space, the plane is relative to the bounds center of each mesh if requested
+		const UMeshPlaneCutProperties* PlaneCutProperties = CastChecked<UMeshPlaneCutProperties>(Properties.Get());
+		if (PresetJson.IsValid())
+		{
+			PresetJson->TryGetBoolField(TEXT("PlaneAtBoundsCenter"), bPlaneAtBoundsCenter);
+		}
+		PlaneCutOptions.LocalToWorld = FTransform::Identity;
+		PlaneCutOptions.WorldPlane = FTransform(PlaneCutProperties->Rotation, PlaneCutProperties->Position);
+		PlaneCutOptions.bFillHole = PlaneCutProperties->bFillHole;
+	}
+	else
+	{
+		UMeshProcessingBPToolProperties* BPProperties = CastChecked<UMeshProcessingBPToolProperties>(Properties.Get());
+
+		// instanced AdditionalSteps cannot be created by the JSON converter, they are listed as a class name (with default settings),
+		// or as an object with the class name and the settings of the step
+		const TArray<TSharedPtr<FJsonValue>>* StepsJson = nullptr;
+		if (PresetJson.IsValid() && PresetJson->TryGetArrayField(TEXT("Steps"), StepsJson))
+		{
+			for (const TSharedPtr<FJsonValue>& StepJson : *StepsJson)
+			{
+				FString StepClassName;
+				const TSharedPtr<FJsonObject>* StepObjectJson = nullptr;
+				const TSharedPtr<FJsonObject>* StepPropertiesJson = nullptr;
+				if (StepJson->TryGetObject(StepObjectJson))
+				{
+					(*StepObjectJson)->TryGetStringField(TEXT("Class"), StepClassName);
+					(*StepObjectJson)->TryGetObjectField(TEXT("Properties"), StepPropertiesJson);
+				}
+				else
+				{
+					StepJson->TryGetString(StepClassName);
+				}
+
+				UClass* StepClass = FindObject<UClass>(ANY_PACKAGE, *StepClassName);
+				if (StepClass == nullptr || StepClass->IsChildOf(UMeshProcessingChainStep::StaticClass()) == false || StepClass->HasAnyClassFlags(CLASS_Abstract))
+				{
+					UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: unknown chain step '%s'"), *StepClassName);
+					return false;
+				}
+				UMeshProcessingChainStep* Step = NewObject<UMeshProcessingChainStep>(BPProperties, StepClass);
+				// a step that runs with other settings than requested would silently produce a different result
+				if (StepPropertiesJson != nullptr && FJsonObjectConverter::JsonObjectToUStruct(StepPropertiesJson->ToSharedRef(), StepClass, Step) == false)
+				{
+					UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: invalid settings of chain step '%s'"), *StepClassName);
+					return false;
+				}
+				BPProperties->AdditionalSteps.Add(Step);
+			}
+		}
+
+		MakeBlueprintChain(Chain, BlueprintInstances);
+
+		if (Chain.IsEmpty())
+		{
+			UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingPreset: the preset does not configure a Blueprint Operation or chain steps"));
+			return false;
+		}
+
+		// native chains use the same operator as the Tool, including chunked execution
+		bNativeChain = Chain.IsThreadSafe() && Chain.RequiresDynamicMeshObject() == false;
+		bChunkedExecution = BPProperties->bChunkedExecution;
+		ChunkOptions.NumChunks = BPProperties->NumChunks;
+		ChunkOptions.HaloRings = BPProperties->HaloWidth;
+	}
+	return true;
+}
+
+
+void FMeshProcessingPreset::MakeBlueprintChain(FMeshProcessingOperationChain& ChainOut, TArray<TStrongObjectPtr<UMeshProcessingBPToolOperation>>& InstancesOut) const
+{
+	const UMeshProcessingBPToolProperties* BPProperties = CastChecked<UMeshProcessingBPToolProperties>(Properties.Get());
+	UMeshProcessingBPTool::BuildOperationChain(BPProperties, [BPProperties, &InstancesOut](TSubclassOf<UMeshProcessingBPToolOperation> OperationType)
+	{
+		UClass* ClassType = OperationType;
+		UMeshProcessingBPToolOperation* OperationInstance = NewObject<UMeshProcessingBPToolOperation>((UObject*)GetTransientPackage(), ClassType);
+		InstancesOut.Emplace(OperationInstance);
+		return UMeshProcessingBPTool::MakeBlueprintChainOperation(OperationInstance, BPProperties->Parameters);
+	}, ChainOut);
+}
+
+
+TUniquePtr<FMeshProcessingOperator> FMeshProcessingPreset::MakeOperator(const TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe>& InputMesh) const
+{
+	TUniquePtr<FMeshProcessingOperator> Operator;
+	if (Operation == EOperation::Noise)
+	{
+		TUniquePtr<FMeshNoiseOp> NoiseOp = MakeUnique<FMeshNoiseOp>(NoiseOptions);
+		TSharedPtr<FMeshNormals, ESPMode::ThreadSafe> VertexNormals = MakeShared<FMeshNormals, ESPMode::ThreadSafe>(InputMesh.Get());
+		VertexNormals->ComputeVertexNormals();
+		NoiseOp->BaseMeshNormals = VertexNormals;
+		Operator = MoveTemp(NoiseOp);
+	}
+	else if (Operation == EOperation::PlaneCut)
+	{
+		FMeshPlaneCutOp::FOptions Options = PlaneCutOptions;
+		if (bPlaneAtBoundsCenter)
+		{
+			Options.WorldPlane.AddToTranslation(InputMesh->GetBounds().Center());
+		}
+		Operator = MakeUnique<FMeshPlaneCutOp>(Options);
+	}
+	else if (bNativeChain)
+	{
+		Operator = UMeshProcessingBPTool::MakeNativeChainOperator(Chain, (bChunkedExecution) ? &ChunkOptions : nullptr);
+	}
+
+	if (Operator.IsValid())
+	{
+		Operator->SetInputMesh(InputMesh);
+		Operator->SetTransform(FTransformSRT3d::Identity());
+	}
+	return Operator;
+}
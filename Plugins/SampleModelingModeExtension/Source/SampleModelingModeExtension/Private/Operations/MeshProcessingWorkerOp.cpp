@@ -0,0 +1,61 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingWorkerOp.h"
+#include "Operations/MeshProcessingWorkerPool.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "Util/ProgressCancel.h"
+
+using namespace UE::Geometry;
+
+#define LOCTEXT_NAMESPACE "MeshProcessingWorkerOp"
+
+
+void FMeshProcessingWorkerOp::CalculateResult(FProgressCancel* Progress)
+{
+	ResultInfo = FGeometryResult();
+
+	if (CheckStageCancelled(Progress) || !ensure(InputMesh.IsValid()))
+	{
+		return;
+	}
+
+	FString Error;
+	FMeshProcessingWorkerPool::EResult Result;
+	{
+		FScopedStage Stage(*this, TEXT("WorkerProcess"));
+		Result = FMeshProcessingWorkerPool::Get().Execute(PresetJson, *InputMesh, *ResultMesh, TimeoutSeconds,
+			[this, Progress]() { return IsSuperseded() || (Progress != nullptr && Progress->Cancelled()); },
+			[this]() { return AbortFlag.IsValid() && AbortFlag->load(); }, Error);
+	}
+	UpdateTrackedMemory();
+
+	if (Result == FMeshProcessingWorkerPool::EResult::Cancelled)
+	{
+		CheckStageCancelled(Progress);
+		return;
+	}
+	if (Result != FMeshProcessingWorkerPool::EResult::Success)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingWorkerOp: %s"), *Error);
+		// the result may be partially read, the Tool keeps its previous preview and shows the error
+		ResultMesh->Clear();
+		ResultInfo.AddError(FGeometryError((int32)Result, FText::Format(LOCTEXT("WorkerProcessFailed", "worker process {0}: {1}"),
+			FText::FromString(FMeshProcessingWorkerPool::LexToString(Result)), FText::FromString(Error))));
+		ResultInfo.SetSuccess(false, Progress);
+		return;
+	}
+
+	ResultInfo.SetSuccess(true, Progress);
+}
+
+
+uint64 FMeshProcessingWorkerOp::EstimatePeakMemory() const
+{
+	// the serialized request and result are held in shared memory next to the result mesh, the
+	// memory of the operation itself is in the worker process
+	return (InputMesh.IsValid()) ? EstimateMeshMemory(*InputMesh) * 3 : 0;
+}
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,849 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshProcessingWorkerPool.h"
+#include "Operations/MeshProcessingPreset.h"
+#include "Operations/MeshSharedMemoryLayout.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "UDynamicMesh.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Dom/JsonObject.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Util/ProgressCancel.h"
+
+#if PLATFORM_UNIX || PLATFORM_MAC
+#include <sys/mman.h>
+#endif
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Worker Process Request"), STAT_MeshProcessingWorkerPool_Request, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Worker Process Execute"), STAT_MeshProcessingWorkerPool_Execute, STATGROUP_SampleModelingModeExtension);
+
+
+namespace Local
+{
+
+enum class EWorkerState : uint32
+{
+	// the process has been started, but has not mapped the control region yet
+	Starting,
+	Idle,
+	// the host has written a request
+	Request,
+	Running,
+	// the worker has written the result, and waits for the host to return to Idle
+	Done,
+	Failed,
+	// the host asks the worker to exit
+	Shutdown
+};
+
+static constexpr uint32 ControlMagic = 0x4D50574B;
+static constexpr int32 MaxRegionNameLength = 128;
+static constexpr int32 MaxErrorLength = 512;
+
+// a new editor process can take a while to load the project
+static constexpr double StartupTimeoutSeconds = 180.0;
+// time for an idle worker to exit after a shutdown request, before it is terminated
+static constexpr double ShutdownGraceSeconds = 2.0;
+// interval of the worker check that the host process is still running
+static constexpr double HostCheckIntervalSeconds = 1.0;
+// interval of the host checks for cancellation, timeouts and exited workers while it waits for a state change
+static constexpr double HostWaitSliceSeconds = 0.01;
+// the worker collects the garbage of Blueprint Operations after this many requests
+static constexpr int32 WorkerGarbageCollectInterval = 16;
+
+static_assert(std::atomic<uint32>::is_always_lock_free, "the control block atomics must be lock-free to be shared between processes");
+
+/**
+ * Control region of a worker process, shared between the host and the worker. The host owns the
+ * request fields and the worker the result fields, the State transitions hand them over.
+ */
+struct FControlBlock
+{
+	uint32 Magic = ControlMagic;
+	std::atomic<uint32> State{ (uint32)EWorkerState::Starting };
+	std::atomic<uint32> bCancel{ 0 };
+
+	// request, written by the host before State is set to Request
+	uint32 Sequence = 0;
+	uint64 RequestSize = 0;
+	TCHAR RequestRegion[MaxRegionNameLength] = {};
+
+	// result, written by the worker before State is set to Done or Failed
+	uint64 ResultSize = 0;
+	TCHAR ResultRegion[MaxRegionNameLength] = {};
+	TCHAR Error[MaxErrorLength] = {};
+
+	EWorkerState GetState() const { return (EWorkerState)State.load(); }
+	void SetState(EWorkerState NewState) { State.store((uint32)NewState); }
+};
+
+
+static constexpr uint32 ReadWriteAccess = FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write;
+
+static FControlBlock* GetControlBlock(FPlatformMemory::FSharedMemoryRegion* Region)
+{
+	return (Region != nullptr) ? (FControlBlock*)Region->GetAddress() : nullptr;
+}
+
+static FString GetResultRegionName(const FString& ControlRegionName, uint32 Sequence)
+{
+	return FString::Printf(TEXT("%s_R%u"), *ControlRegionName, Sequence);
+}
+
+/**
+ * Open the interprocess semaphore that wakes one side of a worker when the other side changes the control state.
+ * The host creates the semaphores before it starts the process, the worker opens them.
+ */
+static FPlatformProcess::FSemaphore* OpenSignal(const FString& ControlRegionName, const TCHAR* Suffix, bool bCreate)
+{
+	FPlatformProcess::FSemaphore* Signal = FPlatformProcess::NewInterprocessSynchObject(ControlRegionName + Suffix, bCreate, 1);
+	if (Signal != nullptr && bCreate)
+	{
+		// semaphores are created unlocked, so take it once, and the next Unlock() wakes the waiting side
+		Signal->Lock();
+	}
+	return Signal;
+}
+
+/** Block until the other side signals, or Seconds have passed. Callers re-check the control state either way. */
+static void WaitForSignal(FPlatformProcess::FSemaphore* Signal, double Seconds)
+{
+	Signal->TryLock((uint64)(Seconds * 1e9));
+}
+
+/**
+ * Remove the name of a region that a terminated worker created, and could not release itself. Named regions are
+ * released with the last handle on Windows, but persist in /dev/shm on Linux (and the Mac equivalent) until unlinked.
+ */
+static void UnlinkOrphanedRegion(const FString& RegionName)
+{
+#if PLATFORM_UNIX || PLATFORM_MAC
+	// FPlatformMemory::MapNamedSharedMemoryRegion maps "/<name>", and only unlinks it when unmapped by the creator
+	shm_unlink(TCHAR_TO_UTF8(*(TEXT("/") + RegionName)));
+#endif
+}
+
+/**
+ * Create a shared memory region named RegionName of Size bytes, and fill it with WriteFunc
+ * @return the region, which the caller must unmap, or null if it could not be created or written
+ */
+static FPlatformMemory::FSharedMemoryRegion* WriteRegion(const FString& RegionName, uint64 Size, TFunctionRef<bool(uint8*, uint64)> WriteFunc)
+{
+	FPlatformMemory::FSharedMemoryRegion* Region = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, true, ReadWriteAccess, FMath::Max<uint64>(Size, 1));
+	if (Region == nullptr)
+	{
+		return nullptr;
+	}
+	if (WriteFunc((uint8*)Region->GetAddress(), Size) == false)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+		return nullptr;
+	}
+	return Region;
+}
+
+/**
+ * Map the existing region RegionName and read it with ReadFunc
+ * @return false if the region could not be mapped or read
+ */
+static bool ReadRegion(const TCHAR* RegionName, uint64 Size, TFunctionRef<bool(const uint8*, uint64)> ReadFunc)
+{
+	FPlatformMemory::FSharedMemoryRegion* Region = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, false, FPlatformMemory::ESharedMemoryAccess::Read, Size);
+	if (Region == nullptr)
+	{
+		return false;
+	}
+	bool bSuccess = ReadFunc((const uint8*)Region->GetAddress(), Size);
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	return bSuccess;
+}
+
+
+/**
+ * Request region: this header, the preset JSON string, and the input mesh in the layout of FMeshSharedMemoryLayout at MeshOffset
+ */
+struct FRequestHeader
+{
+	uint64 PresetLength = 0;
+	uint64 MeshOffset = 0;
+};
+
+static uint64 GetRequestMeshOffset(const FString& PresetJson)
+{
+	// mesh blocks are 16-byte aligned
+	return (sizeof(FRequestHeader) + (uint64)PresetJson.Len() * sizeof(TCHAR) + 15) & ~(uint64)15;
+}
+
+static bool WriteRequest(const FString& PresetJson, const FDynamicMesh3& Mesh, uint8* Data, uint64 Size)
+{
+	FRequestHeader Header;
+	Header.PresetLength = (uint64)PresetJson.Len();
+	Header.MeshOffset = GetRequestMeshOffset(PresetJson);
+	if (Header.MeshOffset > Size)
+	{
+		return false;
+	}
+	FMemory::Memcpy(Data, &Header, sizeof(Header));
+	FMemory::Memcpy(Data + sizeof(Header), *PresetJson, Header.PresetLength * sizeof(TCHAR));
+	return FMeshSharedMemoryLayout::Write(Mesh, Data + Header.MeshOffset, Size - Header.MeshOffset);
+}
+
+static bool ReadRequest(const uint8* Data, uint64 Size, FString& PresetJsonOut, FDynamicMesh3& MeshOut)
+{
+	FRequestHeader Header;
+	if (Size < sizeof(Header))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+	if (Header.MeshOffset > Size || sizeof(Header) + Header.PresetLength * sizeof(TCHAR) > Header.MeshOffset)
+	{
+		return false;
+	}
+	PresetJsonOut = FString((int32)Header.PresetLength, (const TCHAR*)(Data + sizeof(Header)));
+	return FMeshSharedMemoryLayout::Read(Data + Header.MeshOffset, Size - Header.MeshOffset, MeshOut);
+}
+
+
+static FString GetWorkerExecutable()
+{
+	// prefer the console variant of the editor executable, which does not open a window
+	FString Executable = FPlatformProcess::ExecutablePath();
+	FString BaseName = FPaths::GetBaseFilename(Executable);
+	if (BaseName.EndsWith(TEXT("-Cmd")) == false)
+	{
+		FString CmdExecutable = FPaths::Combine(FPaths::GetPath(Executable), BaseName + TEXT("-Cmd") + FPaths::GetExtension(Executable, true));
+		if (FPaths::FileExists(CmdExecutable))
+		{
+			return CmdExecutable;
+		}
+	}
+	return Executable;
+}
+
+
+/**
+ * State of the request loop of a worker process
+ */
+struct FWorkerLoop
+{
+	FControlBlock* Control = nullptr;
+	FString ControlRegionName;
+	// wakes the host when a request is done
+	FPlatformProcess::FSemaphore* HostSignal = nullptr;
+
+	// the preset of the last request, reused while the host sends the same preset
+	FString PresetJson;
+	TUniquePtr<FMeshProcessingPreset> Preset;
+
+	// the result region is kept until the host has read it
+	FPlatformMemory::FSharedMemoryRegion* ResultRegion = nullptr;
+
+	void ReleaseResult()
+	{
+		if (ResultRegion != nullptr)
+		{
+			FPlatformMemory::UnmapNamedSharedMemoryRegion(ResultRegion);
+			ResultRegion = nullptr;
+		}
+	}
+
+	void SetState(EWorkerState NewState)
+	{
+		Control->SetState(NewState);
+		HostSignal->Unlock();
+	}
+
+	void SetFailed(const FString& Error)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingWorker: request %u failed: %s"), Control->Sequence, *Error);
+		FCString::Strncpy(Control->Error, *Error, MaxErrorLength);
+		SetState(EWorkerState::Failed);
+	}
+
+	void ExecuteRequest()
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingWorkerPool_Execute);
+		Control->SetState(EWorkerState::Running);
+
+		FString RequestPresetJson;
+		FDynamicMesh3 Mesh;
+		if (ReadRegion(Control->RequestRegion, Control->RequestSize, [&](const uint8* Data, uint64 Size) { return ReadRequest(Data, Size, RequestPresetJson, Mesh); }) == false)
+		{
+			SetFailed(TEXT("could not read the request"));
+			return;
+		}
+
+		if (Preset.IsValid() == false || RequestPresetJson != PresetJson)
+		{
+			// release the Blueprint instances of the previous preset before creating the new ones
+			Preset.Reset();
+			PresetJson.Reset();
+			TSharedPtr<FJsonObject> Json;
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(RequestPresetJson);
+			TUniquePtr<FMeshProcessingPreset> NewPreset = MakeUnique<FMeshProcessingPreset>();
+			if (FJsonSerializer::Deserialize(Reader, Json) == false || Json.IsValid() == false || NewPreset->Initialize(Json, FString()) == false)
+			{
+				SetFailed(TEXT("invalid preset, see the worker log"));
+				return;
+			}
+			Preset = MoveTemp(NewPreset);
+			PresetJson = RequestPresetJson;
+		}
+
+		FProgressCancel Progress;
+		FControlBlock* CancelControl = Control;
+		Progress.CancelF = [CancelControl]() { return CancelControl->bCancel.load() != 0; };
+
+		if (Preset->RequiresChainExecution())
+		{
+			TStrongObjectPtr<UDynamicMesh> TempMesh;
+			if (Preset->Chain.RequiresDynamicMeshObject())
+			{
+				TempMesh.Reset(NewObject<UDynamicMesh>());
+			}
+			// the request loop runs on the game thread, so game-thread steps are executed inline
+			Preset->Chain.Execute(Mesh, &Progress, TempMesh.Get(), [](TFunctionRef<void()> Work) { Work(); });
+		}
+		else
+		{
+			TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> InputMesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>(MoveTemp(Mesh));
+			TUniquePtr<FMeshProcessingOperator> Operator = Preset->MakeOperator(InputMesh);
+			if (Operator.IsValid() == false)
+			{
+				SetFailed(TEXT("could not create operator"));
+				return;
+			}
+			Operator->CalculateResult(&Progress);
+			TUniquePtr<FDynamicMesh3> ResultMesh = Operator->ExtractResult();
+			if (ResultMesh.IsValid() == false || Operator->GetResultInfo().Result != EGeometryResultType::Success)
+			{
+				SetFailed((Progress.Cancelled()) ? TEXT("cancelled") : TEXT("operator did not return a result"));
+				return;
+			}
+			Mesh = MoveTemp(*ResultMesh);
+		}
+		if (Progress.Cancelled())
+		{
+			SetFailed(TEXT("cancelled"));
+			return;
+		}
+
+		FString ResultRegionName = GetResultRegionName(ControlRegionName, Control->Sequence);
+		uint64 ResultSize = FMeshSharedMemoryLayout::GetSize(Mesh);
+		ResultRegion = WriteRegion(ResultRegionName, ResultSize, [&Mesh](uint8* Data, uint64 Size) { return FMeshSharedMemoryLayout::Write(Mesh, Data, Size); });
+		if (ResultRegion == nullptr)
+		{
+			SetFailed(FString::Printf(TEXT("could not create a shared memory region of %llu bytes for the result"), ResultSize));
+			return;
+		}
+		FCString::Strncpy(Control->ResultRegion, *ResultRegionName, MaxRegionNameLength);
+		Control->ResultSize = ResultSize;
+		SetState(EWorkerState::Done);
+	}
+};
+
+}
+
+
+struct FMeshProcessingWorkerPool::FWorkerProcess
+{
+	FString ControlRegionName;
+	FPlatformMemory::FSharedMemoryRegion* ControlRegion = nullptr;
+	// wake the worker when the host changes the control state, and the host when the worker does
+	FPlatformProcess::FSemaphore* WorkerSignal = nullptr;
+	FPlatformProcess::FSemaphore* HostSignal = nullptr;
+	FProcHandle Process;
+	uint32 ProcessID = 0;
+	double StartTime = 0;
+	bool bBusy = false;
+	// stop the process when it is released, see Shutdown(). A busy worker polls this to abort its request.
+	std::atomic<bool> bRetire{ false };
+
+	bool IsStarted() const { return ControlRegion != nullptr; }
+	Local::FControlBlock* GetControl() const { return Local::GetControlBlock(ControlRegion); }
+
+	void SetState(Local::EWorkerState NewState)
+	{
+		GetControl()->SetState(NewState);
+		WorkerSignal->Unlock();
+	}
+};
+
+
+FMeshProcessingWorkerPool& FMeshProcessingWorkerPool::Get()
+{
+	static FMeshProcessingWorkerPool Pool;
+	return Pool;
+}
+
+
+FMeshProcessingWorkerPool::FMeshProcessingWorkerPool()
+{
+	WorkerReleasedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+
+FMeshProcessingWorkerPool::~FMeshProcessingWorkerPool()
+{
+	Shutdown();
+	FPlatformProcess::ReturnSynchEventToPool(WorkerReleasedEvent);
+}
+
+
+const TCHAR* FMeshProcessingWorkerPool::LexToString(EResult Result)
+{
+	switch (Result)
+	{
+	case EResult::Success:
+		return TEXT("Success");
+	case EResult::Cancelled:
+		return TEXT("Cancelled");
+	case EResult::TimedOut:
+		return TEXT("TimedOut");
+	case EResult::Crashed:
+		return TEXT("Crashed");
+	default:
+		return TEXT("Failed");
+	}
+}
+
+
+FMeshProcessingWorkerPool::EResult FMeshProcessingWorkerPool::Execute(const FString& PresetJson, const FDynamicMesh3& InputMesh, FDynamicMesh3& ResultMesh,
+	double TimeoutSeconds, const TFunction<bool()>& CancelF, const TFunction<bool()>& AbortF, FString& ErrorOut)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingWorkerPool_Request);
+
+	ErrorOut.Reset();
+	// waiting for a free worker can be cancelled either way
+	FWorkerProcess* Worker = AcquireWorker([&CancelF, &AbortF]() { return (CancelF && CancelF()) || (AbortF && AbortF()); }, ErrorOut);
+	EResult Result = EResult::Cancelled;
+	if (Worker != nullptr)
+	{
+		Result = ExecuteOnWorker(*Worker, PresetJson, InputMesh, ResultMesh, TimeoutSeconds, CancelF, AbortF, ErrorOut);
+		if (Result != EResult::Success && Result != EResult::Cancelled)
+		{
+			UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingWorkerPool: request on worker process %u %s: %s"), Worker->ProcessID, LexToString(Result), *ErrorOut);
+		}
+		ReleaseWorker(Worker);
+	}
+	else if (ErrorOut.IsEmpty() == false)
+	{
+		Result = EResult::Failed;
+	}
+
+	switch (Result)
+	{
+	case EResult::Success:
+		NumCompleted++;
+		break;
+	case EResult::Cancelled:
+		ErrorOut = TEXT("cancelled");
+		NumCancelled++;
+		break;
+	case EResult::TimedOut:
+		NumTimedOut++;
+		break;
+	case EResult::Crashed:
+		NumCrashed++;
+		break;
+	default:
+		NumFailed++;
+		break;
+	}
+	return Result;
+}
+
+
+FMeshProcessingWorkerPool::EResult FMeshProcessingWorkerPool::ExecuteOnWorker(FWorkerProcess& Worker, const FString& PresetJson, const FDynamicMesh3& InputMesh,
+	FDynamicMesh3& ResultMesh, double TimeoutSeconds, const TFunction<bool()>& CancelF, const TFunction<bool()>& AbortF, FString& ErrorOut)
+{
+	Local::FControlBlock* Control = Worker.GetControl();
+
+	// a new process reports Idle once it has loaded the project
+	while (Control->GetState() == Local::EWorkerState::Starting)
+	{
+		if (FPlatformProcess::IsProcRunning(Worker.Process) == false)
+		{
+			StopProcess(Worker, false);
+			ErrorOut = TEXT("the worker process exited during startup");
+			return EResult::Crashed;
+		}
+		if (FPlatformTime::Seconds() - Worker.StartTime > Local::StartupTimeoutSeconds)
+		{
+			StopProcess(Worker, true);
+			ErrorOut = TEXT("the worker process did not start");
+			return EResult::TimedOut;
+		}
+		if ((CancelF && CancelF()) || (AbortF && AbortF()))
+		{
+			// the process keeps starting, and is used by the next request
+			return EResult::Cancelled;
+		}
+		Local::WaitForSignal(Worker.HostSignal, Local::HostWaitSliceSeconds);
+	}
+	if (Control->GetState() != Local::EWorkerState::Idle)
+	{
+		StopProcess(Worker, true);
+		ErrorOut = TEXT("the worker process is in an unexpected state");
+		return EResult::Failed;
+	}
+
+	uint32 Sequence = Control->Sequence + 1;
+	FString RequestRegionName = FString::Printf(TEXT("%s_Q%u"), *Worker.ControlRegionName, Sequence);
+	uint64 RequestSize = Local::GetRequestMeshOffset(PresetJson) + FMeshSharedMemoryLayout::GetSize(InputMesh);
+	FPlatformMemory::FSharedMemoryRegion* RequestRegion = Local::WriteRegion(RequestRegionName, RequestSize,
+		[&PresetJson, &InputMesh](uint8* Data, uint64 Size) { return Local::WriteRequest(PresetJson, InputMesh, Data, Size); });
+	if (RequestRegion == nullptr)
+	{
+		ErrorOut = FString::Printf(TEXT("could not create a shared memory region of %llu bytes for the request"), RequestSize);
+		return EResult::Failed;
+	}
+
+	Control->Sequence = Sequence;
+	Control->RequestSize = RequestSize;
+	FCString::Strncpy(Control->RequestRegion, *RequestRegionName, Local::MaxRegionNameLength);
+	Control->bCancel.store(0);
+	Worker.SetState(Local::EWorkerState::Request);
+
+	EResult Result = EResult::Success;
+	double StartTime = FPlatformTime::Seconds();
+	double CancelTime = 0;
+	while (true)
+	{
+		Local::EWorkerState State = Control->GetState();
+		if (State == Local::EWorkerState::Done || State == Local::EWorkerState::Failed)
+		{
+			break;
+		}
+		if (FPlatformProcess::IsProcRunning(Worker.Process) == false)
+		{
+			ErrorOut = FString::Printf(TEXT("the worker process exited, see %s"), *FPaths::ConvertRelativePathToFull(FPaths::ProjectLogDir()));
+			Result = EResult::Crashed;
+			break;
+		}
+		double Now = FPlatformTime::Seconds();
+		if (TimeoutSeconds > 0 && Now - StartTime > TimeoutSeconds)
+		{
+			ErrorOut = FString::Printf(TEXT("no result after %.0fs"), TimeoutSeconds);
+			Result = EResult::TimedOut;
+			break;
+		}
+		if (CancelTime == 0 && CancelF && CancelF())
+		{
+			// the worker stops at its next cancellation check, or finishes the request (eg a Blueprint, which cannot
+			// check for cancellation), and its result is then discarded below
+			Control->bCancel.store(1);
+			CancelTime = Now;
+		}
+		if ((AbortF && AbortF()) || Worker.bRetire)
+		{
+			ErrorOut = TEXT("aborted");
+			Result = EResult::Cancelled;
+			break;
+		}
+		Local::WaitForSignal(Worker.HostSignal, Local::HostWaitSliceSeconds);
+	}
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(RequestRegion);
+
+	if (Result != EResult::Success)
+	{
+		StopProcess(Worker, true);
+		return Result;
+	}
+
+	if (CancelTime > 0)
+	{
+		Result = EResult::Cancelled;
+	}
+	else if (Control->GetState() == Local::EWorkerState::Failed)
+	{
+		ErrorOut = FString(Control->Error);
+		Result = EResult::Failed;
+	}
+	else if (Local::ReadRegion(Control->ResultRegion, Control->ResultSize, [&ResultMesh](const uint8* Data, uint64 Size) { return FMeshSharedMemoryLayout::Read(Data, Size, ResultMesh); }) == false)
+	{
+		ErrorOut = TEXT("could not read the result");
+		Result = EResult::Failed;
+	}
+
+	// returning to Idle lets the worker release the result region
+	Worker.SetState(Local::EWorkerState::Idle);
+	return Result;
+}
+
+
+FMeshProcessingWorkerPool::FWorkerProcess* FMeshProcessingWorkerPool::AcquireWorker(const TFunction<bool()>& CancelF, FString& ErrorOut)
+{
+	while (true)
+	{
+		{
+			FScopeLock ScopeLock(&Lock);
+			int32 MaxWorkers = FMath::Max(1, GetDefault<USampleModelingModeExtensionSettings>()->WorkerProcessCount);
+
+			// prefer a running process over one that has to be started
+			FWorkerProcess* FreeWorker = nullptr;
+			for (const TUniquePtr<FWorkerProcess>& Worker : Workers)
+			{
+				if (Worker->bBusy == false && Worker->bRetire == false && (FreeWorker == nullptr || Worker->IsStarted()))
+				{
+					FreeWorker = Worker.Get();
+				}
+			}
+			if (FreeWorker == nullptr && Workers.Num() < MaxWorkers)
+			{
+				FreeWorker = Workers.Add_GetRef(MakeUnique<FWorkerProcess>()).Get();
+			}
+
+			if (FreeWorker != nullptr)
+			{
+				if (FreeWorker->IsStarted() == false && StartProcess(*FreeWorker) == false)
+				{
+					Workers.RemoveAll([FreeWorker](const TUniquePtr<FWorkerProcess>& Worker) { return Worker.Get() == FreeWorker; });
+					ErrorOut = TEXT("could not start a worker process");
+					return nullptr;
+				}
+				FreeWorker->bBusy = true;
+				return FreeWorker;
+			}
+		}
+
+		if (CancelF && CancelF())
+		{
+			return nullptr;
+		}
+		// woken by ReleaseWorker(), the timeout only bounds the cancellation checks
+		WorkerReleasedEvent->Wait(FTimespan::FromSeconds(Local::HostWaitSliceSeconds));
+	}
+}
+
+
+void FMeshProcessingWorkerPool::ReleaseWorker(FWorkerProcess* Worker)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		Worker->bBusy = false;
+		if (Worker->bRetire)
+		{
+			if (Worker->IsStarted())
+			{
+				Worker->SetState(Local::EWorkerState::Shutdown);
+			}
+			StopProcess(*Worker, false);
+			Workers.RemoveAll([Worker](const TUniquePtr<FWorkerProcess>& Existing) { return Existing.Get() == Worker; });
+		}
+	}
+	WorkerReleasedEvent->Trigger();
+}
+
+
+bool FMeshProcessingWorkerPool::StartProcess(FWorkerProcess& Worker)
+{
+	uint32 WorkerID = NextWorkerID++;
+	Worker.ControlRegionName = FString::Printf(TEXT("MeshProcessingWorker_%u_%u"), FPlatformProcess::GetCurrentProcessId(), WorkerID);
+	Worker.ControlRegion = FPlatformMemory::MapNamedSharedMemoryRegion(Worker.ControlRegionName, true, Local::ReadWriteAccess, sizeof(Local::FControlBlock));
+	if (Worker.ControlRegion == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorkerPool: could not create the control region %s"), *Worker.ControlRegionName);
+		return false;
+	}
+	new (Worker.ControlRegion->GetAddress()) Local::FControlBlock();
+
+	Worker.WorkerSignal = Local::OpenSignal(Worker.ControlRegionName, TEXT("_W"), true);
+	Worker.HostSignal = Local::OpenSignal(Worker.ControlRegionName, TEXT("_H"), true);
+	if (Worker.WorkerSignal == nullptr || Worker.HostSignal == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorkerPool: could not create the semaphores of %s"), *Worker.ControlRegionName);
+		StopProcess(Worker, false);
+		return false;
+	}
+
+	FString Executable = Local::GetWorkerExecutable();
+	FString LogFile = FPaths::Combine(FPaths::ConvertRelativePathToFull(FPaths::ProjectLogDir()), FString::Printf(TEXT("MeshProcessingWorker_%u.log"), WorkerID));
+	FString Params = FString::Printf(TEXT("\"%s\" -run=MeshProcessingWorker -Control=%s -HostPID=%u -abslog=\"%s\" -nullrhi -unattended -nosplash -nosound -nopause"),
+		*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Worker.ControlRegionName, FPlatformProcess::GetCurrentProcessId(), *LogFile);
+	Worker.Process = FPlatformProcess::CreateProc(*Executable, *Params, false, true, true, &Worker.ProcessID, -1, nullptr, nullptr);
+	if (Worker.Process.IsValid() == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorkerPool: could not start %s"), *Executable);
+		StopProcess(Worker, false);
+		return false;
+	}
+
+	Worker.StartTime = FPlatformTime::Seconds();
+	NumStarted++;
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingWorkerPool: started worker process %u, log %s"), Worker.ProcessID, *LogFile);
+	return true;
+}
+
+
+void FMeshProcessingWorkerPool::StopProcess(FWorkerProcess& Worker, bool bTerminate)
+{
+	if (Worker.Process.IsValid())
+	{
+		if (bTerminate && FPlatformProcess::IsProcRunning(Worker.Process))
+		{
+			FPlatformProcess::TerminateProc(Worker.Process, true);
+		}
+		FPlatformProcess::CloseProc(Worker.Process);
+	}
+	if (Worker.ControlRegion != nullptr)
+	{
+		// a worker that crashed or was terminated while it held a result cannot release the result region itself
+		Local::UnlinkOrphanedRegion(Local::GetResultRegionName(Worker.ControlRegionName, Worker.GetControl()->Sequence));
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Worker.ControlRegion);
+		Worker.ControlRegion = nullptr;
+	}
+	for (FPlatformProcess::FSemaphore** Signal : { &Worker.WorkerSignal, &Worker.HostSignal })
+	{
+		if (*Signal != nullptr)
+		{
+			FPlatformProcess::DeleteInterprocessSynchObject(*Signal);
+			*Signal = nullptr;
+		}
+	}
+	Worker.ProcessID = 0;
+}
+
+
+void FMeshProcessingWorkerPool::Shutdown()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	// busy workers are stopped when their request completes
+	TArray<FWorkerProcess*> Stopping;
+	for (const TUniquePtr<FWorkerProcess>& Worker : Workers)
+	{
+		Worker->bRetire = true;
+		if (Worker->bBusy == false && Worker->IsStarted())
+		{
+			Worker->SetState(Local::EWorkerState::Shutdown);
+			Stopping.Add(Worker.Get());
+		}
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+	for (FWorkerProcess* Worker : Stopping)
+	{
+		while (FPlatformProcess::IsProcRunning(Worker->Process) && FPlatformTime::Seconds() - StartTime < Local::ShutdownGraceSeconds)
+		{
+			FPlatformProcess::Sleep(0.01f);
+		}
+		StopProcess(*Worker, true);
+	}
+	Workers.RemoveAll([](const TUniquePtr<FWorkerProcess>& Worker) { return Worker->bBusy == false; });
+}
+
+
+FMeshProcessingWorkerPool::FMetrics FMeshProcessingWorkerPool::GetMetrics() const
+{
+	FScopeLock ScopeLock(&Lock);
+	FMetrics Metrics;
+	for (const TUniquePtr<FWorkerProcess>& Worker : Workers)
+	{
+		Metrics.NumProcesses += (Worker->IsStarted()) ? 1 : 0;
+		Metrics.NumBusy += (Worker->bBusy) ? 1 : 0;
+	}
+	Metrics.NumStarted = NumStarted;
+	Metrics.NumCompleted = NumCompleted.load();
+	Metrics.NumFailed = NumFailed.load();
+	Metrics.NumCancelled = NumCancelled.load();
+	Metrics.NumTimedOut = NumTimedOut.load();
+	Metrics.NumCrashed = NumCrashed.load();
+	return Metrics;
+}
+
+
+int32 FMeshProcessingWorkerPool::RunWorker(const FString& ControlRegionName, uint32 HostProcessID)
+{
+	check(IsInGameThread());
+
+	FPlatformMemory::FSharedMemoryRegion* ControlRegion = FPlatformMemory::MapNamedSharedMemoryRegion(ControlRegionName, false, Local::ReadWriteAccess, sizeof(Local::FControlBlock));
+	Local::FControlBlock* Control = Local::GetControlBlock(ControlRegion);
+	if (Control == nullptr || Control->Magic != Local::ControlMagic)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorker: could not open the control region %s"), *ControlRegionName);
+		if (ControlRegion != nullptr)
+		{
+			FPlatformMemory::UnmapNamedSharedMemoryRegion(ControlRegion);
+		}
+		return 1;
+	}
+
+	FPlatformProcess::FSemaphore* WorkerSignal = Local::OpenSignal(ControlRegionName, TEXT("_W"), false);
+	FPlatformProcess::FSemaphore* HostSignal = Local::OpenSignal(ControlRegionName, TEXT("_H"), false);
+	if (WorkerSignal == nullptr || HostSignal == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Error, TEXT("MeshProcessingWorker: could not open the semaphores of %s"), *ControlRegionName);
+		for (FPlatformProcess::FSemaphore* Signal : { WorkerSignal, HostSignal })
+		{
+			if (Signal != nullptr)
+			{
+				FPlatformProcess::DeleteInterprocessSynchObject(Signal);
+			}
+		}
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(ControlRegion);
+		return 1;
+	}
+
+	Local::FWorkerLoop Loop;
+	Loop.Control = Control;
+	Loop.ControlRegionName = ControlRegionName;
+	Loop.HostSignal = HostSignal;
+	Loop.SetState(Local::EWorkerState::Idle);
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingWorker: waiting for requests on %s"), *ControlRegionName);
+
+	int32 NumRequests = 0;
+	double LastHostCheck = FPlatformTime::Seconds();
+	while (true)
+	{
+		Local::EWorkerState State = Control->GetState();
+		if (State == Local::EWorkerState::Shutdown)
+		{
+			break;
+		}
+		if (State == Local::EWorkerState::Idle)
+		{
+			Loop.ReleaseResult();
+		}
+		if (State == Local::EWorkerState::Request)
+		{
+			Loop.ExecuteRequest();
+			if (++NumRequests % Local::WorkerGarbageCollectInterval == 0)
+			{
+				CollectGarbage(RF_NoFlags);
+			}
+			continue;
+		}
+
+		double Now = FPlatformTime::Seconds();
+		if (HostProcessID != 0 && Now - LastHostCheck > Local::HostCheckIntervalSeconds)
+		{
+			if (FPlatformProcess::IsApplicationRunning(HostProcessID) == false)
+			{
+				UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingWorker: host process %u has exited"), HostProcessID);
+				break;
+			}
+			LastHostCheck = Now;
+		}
+		Local::WaitForSignal(WorkerSignal, Local::HostCheckIntervalSeconds);
+	}
+
+	UE_LOG(LogSampleModelingModeExtension, Display, TEXT("MeshProcessingWorker: exiting after %d requests"), NumRequests);
+	Loop.ReleaseResult();
+	Loop.Preset.Reset();
+	FPlatformProcess::DeleteInterprocessSynchObject(WorkerSignal);
+	FPlatformProcess::DeleteInterprocessSynchObject(HostSignal);
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(ControlRegion);
+	return 0;
+}
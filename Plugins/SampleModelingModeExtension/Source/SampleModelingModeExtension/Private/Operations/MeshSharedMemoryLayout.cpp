@@ -0,0 +1,583 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/MeshSharedMemoryLayout.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "Serialization/BufferReader.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Shared Memory Mesh Write"), STAT_MeshSharedMemoryLayout_Write, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Shared Memory Mesh Read"), STAT_MeshSharedMemoryLayout_Read, STATGROUP_SampleModelingModeExtension);
+
+
+namespace Local
+{
+
+static constexpr uint32 MeshBlockMagic = 0x4D534D4C;
+static constexpr uint32 MeshBlockVersion = 1;
+static constexpr int32 MaxUVLayers = 8;
+static constexpr int32 MaxNormalLayers = 3;
+static constexpr int32 MaxLayerNameLength = 64;
+static constexpr uint64 SectionAlignment = 16;
+
+enum class EMeshBlockFormat : uint32
+{
+	// raw per-ID arrays, see FMeshBlockSections
+	Flat,
+	// FDynamicMesh3 serialization, for meshes with attributes that the flat layout does not support
+	Archive
+};
+
+enum class EMeshBlockFlags : uint32
+{
+	None = 0,
+	VertexNormals = 1 << 0,
+	VertexColors = 1 << 1,
+	VertexUVs = 1 << 2,
+	TriangleGroups = 1 << 3,
+	Attributes = 1 << 4,
+	PrimaryColors = 1 << 5,
+	MaterialID = 1 << 6
+};
+ENUM_CLASS_FLAGS(EMeshBlockFlags);
+
+/**
+ * Header of a mesh block. The counts determine the offsets of all the sections, see GetSections().
+ */
+struct FMeshBlockHeader
+{
+	uint32 Magic = MeshBlockMagic;
+	uint32 Version = MeshBlockVersion;
+	EMeshBlockFormat Format = EMeshBlockFormat::Flat;
+	EMeshBlockFlags Flags = EMeshBlockFlags::None;
+	uint64 ArchiveSize = 0;
+	int32 MaxVertexID = 0;
+	int32 MaxTriangleID = 0;
+	int32 NumUVLayers = 0;
+	int32 NumNormalLayers = 0;
+	int32 NumPolygroupLayers = 0;
+	int32 UVElementCounts[MaxUVLayers] = {};
+	int32 NormalElementCounts[MaxNormalLayers] = {};
+	int32 ColorElementCount = 0;
+};
+
+/**
+ * Byte offsets of the sections of a flat mesh block. Each overlay has an element validity array, the element values, and the
+ * element triangles per triangle ID, which are invalid for unset triangles.
+ */
+struct FMeshBlockSections
+{
+	uint64 VertexValid = 0, Positions = 0, VertexNormals = 0, VertexColors = 0, VertexUVs = 0;
+	uint64 TriangleValid = 0, Triangles = 0, TriangleGroups = 0;
+	uint64 UVElementValid[MaxUVLayers] = {}, UVElements[MaxUVLayers] = {}, UVTriangles[MaxUVLayers] = {};
+	uint64 NormalElementValid[MaxNormalLayers] = {}, NormalElements[MaxNormalLayers] = {}, NormalTriangles[MaxNormalLayers] = {};
+	uint64 ColorElementValid = 0, ColorElements = 0, ColorTriangles = 0;
+	uint64 MaterialIDs = 0;
+	// NumPolygroupLayers names of MaxLayerNameLength, and NumPolygroupLayers consecutive arrays of MaxTriangleID values
+	uint64 PolygroupNames = 0, Polygroups = 0;
+	uint64 Size = 0;
+};
+
+static uint64 AlignSection(uint64 Offset)
+{
+	return (Offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+}
+
+static uint64 ArchiveOffset()
+{
+	return AlignSection(sizeof(FMeshBlockHeader));
+}
+
+/** @return the offsets of the sections of a flat mesh block, and its total size */
+static FMeshBlockSections GetSections(const FMeshBlockHeader& Header)
+{
+	FMeshBlockSections Sections;
+	uint64 Offset = sizeof(FMeshBlockHeader);
+	auto AddSection = [&Offset](uint64& SectionOffset, uint64 ElementSize, int64 Num)
+	{
+		SectionOffset = AlignSection(Offset);
+		Offset = SectionOffset + ElementSize * (uint64)FMath::Max<int64>(Num, 0);
+	};
+
+	const int64 NumV = Header.MaxVertexID;
+	const int64 NumT = Header.MaxTriangleID;
+	AddSection(Sections.VertexValid, sizeof(uint8), NumV);
+	AddSection(Sections.Positions, sizeof(FVector3d), NumV);
+	AddSection(Sections.VertexNormals, sizeof(FVector3f), EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::VertexNormals) ? NumV : 0);
+	AddSection(Sections.VertexColors, sizeof(FVector3f), EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::VertexColors) ? NumV : 0);
+	AddSection(Sections.VertexUVs, sizeof(FVector2f), EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::VertexUVs) ? NumV : 0);
+	AddSection(Sections.TriangleValid, sizeof(uint8), NumT);
+	AddSection(Sections.Triangles, sizeof(FIndex3i), NumT);
+	AddSection(Sections.TriangleGroups, sizeof(int32), EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::TriangleGroups) ? NumT : 0);
+	for (int32 k = 0; k < Header.NumUVLayers; ++k)
+	{
+		AddSection(Sections.UVElementValid[k], sizeof(uint8), Header.UVElementCounts[k]);
+		AddSection(Sections.UVElements[k], sizeof(FVector2f), Header.UVElementCounts[k]);
+		AddSection(Sections.UVTriangles[k], sizeof(FIndex3i), NumT);
+	}
+	for (int32 k = 0; k < Header.NumNormalLayers; ++k)
+	{
+		AddSection(Sections.NormalElementValid[k], sizeof(uint8), Header.NormalElementCounts[k]);
+		AddSection(Sections.NormalElements[k], sizeof(FVector3f), Header.NormalElementCounts[k]);
+		AddSection(Sections.NormalTriangles[k], sizeof(FIndex3i), NumT);
+	}
+	if (EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::PrimaryColors))
+	{
+		AddSection(Sections.ColorElementValid, sizeof(uint8), Header.ColorElementCount);
+		AddSection(Sections.ColorElements, sizeof(FVector4f), Header.ColorElementCount);
+		AddSection(Sections.ColorTriangles, sizeof(FIndex3i), NumT);
+	}
+	AddSection(Sections.MaterialIDs, sizeof(int32), EnumHasAnyFlags(Header.Flags, EMeshBlockFlags::MaterialID) ? NumT : 0);
+	AddSection(Sections.PolygroupNames, sizeof(TCHAR) * MaxLayerNameLength, Header.NumPolygroupLayers);
+	AddSection(Sections.Polygroups, sizeof(int32), (int64)Header.NumPolygroupLayers * NumT);
+	Sections.Size = Offset;
+	return Sections;
+}
+
+/**
+ * Fill the header for Mesh
+ * @return false if Mesh has attributes that the flat layout does not support, in which case the header selects the archive format
+ */
+static bool MakeHeader(const FDynamicMesh3& Mesh, FMeshBlockHeader& Header)
+{
+	Header = FMeshBlockHeader();
+	const FDynamicMeshAttributeSet* Attributes = Mesh.Attributes();
+	if (Attributes != nullptr && (Attributes->NumUVLayers() > MaxUVLayers || Attributes->NumNormalLayers() > MaxNormalLayers
+		|| Attributes->NumWeightLayers() > 0 || Attributes->NumAttachedAttributes() > 0))
+	{
+		Header.Format = EMeshBlockFormat::Archive;
+		return false;
+	}
+
+	Header.MaxVertexID = Mesh.MaxVertexID();
+	Header.MaxTriangleID = Mesh.MaxTriangleID();
+	if (Mesh.HasVertexNormals())
+	{
+		Header.Flags |= EMeshBlockFlags::VertexNormals;
+	}
+	if (Mesh.HasVertexColors())
+	{
+		Header.Flags |= EMeshBlockFlags::VertexColors;
+	}
+	if (Mesh.HasVertexUVs())
+	{
+		Header.Flags |= EMeshBlockFlags::VertexUVs;
+	}
+	if (Mesh.HasTriangleGroups())
+	{
+		Header.Flags |= EMeshBlockFlags::TriangleGroups;
+	}
+	if (Attributes != nullptr)
+	{
+		Header.Flags |= EMeshBlockFlags::Attributes;
+		Header.NumUVLayers = Attributes->NumUVLayers();
+		for (int32 k = 0; k < Header.NumUVLayers; ++k)
+		{
+			Header.UVElementCounts[k] = Attributes->GetUVLayer(k)->MaxElementID();
+		}
+		Header.NumNormalLayers = Attributes->NumNormalLayers();
+		for (int32 k = 0; k < Header.NumNormalLayers; ++k)
+		{
+			Header.NormalElementCounts[k] = Attributes->GetNormalLayer(k)->MaxElementID();
+		}
+		if (Attributes->HasPrimaryColors())
+		{
+			Header.Flags |= EMeshBlockFlags::PrimaryColors;
+			Header.ColorElementCount = Attributes->PrimaryColors()->MaxElementID();
+		}
+		if (Attributes->HasMaterialID())
+		{
+			Header.Flags |= EMeshBlockFlags::MaterialID;
+		}
+		Header.NumPolygroupLayers = Attributes->NumPolygroupLayers();
+	}
+	return true;
+}
+
+
+/**
+ * Archive that writes into a mapped shared memory region. With null Data, it only counts the bytes.
+ */
+class FSharedMemoryWriter : public FArchive
+{
+public:
+	FSharedMemoryWriter(uint8* DataIn, int64 CapacityIn)
+		: Data(DataIn), Capacity(CapacityIn)
+	{
+		SetIsSaving(true);
+	}
+
+	virtual void Serialize(void* V, int64 Length) override
+	{
+		if (Data != nullptr)
+		{
+			if (Offset + Length > Capacity)
+			{
+				SetError();
+				return;
+			}
+			FMemory::Memcpy(Data + Offset, V, Length);
+		}
+		Offset += Length;
+	}
+
+	virtual int64 Tell() override { return Offset; }
+	virtual int64 TotalSize() override { return Offset; }
+	virtual FString GetArchiveName() const override { return TEXT("FSharedMemoryWriter"); }
+
+	int64 GetOffset() const { return Offset; }
+
+protected:
+	uint8* Data = nullptr;
+	int64 Capacity = 0;
+	int64 Offset = 0;
+};
+
+
+template<typename OverlayType, typename ElementType>
+static void WriteOverlay(const OverlayType& Overlay, int32 MaxTriangleID, const uint8* TriangleValid, uint8* ElementValid, ElementType* Elements, FIndex3i* ElementTriangles)
+{
+	for (int32 ElementID = 0; ElementID < Overlay.MaxElementID(); ++ElementID)
+	{
+		ElementValid[ElementID] = (Overlay.IsElement(ElementID)) ? 1 : 0;
+		if (ElementValid[ElementID])
+		{
+			Elements[ElementID] = Overlay.GetElement(ElementID);
+		}
+		else
+		{
+			FMemory::Memzero(&Elements[ElementID], sizeof(ElementType));
+		}
+	}
+	for (int32 tid = 0; tid < MaxTriangleID; ++tid)
+	{
+		ElementTriangles[tid] = (TriangleValid[tid] && Overlay.IsSetTriangle(tid)) ? Overlay.GetTriangle(tid) : FIndex3i::Invalid();
+	}
+}
+
+template<typename OverlayType, typename ElementType>
+static bool ReadOverlay(OverlayType& Overlay, int32 MaxElementID, int32 MaxTriangleID, const uint8* TriangleValid, const uint8* ElementValid, const ElementType* Elements, const FIndex3i* ElementTriangles)
+{
+	Overlay.ClearElements();
+	Overlay.BeginUnsafeElementsInsert();
+	for (int32 ElementID = 0; ElementID < MaxElementID; ++ElementID)
+	{
+		if (ElementValid[ElementID])
+		{
+			Overlay.InsertElement(ElementID, &Elements[ElementID].X, true);
+		}
+	}
+	Overlay.EndUnsafeElementsInsert();
+
+	for (int32 tid = 0; tid < MaxTriangleID; ++tid)
+	{
+		const FIndex3i& Tri = ElementTriangles[tid];
+		if (TriangleValid[tid] && Tri.A != IndexConstants::InvalidID)
+		{
+			if (Overlay.IsElement(Tri.A) == false || Overlay.IsElement(Tri.B) == false || Overlay.IsElement(Tri.C) == false
+				|| Overlay.SetTriangle(tid, Tri) != EMeshResult::Ok)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+}
+
+
+uint64 FMeshSharedMemoryLayout::GetSize(const FDynamicMesh3& Mesh)
+{
+	Local::FMeshBlockHeader Header;
+	if (Local::MakeHeader(Mesh, Header) == false)
+	{
+		// serialization only reads the mesh, the archive interface is not const
+		Local::FSharedMemoryWriter Counter(nullptr, 0);
+		Counter << const_cast<FDynamicMesh3&>(Mesh);
+		return Local::ArchiveOffset() + (uint64)Counter.GetOffset();
+	}
+	return Local::GetSections(Header).Size;
+}
+
+
+bool FMeshSharedMemoryLayout::Write(const FDynamicMesh3& Mesh, uint8* Data, uint64 Size)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshSharedMemoryLayout_Write);
+
+	Local::FMeshBlockHeader Header;
+	if (Local::MakeHeader(Mesh, Header) == false)
+	{
+		if (Size < Local::ArchiveOffset())
+		{
+			return false;
+		}
+		Local::FSharedMemoryWriter Writer(Data + Local::ArchiveOffset(), (int64)(Size - Local::ArchiveOffset()));
+		Writer << const_cast<FDynamicMesh3&>(Mesh);
+		if (Writer.IsError())
+		{
+			return false;
+		}
+		Header.ArchiveSize = (uint64)Writer.GetOffset();
+		FMemory::Memcpy(Data, &Header, sizeof(Header));
+		return true;
+	}
+
+	const Local::FMeshBlockSections Sections = Local::GetSections(Header);
+	if (Sections.Size > Size)
+	{
+		return false;
+	}
+	FMemory::Memcpy(Data, &Header, sizeof(Header));
+
+	uint8* VertexValid = Data + Sections.VertexValid;
+	FVector3d* Positions = (FVector3d*)(Data + Sections.Positions);
+	FVector3f* VertexNormals = (FVector3f*)(Data + Sections.VertexNormals);
+	FVector3f* VertexColors = (FVector3f*)(Data + Sections.VertexColors);
+	FVector2f* VertexUVs = (FVector2f*)(Data + Sections.VertexUVs);
+	for (int32 vid = 0; vid < Header.MaxVertexID; ++vid)
+	{
+		bool bValid = Mesh.IsVertex(vid);
+		VertexValid[vid] = (bValid) ? 1 : 0;
+		Positions[vid] = (bValid) ? Mesh.GetVertex(vid) : FVector3d::Zero();
+		if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexNormals))
+		{
+			VertexNormals[vid] = (bValid) ? Mesh.GetVertexNormal(vid) : FVector3f::UnitZ();
+		}
+		if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexColors))
+		{
+			VertexColors[vid] = (bValid) ? Mesh.GetVertexColor(vid) : FVector3f::Zero();
+		}
+		if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexUVs))
+		{
+			VertexUVs[vid] = (bValid) ? Mesh.GetVertexUV(vid) : FVector2f::Zero();
+		}
+	}
+
+	uint8* TriangleValid = Data + Sections.TriangleValid;
+	FIndex3i* Triangles = (FIndex3i*)(Data + Sections.Triangles);
+	int32* TriangleGroups = (int32*)(Data + Sections.TriangleGroups);
+	for (int32 tid = 0; tid < Header.MaxTriangleID; ++tid)
+	{
+		bool bValid = Mesh.IsTriangle(tid);
+		TriangleValid[tid] = (bValid) ? 1 : 0;
+		Triangles[tid] = (bValid) ? Mesh.GetTriangle(tid) : FIndex3i::Invalid();
+		if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::TriangleGroups))
+		{
+			TriangleGroups[tid] = (bValid) ? Mesh.GetTriangleGroup(tid) : 0;
+		}
+	}
+
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::Attributes) == false)
+	{
+		return true;
+	}
+	const FDynamicMeshAttributeSet* Attributes = Mesh.Attributes();
+	for (int32 k = 0; k < Header.NumUVLayers; ++k)
+	{
+		Local::WriteOverlay(*Attributes->GetUVLayer(k), Header.MaxTriangleID, TriangleValid, Data + Sections.UVElementValid[k],
+			(FVector2f*)(Data + Sections.UVElements[k]), (FIndex3i*)(Data + Sections.UVTriangles[k]));
+	}
+	for (int32 k = 0; k < Header.NumNormalLayers; ++k)
+	{
+		Local::WriteOverlay(*Attributes->GetNormalLayer(k), Header.MaxTriangleID, TriangleValid, Data + Sections.NormalElementValid[k],
+			(FVector3f*)(Data + Sections.NormalElements[k]), (FIndex3i*)(Data + Sections.NormalTriangles[k]));
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::PrimaryColors))
+	{
+		Local::WriteOverlay(*Attributes->PrimaryColors(), Header.MaxTriangleID, TriangleValid, Data + Sections.ColorElementValid,
+			(FVector4f*)(Data + Sections.ColorElements), (FIndex3i*)(Data + Sections.ColorTriangles));
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::MaterialID))
+	{
+		int32* MaterialIDs = (int32*)(Data + Sections.MaterialIDs);
+		for (int32 tid = 0; tid < Header.MaxTriangleID; ++tid)
+		{
+			MaterialIDs[tid] = (TriangleValid[tid]) ? Attributes->GetMaterialID()->GetValue(tid) : 0;
+		}
+	}
+	for (int32 k = 0; k < Header.NumPolygroupLayers; ++k)
+	{
+		const FDynamicMeshPolygroupAttribute* Layer = Attributes->GetPolygroupLayer(k);
+		TCHAR* Name = (TCHAR*)(Data + Sections.PolygroupNames) + (int64)k * Local::MaxLayerNameLength;
+		FCString::Strncpy(Name, *Layer->GetName().ToString(), Local::MaxLayerNameLength);
+		int32* Groups = (int32*)(Data + Sections.Polygroups) + (int64)k * Header.MaxTriangleID;
+		for (int32 tid = 0; tid < Header.MaxTriangleID; ++tid)
+		{
+			Groups[tid] = (TriangleValid[tid]) ? Layer->GetValue(tid) : 0;
+		}
+	}
+	return true;
+}
+
+
+bool FMeshSharedMemoryLayout::Read(const uint8* Data, uint64 Size, FDynamicMesh3& MeshOut)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshSharedMemoryLayout_Read);
+
+	MeshOut.Clear();
+	if (Size < sizeof(Local::FMeshBlockHeader))
+	{
+		return false;
+	}
+	Local::FMeshBlockHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+	if (Header.Magic != Local::MeshBlockMagic || Header.Version != Local::MeshBlockVersion)
+	{
+		return false;
+	}
+
+	if (Header.Format == Local::EMeshBlockFormat::Archive)
+	{
+		if (Local::ArchiveOffset() + Header.ArchiveSize > Size)
+		{
+			return false;
+		}
+		FBufferReader Reader(const_cast<uint8*>(Data) + Local::ArchiveOffset(), (int64)Header.ArchiveSize, false);
+		Reader << MeshOut;
+		return (Reader.IsError() == false);
+	}
+
+	if (Header.MaxVertexID < 0 || Header.MaxTriangleID < 0 || Header.NumUVLayers < 0 || Header.NumUVLayers > Local::MaxUVLayers
+		|| Header.NumNormalLayers < 0 || Header.NumNormalLayers > Local::MaxNormalLayers || Header.NumPolygroupLayers < 0)
+	{
+		return false;
+	}
+	const Local::FMeshBlockSections Sections = Local::GetSections(Header);
+	if (Sections.Size > Size)
+	{
+		return false;
+	}
+
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexNormals))
+	{
+		MeshOut.EnableVertexNormals(FVector3f::UnitZ());
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexColors))
+	{
+		MeshOut.EnableVertexColors(FVector3f::Zero());
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexUVs))
+	{
+		MeshOut.EnableVertexUVs(FVector2f::Zero());
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::TriangleGroups))
+	{
+		MeshOut.EnableTriangleGroups(0);
+	}
+
+	// insert with the original IDs, so that a non-compact mesh keeps its holes
+	const uint8* VertexValid = Data + Sections.VertexValid;
+	const FVector3d* Positions = (const FVector3d*)(Data + Sections.Positions);
+	const FVector3f* VertexNormals = (const FVector3f*)(Data + Sections.VertexNormals);
+	const FVector3f* VertexColors = (const FVector3f*)(Data + Sections.VertexColors);
+	const FVector2f* VertexUVs = (const FVector2f*)(Data + Sections.VertexUVs);
+	MeshOut.BeginUnsafeVerticesInsert();
+	for (int32 vid = 0; vid < Header.MaxVertexID; ++vid)
+	{
+		if (VertexValid[vid])
+		{
+			FVertexInfo VertexInfo(Positions[vid]);
+			if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexNormals))
+			{
+				VertexInfo.bHaveN = true;
+				VertexInfo.Normal = VertexNormals[vid];
+			}
+			if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexColors))
+			{
+				VertexInfo.bHaveC = true;
+				VertexInfo.Color = VertexColors[vid];
+			}
+			if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::VertexUVs))
+			{
+				VertexInfo.bHaveUV = true;
+				VertexInfo.UV = VertexUVs[vid];
+			}
+			MeshOut.InsertVertex(vid, VertexInfo, true);
+		}
+	}
+	MeshOut.EndUnsafeVerticesInsert();
+
+	const uint8* TriangleValid = Data + Sections.TriangleValid;
+	const FIndex3i* Triangles = (const FIndex3i*)(Data + Sections.Triangles);
+	const int32* TriangleGroups = (const int32*)(Data + Sections.TriangleGroups);
+	bool bTrianglesValid = true;
+	MeshOut.BeginUnsafeTrianglesInsert();
+	for (int32 tid = 0; tid < Header.MaxTriangleID && bTrianglesValid; ++tid)
+	{
+		if (TriangleValid[tid])
+		{
+			int32 GroupID = EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::TriangleGroups) ? TriangleGroups[tid] : 0;
+			bTrianglesValid = (MeshOut.InsertTriangle(tid, Triangles[tid], GroupID, true) == EMeshResult::Ok);
+		}
+	}
+	MeshOut.EndUnsafeTrianglesInsert();
+	if (bTrianglesValid == false)
+	{
+		MeshOut.Clear();
+		return false;
+	}
+
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::Attributes) == false)
+	{
+		return true;
+	}
+	MeshOut.EnableAttributes();
+	FDynamicMeshAttributeSet* Attributes = MeshOut.Attributes();
+	bool bAttributesValid = true;
+	Attributes->SetNumUVLayers(Header.NumUVLayers);
+	for (int32 k = 0; k < Header.NumUVLayers && bAttributesValid; ++k)
+	{
+		bAttributesValid = Local::ReadOverlay(*Attributes->GetUVLayer(k), Header.UVElementCounts[k], Header.MaxTriangleID, TriangleValid,
+			Data + Sections.UVElementValid[k], (const FVector2f*)(Data + Sections.UVElements[k]), (const FIndex3i*)(Data + Sections.UVTriangles[k]));
+	}
+	Attributes->SetNumNormalLayers(Header.NumNormalLayers);
+	for (int32 k = 0; k < Header.NumNormalLayers && bAttributesValid; ++k)
+	{
+		bAttributesValid = Local::ReadOverlay(*Attributes->GetNormalLayer(k), Header.NormalElementCounts[k], Header.MaxTriangleID, TriangleValid,
+			Data + Sections.NormalElementValid[k], (const FVector3f*)(Data + Sections.NormalElements[k]), (const FIndex3i*)(Data + Sections.NormalTriangles[k]));
+	}
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::PrimaryColors) && bAttributesValid)
+	{
+		Attributes->EnablePrimaryColors();
+		bAttributesValid = Local::ReadOverlay(*Attributes->PrimaryColors(), Header.ColorElementCount, Header.MaxTriangleID, TriangleValid,
+			Data + Sections.ColorElementValid, (const FVector4f*)(Data + Sections.ColorElements), (const FIndex3i*)(Data + Sections.ColorTriangles));
+	}
+	if (bAttributesValid == false)
+	{
+		MeshOut.Clear();
+		return false;
+	}
+
+	if (EnumHasAnyFlags(Header.Flags, Local::EMeshBlockFlags::MaterialID))
+	{
+		Attributes->EnableMaterialID();
+		const int32* MaterialIDs = (const int32*)(Data + Sections.MaterialIDs);
+		for (int32 tid = 0; tid < Header.MaxTriangleID; ++tid)
+		{
+			if (TriangleValid[tid])
+			{
+				Attributes->GetMaterialID()->SetValue(tid, MaterialIDs[tid]);
+			}
+		}
+	}
+	Attributes->SetNumPolygroupLayers(Header.NumPolygroupLayers);
+	for (int32 k = 0; k < Header.NumPolygroupLayers; ++k)
+	{
+		FDynamicMeshPolygroupAttribute* Layer = Attributes->GetPolygroupLayer(k);
+		TCHAR Name[Local::MaxLayerNameLength];
+		FCString::Strncpy(Name, (const TCHAR*)(Data + Sections.PolygroupNames) + (int64)k * Local::MaxLayerNameLength, Local::MaxLayerNameLength);
+		Layer->SetName(FName(Name));
+		const int32* Groups = (const int32*)(Data + Sections.Polygroups) + (int64)k * Header.MaxTriangleID;
+		for (int32 tid = 0; tid < Header.MaxTriangleID; ++tid)
+		{
+			if (TriangleValid[tid])
+			{
+				Layer->SetValue(tid, Groups[tid]);
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/PerlinNoise.h"
+
+using namespace UE::Geometry;
+
+namespace Local
+{
+
+// the permutation of the reference implementation of improved Perlin noise
+static const uint8 Permutation[256] = {
+	151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,190,6,148,
+	247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,
+	74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,102,143,54,
+	65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,
+	52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,
+	119,248,152,2,44,154,163,70,221,153,101,155,167,43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,
+	218,246,97,228,251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,
+	184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+static FORCEINLINE int32 Hash(int32 Value)
+{
+	return Permutation[Value & 255];
+}
+
+// the gradient direction of a lattice corner, ie the reference grad(Hash, x, y, z) is the dot product of this with (x, y, z)
+static FORCEINLINE FVector3d GetCornerGradient(int32 CornerHash)
+{
+	int32 h = CornerHash & 15;
+	int32 UAxis = (h < 8) ? 0 : 1;
+	int32 VAxis = (h < 4) ? 1 : ((h == 12 || h == 14) ? 0 : 2);
+	FVector3d Gradient = FVector3d::Zero();
+	Gradient[UAxis] += (h & 1) ? -1.0 : 1.0;
+	Gradient[VAxis] += (h & 2) ? -1.0 : 1.0;
+	return Gradient;
+}
+
+static FORCEINLINE double Fade(double t)
+{
+	return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+
+static FORCEINLINE double FadeDerivative(double t)
+{
+	return 30.0 * t * t * (t * (t - 2.0) + 1.0);
+}
+
+template<bool bGradient>
+static double EvaluateNoise(const FVector3d& Position, FVector3d* GradientOut)
+{
+	double FloorX = FMathd::Floor(Position.X), FloorY = FMathd::Floor(Position.Y), FloorZ = FMathd::Floor(Position.Z);
+	int32 X = (int32)(int64)FloorX & 255, Y = (int32)(int64)FloorY & 255, Z = (int32)(int64)FloorZ & 255;
+	FVector3d Offset(Position.X - FloorX, Position.Y - FloorY, Position.Z - FloorZ);
+	FVector3d Fades(Fade(Offset.X), Fade(Offset.Y), Fade(Offset.Z));
+
+	// trilinear blend of the corner contributions G.(p - c), with the fade curves as blend weights
+	double Value = 0;
+	FVector3d Gradient = FVector3d::Zero();
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		int32 cx = Corner & 1, cy = (Corner >> 1) & 1, cz = (Corner >> 2) & 1;
+		FVector3d CornerGradient = GetCornerGradient(Hash(Hash(Hash(X + cx) + Y + cy) + Z + cz));
+		double Contribution = CornerGradient.Dot(Offset - FVector3d((double)cx, (double)cy, (double)cz));
+
+		double WeightX = (cx) ? Fades.X : 1.0 - Fades.X;
+		double WeightY = (cy) ? Fades.Y : 1.0 - Fades.Y;
+		double WeightZ = (cz) ? Fades.Z : 1.0 - Fades.Z;
+		double Weight = WeightX * WeightY * WeightZ;
+		Value += Weight * Contribution;
+
+		if (bGradient)
+		{
+			FVector3d WeightGradient(
+				((cx) ? 1.0 : -1.0) * FadeDerivative(Offset.X) * WeightY * WeightZ,
+				((cy) ? 1.0 : -1.0) * FadeDerivative(Offset.Y) * WeightX * WeightZ,
+				((cz) ? 1.0 : -1.0) * FadeDerivative(Offset.Z) * WeightX * WeightY);
+			Gradient += WeightGradient * Contribution + Weight * CornerGradient;
+		}
+	}
+
+	if (bGradient)
+	{
+		*GradientOut = Gradient;
+	}
+	return Value;
+}
+
+}
+
+
+double FPerlinNoise::Evaluate(const FVector3d& Position)
+{
+	return Local::EvaluateNoise<false>(Position, nullptr);
+}
+
+
+double FPerlinNoise::EvaluateWithGradient(const FVector3d& Position, FVector3d& GradientOut)
+{
+	return Local::EvaluateNoise<true>(Position, &GradientOut);
+}
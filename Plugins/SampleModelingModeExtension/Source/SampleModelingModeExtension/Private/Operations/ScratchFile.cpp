@@ -0,0 +1,172 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/ScratchFile.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace Local
+{
+
+// mapped windows start at a multiple of this
+static uint64 GetMappingGranularity()
+{
+	const FPlatformMemoryConstants& Constants = FPlatformMemory::GetConstants();
+	return (uint64)FMath::Max<SIZE_T>(1, FMath::Max<SIZE_T>(Constants.PageSize, Constants.OsAllocationGranularity));
+}
+
+}
+
+
+FScratchFile::~FScratchFile()
+{
+	Close();
+}
+
+
+FString FScratchFile::GetDefaultDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MeshProcessingScratch"));
+}
+
+
+bool FScratchFile::Create(const FString& Directory, uint64 Size)
+{
+	Close();
+	if (Size == 0)
+	{
+		return false;
+	}
+	IFileManager::Get().MakeDirectory(*Directory, true);
+	Path = FPaths::ConvertRelativePathToFull(FPaths::Combine(Directory, FGuid::NewGuid().ToString() + TEXT(".scratch")));
+
+#if PLATFORM_WINDOWS
+	// the file is deleted by the system when its handle is closed, including when the editor crashes
+	HANDLE File = CreateFileW(*Path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+	if (File != INVALID_HANDLE_VALUE)
+	{
+		FileHandle = File;
+		// creating the mapping extends the file to Size
+		MappingHandle = CreateFileMappingW(File, nullptr, PAGE_READWRITE, (DWORD)(Size >> 32), (DWORD)(Size & 0xFFFFFFFF), nullptr);
+	}
+	bool bCreated = (MappingHandle != nullptr);
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	FileDescriptor = open(TCHAR_TO_UTF8(*Path), O_RDWR | O_CREAT | O_EXCL, 0600);
+	bool bCreated = false;
+	if (FileDescriptor >= 0)
+	{
+		// the open descriptor keeps the file alive, so it is unlinked right away and never left behind by a crash
+		unlink(TCHAR_TO_UTF8(*Path));
+#if PLATFORM_LINUX
+		// reserve the blocks, otherwise a full disk would only show up as a fault when a mapped page is written
+		bCreated = (posix_fallocate(FileDescriptor, 0, (off_t)Size) == 0);
+#else
+		bCreated = (ftruncate(FileDescriptor, (off_t)Size) == 0);
+#endif
+	}
+#else
+	bool bCreated = false;
+#endif
+
+	if (bCreated == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("ScratchFile: could not create %s of %llu bytes"), *Path, Size);
+		Close();
+		return false;
+	}
+	FileSize = Size;
+	return true;
+}
+
+
+uint8* FScratchFile::MapWindow(uint64 Offset, uint64 Size)
+{
+	UnmapWindow();
+	if (IsValid() == false || Size == 0 || Offset + Size > FileSize)
+	{
+		return nullptr;
+	}
+
+	uint64 Granularity = Local::GetMappingGranularity();
+	uint64 MappedOffset = Offset - (Offset % Granularity);
+	uint64 UseMappedSize = Size + (Offset - MappedOffset);
+
+#if PLATFORM_WINDOWS
+	void* Mapped = MapViewOfFile((HANDLE)MappingHandle, FILE_MAP_ALL_ACCESS, (DWORD)(MappedOffset >> 32), (DWORD)(MappedOffset & 0xFFFFFFFF), (SIZE_T)UseMappedSize);
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	void* Mapped = mmap(nullptr, (size_t)UseMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, (off_t)MappedOffset);
+	if (Mapped == MAP_FAILED)
+	{
+		Mapped = nullptr;
+	}
+#else
+	void* Mapped = nullptr;
+#endif
+
+	if (Mapped == nullptr)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("ScratchFile: could not map %llu bytes at %llu of %s"), Size, Offset, *Path);
+		return nullptr;
+	}
+	MappedBase = (uint8*)Mapped;
+	MappedSize = UseMappedSize;
+	WindowSize = Size;
+	return MappedBase + (Offset - MappedOffset);
+}
+
+
+void FScratchFile::UnmapWindow()
+{
+	if (MappedBase == nullptr)
+	{
+		return;
+	}
+	// the dirty pages are written back to the file by the system, they no longer count against the process
+#if PLATFORM_WINDOWS
+	UnmapViewOfFile(MappedBase);
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	munmap(MappedBase, (size_t)MappedSize);
+#endif
+	MappedBase = nullptr;
+	MappedSize = 0;
+	WindowSize = 0;
+}
+
+
+void FScratchFile::Close()
+{
+	UnmapWindow();
+#if PLATFORM_WINDOWS
+	if (MappingHandle != nullptr)
+	{
+		CloseHandle((HANDLE)MappingHandle);
+	}
+	if (FileHandle != nullptr)
+	{
+		CloseHandle((HANDLE)FileHandle);
+	}
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	if (FileDescriptor >= 0)
+	{
+		close(FileDescriptor);
+	}
+#endif
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+	FileDescriptor = -1;
+	FileSize = 0;
+}
@@ -0,0 +1,329 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Operations/TessellationDiskCache.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/BufferReader.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Tessellation Disk Cache Load"), STAT_TessellationDiskCache_Load, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Tessellation Disk Cache Store"), STAT_TessellationDiskCache_Store, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tessellation Disk Cache Hits"), STAT_TessellationDiskCache_Hits, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tessellation Disk Cache Misses"), STAT_TessellationDiskCache_Misses, STATGROUP_SampleModelingModeExtension);
+
+
+namespace Local
+{
+
+static constexpr uint32 EntryMagic = 0x53534554;
+// increment when the entry layout, the mesh serialization or the tessellation changes, older entries are then ignored and evicted
+static constexpr uint32 EntryVersion = 1;
+static const TCHAR* EntryExtension = TEXT(".tess");
+static const TCHAR* TempExtension = TEXT(".tmp");
+// temporary files this old are left over from a write that did not complete
+static const FTimespan StaleTempFileAge = FTimespan::FromHours(1.0);
+
+// smaller tessellations are computed faster than they are read
+static constexpr int64 MinCachedTriangles = 200000;
+
+struct FEntryHeader
+{
+	uint32 Magic = EntryMagic;
+	uint32 Version = EntryVersion;
+	uint64 MeshHash = 0;
+	int32 Subdivisions = 0;
+	int32 NumVertexNormals = 0;
+};
+
+
+/**
+ * Archive that hashes the serialized data instead of storing it
+ */
+class FHashArchive : public FArchive
+{
+public:
+	FHashArchive()
+	{
+		SetIsSaving(true);
+	}
+
+	virtual void Serialize(void* V, int64 Length) override
+	{
+		const char* Data = (const char*)V;
+		while (Length > 0)
+		{
+			uint32 ChunkLength = (uint32)FMath::Min<int64>(Length, MAX_int32);
+			Hash = CityHash64WithSeed(Data, ChunkLength, Hash);
+			Data += ChunkLength;
+			Length -= ChunkLength;
+		}
+	}
+
+	virtual FString GetArchiveName() const override { return TEXT("FHashArchive"); }
+
+	uint64 Hash = 0;
+};
+
+
+// @return false if Data is not a valid entry for the key
+static bool ReadEntry(const uint8* Data, int64 Size, uint64 MeshHash, int32 Subdivisions, FDynamicMesh3& MeshOut, TArray<FVector3d>& VertexNormalsOut)
+{
+	FEntryHeader Header;
+	if (Size < (int64)sizeof(FEntryHeader))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&Header, Data, sizeof(FEntryHeader));
+	if (Header.Magic != EntryMagic || Header.Version != EntryVersion || Header.MeshHash != MeshHash || Header.Subdivisions != Subdivisions)
+	{
+		return false;
+	}
+
+	FBufferReader Reader(const_cast<uint8*>(Data), Size, false);
+	Reader.Seek(sizeof(FEntryHeader));
+	Reader << MeshOut;
+	int64 NormalsBytes = (int64)Header.NumVertexNormals * (int64)sizeof(FVector3d);
+	if (Reader.IsError() || Header.NumVertexNormals != MeshOut.MaxVertexID() || Reader.Tell() + NormalsBytes != Size)
+	{
+		return false;
+	}
+	VertexNormalsOut.SetNumUninitialized(Header.NumVertexNormals);
+	Reader.Serialize(VertexNormalsOut.GetData(), NormalsBytes);
+	return Reader.IsError() == false;
+}
+
+}
+
+
+FTessellationDiskCache& FTessellationDiskCache::Get()
+{
+	static FTessellationDiskCache Cache;
+	return Cache;
+}
+
+
+bool FTessellationDiskCache::IsEnabled()
+{
+	return GetDefault<USampleModelingModeExtensionSettings>()->TessellationDiskCacheLimitMB > 0;
+}
+
+
+bool FTessellationDiskCache::IsWorthCaching(int64 NumInputTriangles, int32 Subdivisions)
+{
+	return Subdivisions > 0 && NumInputTriangles * (int64)(Subdivisions + 1) * (int64)(Subdivisions + 1) >= Local::MinCachedTriangles;
+}
+
+
+uint64 FTessellationDiskCache::HashMesh(const FDynamicMesh3& Mesh)
+{
+	// serialization only reads the mesh, the archive interface is not const
+	Local::FHashArchive Archive;
+	Archive << const_cast<FDynamicMesh3&>(Mesh);
+	return (Archive.Hash != 0) ? Archive.Hash : 1;
+}
+
+
+FString FTessellationDiskCache::GetCacheDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MeshProcessingCache"), TEXT("Tessellation"));
+}
+
+
+FString FTessellationDiskCache::GetEntryPath(uint64 MeshHash, int32 Subdivisions)
+{
+	return FPaths::Combine(GetCacheDirectory(), FString::Printf(TEXT("%016llx_%d%s"), MeshHash, Subdivisions, Local::EntryExtension));
+}
+
+
+bool FTessellationDiskCache::Load(uint64 MeshHash, int32 Subdivisions, FDynamicMesh3& MeshOut, TArray<FVector3d>& VertexNormalsOut)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_TessellationDiskCache_Load);
+
+	FString Path = GetEntryPath(MeshHash, Subdivisions);
+	bool bFound = false, bValid = false;
+	{
+		// the region must be unmapped before the file, so it is declared after it
+		TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+		TUniquePtr<IMappedFileRegion> MappedRegion((MappedFile.IsValid()) ? MappedFile->MapRegion(0, MappedFile->GetFileSize()) : nullptr);
+		if (MappedRegion.IsValid())
+		{
+			bFound = true;
+			bValid = Local::ReadEntry(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), MeshHash, Subdivisions, MeshOut, VertexNormalsOut);
+		}
+		else if (MappedFile.IsValid() == false && IFileManager::Get().FileExists(*Path))
+		{
+			// not all platform file layers support mapping
+			TArray64<uint8> Data;
+			bFound = FFileHelper::LoadFileToArray(Data, *Path);
+			bValid = bFound && Local::ReadEntry(Data.GetData(), Data.Num(), MeshHash, Subdivisions, MeshOut, VertexNormalsOut);
+		}
+	}
+
+	if (bValid == false)
+	{
+		if (bFound)
+		{
+			UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("TessellationDiskCache: deleting invalid entry %s"), *Path);
+			IFileManager::Get().Delete(*Path, false, false, true);
+		}
+		MeshOut.Clear();
+		VertexNormalsOut.Reset();
+		NumMisses++;
+		INC_DWORD_STAT(STAT_TessellationDiskCache_Misses);
+		return false;
+	}
+
+	// the modification time orders the entries for eviction
+	IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+	NumHits++;
+	INC_DWORD_STAT(STAT_TessellationDiskCache_Hits);
+	return true;
+}
+
+
+void FTessellationDiskCache::StoreAsync(uint64 MeshHash, int32 Subdivisions, TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Mesh,
+	TSharedPtr<const TArray<FVector3d>, ESPMode::ThreadSafe> VertexNormals)
+{
+	if (!ensure(Mesh.IsValid() && VertexNormals.IsValid()))
+	{
+		return;
+	}
+
+	FString Path = GetEntryPath(MeshHash, Subdivisions);
+	FScopeLock ScopeLock(&Lock);
+	PendingStores.RemoveAll([](const TFuture<void>& Pending) { return Pending.IsReady(); });
+	if (StoresInFlight.Contains(Path))
+	{
+		return;
+	}
+	StoresInFlight.Add(Path);
+	PendingStores.Add(Async(EAsyncExecution::ThreadPool, [this, Path, MeshHash, Subdivisions, Mesh, VertexNormals]()
+	{
+		Store(Path, MeshHash, Subdivisions, *Mesh, *VertexNormals);
+		FScopeLock StoreScopeLock(&Lock);
+		StoresInFlight.Remove(Path);
+	}));
+}
+
+
+void FTessellationDiskCache::Store(const FString& Path, uint64 MeshHash, int32 Subdivisions, const FDynamicMesh3& Mesh, const TArray<FVector3d>& VertexNormals)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_TessellationDiskCache_Store);
+
+	// eg written by another Tool invocation that missed at the same time
+	if (IFileManager::Get().FileExists(*Path))
+	{
+		return;
+	}
+
+	// the entry is written to a temporary file and then renamed, so that a partial entry is never read
+	FString TempPath = FString::Printf(TEXT("%s.%s%s"), *Path, *FGuid::NewGuid().ToString(), Local::TempExtension);
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+	if (Writer.IsValid() == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("TessellationDiskCache: could not write %s"), *TempPath);
+		return;
+	}
+
+	Local::FEntryHeader Header;
+	Header.MeshHash = MeshHash;
+	Header.Subdivisions = Subdivisions;
+	Header.NumVertexNormals = VertexNormals.Num();
+	Writer->Serialize(&Header, sizeof(Header));
+	*Writer << const_cast<FDynamicMesh3&>(Mesh);
+	Writer->Serialize(const_cast<FVector3d*>(VertexNormals.GetData()), (int64)VertexNormals.Num() * (int64)sizeof(FVector3d));
+	bool bWritten = Writer->Close();
+	Writer.Reset();
+
+	if (bWritten == false || IFileManager::Get().Move(*Path, *TempPath, true, true) == false)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("TessellationDiskCache: could not write %s"), *Path);
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return;
+	}
+
+	Trim();
+}
+
+
+void FTessellationDiskCache::Trim()
+{
+	struct FEntryFile
+	{
+		FString Path;
+		int64 Size = 0;
+		FDateTime LastUsed;
+	};
+	TArray<FEntryFile> Entries;
+	int64 TotalSize = 0;
+	FDateTime StaleTime = FDateTime::UtcNow() - Local::StaleTempFileAge;
+	IFileManager::Get().IterateDirectoryStat(*GetCacheDirectory(), [&Entries, &TotalSize, StaleTime](const TCHAR* Filename, const FFileStatData& StatData)
+	{
+		FString Path(Filename);
+		if (StatData.bIsDirectory)
+		{
+			return true;
+		}
+		if (Path.EndsWith(Local::EntryExtension))
+		{
+			Entries.Add({ Path, StatData.FileSize, StatData.ModificationTime });
+			TotalSize += StatData.FileSize;
+		}
+		else if (Path.EndsWith(Local::TempExtension) && StatData.ModificationTime < StaleTime)
+		{
+			IFileManager::Get().Delete(*Path, false, false, true);
+		}
+		return true;
+	});
+
+	int64 SizeLimit = (int64)FMath::Max(0, GetDefault<USampleModelingModeExtensionSettings>()->TessellationDiskCacheLimitMB) * 1024 * 1024;
+	if (TotalSize <= SizeLimit)
+	{
+		return;
+	}
+
+	Entries.Sort([](const FEntryFile& A, const FEntryFile& B) { return A.LastUsed < B.LastUsed; });
+	for (const FEntryFile& Entry : Entries)
+	{
+		if (TotalSize <= SizeLimit)
+		{
+			break;
+		}
+		if (IFileManager::Get().Delete(*Entry.Path, false, false, true))
+		{
+			TotalSize -= Entry.Size;
+		}
+	}
+}
+
+
+void FTessellationDiskCache::Flush()
+{
+	TArray<TFuture<void>> Pending;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Pending = MoveTemp(PendingStores);
+	}
+	for (TFuture<void>& PendingStore : Pending)
+	{
+		PendingStore.Wait();
+	}
+}
+
+
+void FTessellationDiskCache::Clear()
+{
+	Flush();
+	IFileManager::Get().DeleteDirectory(*GetCacheDirectory(), false, true);
+}
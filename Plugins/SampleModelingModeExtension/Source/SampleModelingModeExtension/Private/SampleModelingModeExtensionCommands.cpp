@@ -15,7 +15,7 @@ FSampleModelingModeExtensionCommands::FSampleModelingModeExtensionCommands() :
 		"SampleModelingModeExtensionCommands", // Context name for fast lookup
 		NSLOCTEXT("Contexts", "SampleModelingModeExtensionCommands", "Sample Modeling Mode Extension"), // Localized context name for displaying
 		NAME_None, // Parent
-		FSampleModelingModeExtensionStyle::Get()->GetStyleSetName() // Icon Style Set
+		FSampleModelingModeExtensionStyle::GetStyleSetName() // Icon Style Set, which is registered separately
 		)
 {
 }
@@ -9,27 +9,60 @@
 #include "Tools/MeshPlaneCutTool.h"
 #include "Tools/ActorClickedBPTool.h"
 #include "Tools/MeshProcessingBPTool.h"
+#include "Tools/ToolInputMeshCache.h"
+#include "Operations/MeshProcessingComputePool.h"
+#include "Operations/MeshProcessingWorkerPool.h"
+#include "Operations/TessellationDiskCache.h"
 
 #define LOCTEXT_NAMESPACE "FSampleModelingModeExtensionModule"
 
+DEFINE_LOG_CATEGORY(LogSampleModelingModeExtension);
+
+UE_TRACE_CHANNEL_DEFINE(SampleModelingModeExtensionChannel);
+
+DECLARE_CYCLE_STAT(TEXT("Module Startup"), STAT_SampleModelingModeExtension_Startup, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Extension Tools Initialization"), STAT_SampleModelingModeExtension_InitializeTools, STATGROUP_SampleModelingModeExtension);
 
 
 // IModuleInterface API implementation
 
 void FSampleModelingModeExtensionModule::StartupModule()
 {
-	FSampleModelingModeExtensionStyle::Initialize();
-	FSampleModelingModeExtensionCommands::Register();
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_SampleModelingModeExtension_Startup);
+	double StartTime = FPlatformTime::Seconds();
 
+	// everything else is initialized by the first GetExtensionTools() query
 	IModularFeatures::Get().RegisterModularFeature(IModelingModeToolExtension::GetModularFeatureName(), this);
+
+	UE_LOG(LogSampleModelingModeExtension, Log, TEXT("Module startup took %.2f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
 void FSampleModelingModeExtensionModule::ShutdownModule()
 {
 	IModularFeatures::Get().UnregisterModularFeature(IModelingModeToolExtension::GetModularFeatureName(), this);
 
-	FSampleModelingModeExtensionCommands::Unregister();
-	FSampleModelingModeExtensionStyle::Shutdown();
+	FMeshProcessingComputePool::Get().Shutdown();
+	FMeshProcessingWorkerPool::Get().Shutdown();
+	// the compute pool has finished, so no new writes are queued
+	FTessellationDiskCache::Get().Flush();
+	FToolInputMeshCache::Get().Reset();
+
+	if (bExtensionToolsInitialized)
+	{
+		// the UObject system may already be gone on editor exit, in which case the Builders have been destroyed with it
+		if (UObjectInitialized())
+		{
+			for (FExtensionToolDescription& ToolInfo : ExtensionTools)
+			{
+				ToolInfo.ToolBuilder->RemoveFromRoot();
+			}
+		}
+		ExtensionTools.Reset();
+
+		FSampleModelingModeExtensionCommands::Unregister();
+		FSampleModelingModeExtensionStyle::Shutdown();
+		bExtensionToolsInitialized = false;
+	}
 }
 
 
@@ -48,30 +81,55 @@ FText FSampleModelingModeExtensionModule::GetToolSectionName()
 
 void FSampleModelingModeExtensionModule::GetExtensionTools(const FExtensionToolQueryInfo& QueryInfo, TArray<FExtensionToolDescription>& ToolsOut)
 {
+	InitializeExtensionTools();
+	ToolsOut.Append(ExtensionTools);
+}
+
+
+void FSampleModelingModeExtensionModule::InitializeExtensionTools()
+{
+	if (bExtensionToolsInitialized)
+	{
+		return;
+	}
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_SampleModelingModeExtension_InitializeTools);
+	double StartTime = FPlatformTime::Seconds();
+
+	FSampleModelingModeExtensionStyle::Initialize();
+	FSampleModelingModeExtensionCommands::Register();
+
 	FExtensionToolDescription MeshNoiseToolInfo;
 	MeshNoiseToolInfo.ToolName = LOCTEXT("MeshNoiseTool", "MeshNoise");
 	MeshNoiseToolInfo.ToolCommand = FSampleModelingModeExtensionCommands::Get().BeginMeshNoiseTool;
 	MeshNoiseToolInfo.ToolBuilder = NewObject<UMeshNoiseToolBuilder>();
-	ToolsOut.Add(MeshNoiseToolInfo);
+	ExtensionTools.Add(MeshNoiseToolInfo);
 
 	FExtensionToolDescription MeshPlaneCutToolInfo;
 	MeshPlaneCutToolInfo.ToolName = LOCTEXT("MeshPlaneCut", "PlaneCut");
 	MeshPlaneCutToolInfo.ToolCommand = FSampleModelingModeExtensionCommands::Get().BeginMeshPlaneCutTool;
 	MeshPlaneCutToolInfo.ToolBuilder = NewObject<UMeshPlaneCutToolBuilder>();
-	ToolsOut.Add(MeshPlaneCutToolInfo);
+	ExtensionTools.Add(MeshPlaneCutToolInfo);
 
 	FExtensionToolDescription BPActionToolInfo;
 	BPActionToolInfo.ToolName = LOCTEXT("ActorClickedBPTool", "ActorClickedBP");
 	BPActionToolInfo.ToolCommand = FSampleModelingModeExtensionCommands::Get().BeginActorClickedBPTool;
 	BPActionToolInfo.ToolBuilder = NewObject<UActorClickedBPToolBuilder>();
-	ToolsOut.Add(BPActionToolInfo);
+	ExtensionTools.Add(BPActionToolInfo);
 
 	FExtensionToolDescription MeshProcessingBPToolInfo;
 	MeshProcessingBPToolInfo.ToolName = LOCTEXT("MeshProcessingBPTool", "MeshProcessingBP");
 	MeshProcessingBPToolInfo.ToolCommand = FSampleModelingModeExtensionCommands::Get().BeginMeshProcessingBPTool;
 	MeshProcessingBPToolInfo.ToolBuilder = NewObject<UMeshProcessingBPToolBuilder>();
-	ToolsOut.Add(MeshProcessingBPToolInfo);
+	ExtensionTools.Add(MeshProcessingBPToolInfo);
+
+	// the Builders are shared by every Modeling Mode instance, so nothing else keeps them alive
+	for (FExtensionToolDescription& ToolInfo : ExtensionTools)
+	{
+		ToolInfo.ToolBuilder->AddToRoot();
+	}
+	bExtensionToolsInitialized = true;
 
+	UE_LOG(LogSampleModelingModeExtension, Log, TEXT("Extension Tools initialization took %.2f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
 #undef LOCTEXT_NAMESPACE
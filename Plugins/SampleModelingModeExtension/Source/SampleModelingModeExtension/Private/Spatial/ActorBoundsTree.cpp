@@ -0,0 +1,370 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Spatial/ActorBoundsTree.h"
+#include "GameFramework/Actor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Algo/Sort.h"
+
+
+namespace Local
+{
+
+// slab test, returns the ray parameter where the ray enters the box (0 if the origin is inside)
+static bool RayBoxIntersection(const FRay& Ray, const FBox& Box, double& EntryT)
+{
+	double TMin = 0, TMax = TNumericLimits<double>::Max();
+	for (int32 j = 0; j < 3; ++j)
+	{
+		double Origin = Ray.Origin[j], Direction = Ray.Direction[j];
+		if (FMath::Abs(Direction) < SMALL_NUMBER)
+		{
+			if (Origin < Box.Min[j] || Origin > Box.Max[j])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			double InvDir = 1.0 / Direction;
+			double T0 = (Box.Min[j] - Origin) * InvDir;
+			double T1 = (Box.Max[j] - Origin) * InvDir;
+			if (T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+			TMin = FMath::Max(TMin, T0);
+			TMax = FMath::Min(TMax, T1);
+			if (TMin > TMax)
+			{
+				return false;
+			}
+		}
+	}
+	EntryT = TMin;
+	return true;
+}
+
+}
+
+
+bool FActorBoundsTree::IsValidActor(const AActor* Actor)
+{
+	if (IsValid(Actor) == false || Actor->IsHiddenEd())
+	{
+		return false;
+	}
+	bool bHasVisiblePrimitive = false;
+	Actor->ForEachComponent<UPrimitiveComponent>(false, [&](const UPrimitiveComponent* Component)
+	{
+		bHasVisiblePrimitive = bHasVisiblePrimitive || (Component->IsRegistered() && Component->IsVisible());
+	});
+	return bHasVisiblePrimitive;
+}
+
+
+bool FActorBoundsTree::GetActorBounds(const AActor* Actor, FBox& BoundsOut)
+{
+	BoundsOut = Actor->GetComponentsBoundingBox(true);
+	return BoundsOut.IsValid != 0;
+}
+
+
+void FActorBoundsTree::Reset()
+{
+	Entries.Reset();
+	ActorToEntry.Reset();
+	Nodes.Reset();
+	EntryIndices.Reset();
+	UnsortedEntries.Reset();
+	World = nullptr;
+	bBuilt = false;
+}
+
+
+void FActorBoundsTree::Build(UWorld* WorldIn)
+{
+	Reset();
+	World = WorldIn;
+	if (WorldIn == nullptr)
+	{
+		return;
+	}
+
+	for (TActorIterator<AActor> It(WorldIn); It; ++It)
+	{
+		AActor* Actor = *It;
+		FEntry Entry;
+		if (IsValidActor(Actor) && GetActorBounds(Actor, Entry.Bounds))
+		{
+			Entry.Actor = Actor;
+			Entries.Add(Entry);
+		}
+	}
+
+	Rebuild();
+}
+
+
+void FActorBoundsTree::Rebuild()
+{
+	// compact the entries, dropping removed and destroyed Actors
+	TArray<FEntry> ValidEntries;
+	ValidEntries.Reserve(Entries.Num());
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.bRemoved == false && Entry.Actor.IsValid())
+		{
+			Entry.Leaf = -1;
+			ValidEntries.Add(Entry);
+		}
+	}
+	Entries = MoveTemp(ValidEntries);
+
+	ActorToEntry.Reset();
+	EntryIndices.SetNum(Entries.Num());
+	for (int32 k = 0; k < Entries.Num(); ++k)
+	{
+		ActorToEntry.Add(Entries[k].Actor.Get(), k);
+		EntryIndices[k] = k;
+	}
+
+	Nodes.Reset();
+	UnsortedEntries.Reset();
+	if (Entries.Num() > 0)
+	{
+		BuildNode(-1, 0, Entries.Num());
+	}
+	bBuilt = true;
+}
+
+
+int32 FActorBoundsTree::BuildNode(int32 Parent, int32 First, int32 Count)
+{
+	int32 NodeIndex = Nodes.AddDefaulted();
+	Nodes[NodeIndex].Parent = Parent;
+
+	FBox Bounds(ForceInit), CenterBounds(ForceInit);
+	for (int32 k = First; k < First + Count; ++k)
+	{
+		const FBox& EntryBounds = Entries[EntryIndices[k]].Bounds;
+		Bounds += EntryBounds;
+		CenterBounds += EntryBounds.GetCenter();
+	}
+	Nodes[NodeIndex].Bounds = Bounds;
+
+	if (Count <= FMath::Max(1, LeafSize))
+	{
+		Nodes[NodeIndex].First = First;
+		Nodes[NodeIndex].Count = Count;
+		for (int32 k = First; k < First + Count; ++k)
+		{
+			Entries[EntryIndices[k]].Leaf = NodeIndex;
+		}
+		return NodeIndex;
+	}
+
+	// median split along the longest axis of the centers
+	FVector Extents = CenterBounds.GetExtent();
+	int32 Axis = (Extents.X >= Extents.Y && Extents.X >= Extents.Z) ? 0 : ((Extents.Y >= Extents.Z) ? 1 : 2);
+	Algo::Sort(MakeArrayView(EntryIndices.GetData() + First, Count), [this, Axis](int32 A, int32 B)
+	{
+		return Entries[A].Bounds.GetCenter()[Axis] < Entries[B].Bounds.GetCenter()[Axis];
+	});
+
+	int32 HalfCount = Count / 2;
+	int32 Child0 = BuildNode(NodeIndex, First, HalfCount);
+	int32 Child1 = BuildNode(NodeIndex, First + HalfCount, Count - HalfCount);
+	Nodes[NodeIndex].Children[0] = Child0;
+	Nodes[NodeIndex].Children[1] = Child1;
+	return NodeIndex;
+}
+
+
+void FActorBoundsTree::RefitFromLeaf(int32 LeafIndex)
+{
+	FNode& Leaf = Nodes[LeafIndex];
+	Leaf.Bounds = FBox(ForceInit);
+	for (int32 k = Leaf.First; k < Leaf.First + Leaf.Count; ++k)
+	{
+		const FEntry& Entry = Entries[EntryIndices[k]];
+		if (Entry.bRemoved == false)
+		{
+			Leaf.Bounds += Entry.Bounds;
+		}
+	}
+
+	int32 NodeIndex = Leaf.Parent;
+	while (NodeIndex >= 0)
+	{
+		FNode& Node = Nodes[NodeIndex];
+		Node.Bounds = Nodes[Node.Children[0]].Bounds + Nodes[Node.Children[1]].Bounds;
+		NodeIndex = Node.Parent;
+	}
+}
+
+
+void FActorBoundsTree::UpdateActor(AActor* Actor)
+{
+	if (bBuilt == false || Actor == nullptr || Actor->GetWorld() != World.Get())
+	{
+		return;
+	}
+
+	FBox NewBounds;
+	bool bValid = IsValidActor(Actor) && GetActorBounds(Actor, NewBounds);
+
+	int32* EntryIndex = ActorToEntry.Find(Actor);
+	if (EntryIndex == nullptr)
+	{
+		if (bValid)
+		{
+			FEntry Entry;
+			Entry.Actor = Actor;
+			Entry.Bounds = NewBounds;
+			int32 NewIndex = Entries.Add(Entry);
+			ActorToEntry.Add(Actor, NewIndex);
+			UnsortedEntries.Add(NewIndex);
+			if (UnsortedEntries.Num() > MaxUnsortedActors)
+			{
+				Rebuild();
+			}
+		}
+		return;
+	}
+
+	if (bValid == false)
+	{
+		RemoveActor(Actor);
+		return;
+	}
+
+	FEntry& Entry = Entries[*EntryIndex];
+	Entry.Bounds = NewBounds;
+	if (Entry.Leaf >= 0)
+	{
+		RefitFromLeaf(Entry.Leaf);
+	}
+}
+
+
+void FActorBoundsTree::RemoveActor(AActor* Actor)
+{
+	int32 EntryIndex;
+	if (bBuilt == false || ActorToEntry.RemoveAndCopyValue(Actor, EntryIndex) == false)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.bRemoved = true;
+	if (Entry.Leaf >= 0)
+	{
+		RefitFromLeaf(Entry.Leaf);
+	}
+	else
+	{
+		UnsortedEntries.Remove(EntryIndex);
+	}
+}
+
+
+bool FActorBoundsTree::TestEntry(const FEntry& Entry, const FRay& Ray, double& NearestDistance, FHitResult& HitOut) const
+{
+	double EntryT;
+	if (Entry.bRemoved || Local::RayBoxIntersection(Ray, Entry.Bounds, EntryT) == false || EntryT >= NearestDistance)
+	{
+		return false;
+	}
+	const AActor* Actor = Entry.Actor.Get();
+	if (Actor == nullptr || Actor->IsHiddenEd())
+	{
+		return false;
+	}
+
+	// trace each visible component directly, this matches an all-object-types world trace restricted to this Actor
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ActorBoundsTree), true);
+	FVector Start = Ray.Origin;
+	FVector End = Ray.PointAt(NearestDistance);
+	bool bFound = false;
+	Actor->ForEachComponent<UPrimitiveComponent>(false, [&](UPrimitiveComponent* Component)
+	{
+		FHitResult ComponentHit;
+		if (Component->IsRegistered() && Component->IsVisible()
+			&& Component->LineTraceComponent(ComponentHit, Start, End, QueryParams)
+			&& ComponentHit.Distance < NearestDistance)
+		{
+			NearestDistance = ComponentHit.Distance;
+			End = Ray.PointAt(NearestDistance);
+			HitOut = ComponentHit;
+			bFound = true;
+		}
+	});
+	return bFound;
+}
+
+
+bool FActorBoundsTree::FindNearestHit(const FRay& Ray, double MaxDistance, FHitResult& HitOut) const
+{
+	double NearestDistance = MaxDistance;
+	bool bFound = false;
+
+	for (int32 EntryIndex : UnsortedEntries)
+	{
+		bFound = TestEntry(Entries[EntryIndex], Ray, NearestDistance, HitOut) || bFound;
+	}
+
+	if (Nodes.Num() == 0)
+	{
+		return bFound;
+	}
+
+	// depth-first traversal, nearer child first, pruning nodes that start beyond the nearest hit so far
+	TArray<TPair<int32, double>, TInlineAllocator<64>> Stack;
+	double RootT;
+	if (Local::RayBoxIntersection(Ray, Nodes[0].Bounds, RootT))
+	{
+		Stack.Add(TPair<int32, double>(0, RootT));
+	}
+	while (Stack.Num() > 0)
+	{
+		TPair<int32, double> Item = Stack.Pop(false);
+		if (Item.Value >= NearestDistance)
+		{
+			continue;
+		}
+
+		const FNode& Node = Nodes[Item.Key];
+		if (Node.IsLeaf())
+		{
+			for (int32 k = Node.First; k < Node.First + Node.Count; ++k)
+			{
+				bFound = TestEntry(Entries[EntryIndices[k]], Ray, NearestDistance, HitOut) || bFound;
+			}
+			continue;
+		}
+
+		double T0 = 0, T1 = 0;
+		bool bHit0 = Local::RayBoxIntersection(Ray, Nodes[Node.Children[0]].Bounds, T0);
+		bool bHit1 = Local::RayBoxIntersection(Ray, Nodes[Node.Children[1]].Bounds, T1);
+		if (bHit0 && bHit1)
+		{
+			// push the far child first so that the near child is popped first
+			int32 Near = (T0 <= T1) ? 0 : 1;
+			Stack.Add(TPair<int32, double>(Node.Children[1 - Near], (Near == 0) ? T1 : T0));
+			Stack.Add(TPair<int32, double>(Node.Children[Near], (Near == 0) ? T0 : T1));
+		}
+		else if (bHit0)
+		{
+			Stack.Add(TPair<int32, double>(Node.Children[0], T0));
+		}
+		else if (bHit1)
+		{
+			Stack.Add(TPair<int32, double>(Node.Children[1], T1));
+		}
+	}
+
+	return bFound;
+}
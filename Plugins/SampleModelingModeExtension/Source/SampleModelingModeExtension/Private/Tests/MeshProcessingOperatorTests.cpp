@@ -0,0 +1,246 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Operations/MeshNoiseOp.h"
+#include "Operations/MeshChunkedExecution.h"
+#include "Tools/MeshNoiseTool.h"
+#include "Tools/MeshProcessingBPTool.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/DynamicMeshAttributeSet.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Generators/SphereGenerator.h"
+#include "Util/ProgressCancel.h"
+
+using namespace UE::Geometry;
+
+
+namespace Local
+{
+
+static constexpr EAutomationTestFlags::Type OperatorTestFlags = (EAutomationTestFlags::Type)(EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+
+struct FTestMesh
+{
+	TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Mesh;
+	TSharedPtr<FMeshNormals, ESPMode::ThreadSafe> VertexNormals;
+};
+
+static FTestMesh MakeTestSphere(int32 Resolution)
+{
+	FSphereGenerator Generator;
+	Generator.Radius = 100.0;
+	Generator.NumPhi = Resolution;
+	Generator.NumTheta = Resolution;
+	TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> Mesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>(&Generator.Generate());
+
+	FTestMesh Result;
+	Result.VertexNormals = MakeShared<FMeshNormals, ESPMode::ThreadSafe>(Mesh.Get());
+	Result.VertexNormals->ComputeVertexNormals();
+	Result.Mesh = Mesh;
+	return Result;
+}
+
+static FMeshNoiseOp::FOptions MakeNoiseOptions()
+{
+	FMeshNoiseOp::FOptions Options;
+	Options.NoiseType = EMeshNoiseToolNoiseType::Perlin;
+	Options.Magnitude = 1.0;
+	return Options;
+}
+
+static TUniquePtr<FMeshNoiseOp> MakeNoiseOp(const FTestMesh& Mesh, const FMeshNoiseOp::FOptions& Options)
+{
+	TUniquePtr<FMeshNoiseOp> Op = MakeUnique<FMeshNoiseOp>(Options);
+	Op->BaseMeshNormals = Mesh.VertexNormals;
+	Op->SetInputMesh(Mesh.Mesh);
+	Op->SetTransform(FTransformSRT3d::Identity());
+	return Op;
+}
+
+/** Run Operator to completion. @return the result, or null if the operator did not succeed */
+static TUniquePtr<FDynamicMesh3> RunOperator(FMeshProcessingOperator& Operator)
+{
+	FProgressCancel Progress;
+	Operator.CalculateResult(&Progress);
+	if (Operator.GetResultInfo().Result != EGeometryResultType::Success)
+	{
+		return nullptr;
+	}
+	return Operator.ExtractResult();
+}
+
+static double GetMaxVertexDeviation(const FDynamicMesh3& Mesh, const FDynamicMesh3& ReferenceMesh)
+{
+	double MaxDistSqr = 0;
+	for (int32 vid : ReferenceMesh.VertexIndicesItr())
+	{
+		MaxDistSqr = FMath::Max(MaxDistSqr, (Mesh.IsVertex(vid)) ? DistanceSquared(Mesh.GetVertex(vid), ReferenceMesh.GetVertex(vid)) : TNumericLimits<double>::Max());
+	}
+	return FMath::Sqrt(MaxDistSqr);
+}
+
+/** @return maximum angle in degrees between the primary normals of the corresponding triangle corners */
+static double GetMaxNormalDeviation(const FDynamicMesh3& Mesh, const FDynamicMesh3& ReferenceMesh)
+{
+	const FDynamicMeshNormalOverlay* Normals = Mesh.Attributes()->PrimaryNormals();
+	const FDynamicMeshNormalOverlay* ReferenceNormals = ReferenceMesh.Attributes()->PrimaryNormals();
+	double MinCosAngle = 1.0;
+	for (int32 tid : ReferenceMesh.TriangleIndicesItr())
+	{
+		if (Mesh.IsTriangle(tid) == false || Normals->IsSetTriangle(tid) == false)
+		{
+			return 180.0;
+		}
+		FIndex3i Elements = Normals->GetTriangle(tid);
+		FIndex3i ReferenceElements = ReferenceNormals->GetTriangle(tid);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			FVector3d Normal = Normalized((FVector3d)Normals->GetElement(Elements[j]));
+			FVector3d ReferenceNormal = Normalized((FVector3d)ReferenceNormals->GetElement(ReferenceElements[j]));
+			MinCosAngle = FMath::Min(MinCosAngle, Normal.Dot(ReferenceNormal));
+		}
+	}
+	return FMathd::RadToDeg * FMath::Acos(FMath::Clamp(MinCosAngle, -1.0, 1.0));
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshNoiseOpReferenceTest, "SampleModelingModeExtension.Operators.NoiseMatchesReference", Local::OperatorTestFlags)
+
+bool FMeshNoiseOpReferenceTest::RunTest(const FString& Parameters)
+{
+	Local::FTestMesh Mesh = Local::MakeTestSphere(64);
+
+	// the per-vertex indexed displacement is the reference for the batched kernel
+	FMeshNoiseOp::FOptions ReferenceOptions = Local::MakeNoiseOptions();
+	ReferenceOptions.bBatchedDisplacement = false;
+	ReferenceOptions.bAnalyticNormals = false;
+	TUniquePtr<FMeshNoiseOp> ReferenceOp = Local::MakeNoiseOp(Mesh, ReferenceOptions);
+	TUniquePtr<FDynamicMesh3> Reference = Local::RunOperator(*ReferenceOp);
+	if (TestTrue(TEXT("reference operator succeeded"), Reference.IsValid()) == false)
+	{
+		return false;
+	}
+	TestTrue(TEXT("reference operator displaced the mesh"), Local::GetMaxVertexDeviation(*Reference, *Mesh.Mesh) > 0.01);
+
+	TUniquePtr<FMeshNoiseOp> BatchedOp = Local::MakeNoiseOp(Mesh, Local::MakeNoiseOptions());
+	TUniquePtr<FDynamicMesh3> Batched = Local::RunOperator(*BatchedOp);
+	if (TestTrue(TEXT("batched operator succeeded"), Batched.IsValid()))
+	{
+		TestEqual(TEXT("batched topology"), Batched->TriangleCount(), Reference->TriangleCount());
+		TestTrue(TEXT("batched positions match the reference"), Local::GetMaxVertexDeviation(*Batched, *Reference) < 1e-9);
+		// the analytic normals are exact for the noise field, the recomputed ones are averaged over the triangle fans
+		TestTrue(TEXT("analytic normals match the recomputed normals"), Local::GetMaxNormalDeviation(*Batched, *Reference) < 5.0);
+	}
+
+	FMeshNoiseOp::FOptions FloatOptions = Local::MakeNoiseOptions();
+	FloatOptions.bSinglePrecision = true;
+	TUniquePtr<FMeshNoiseOp> FloatOp = Local::MakeNoiseOp(Mesh, FloatOptions);
+	TUniquePtr<FDynamicMesh3> FloatResult = Local::RunOperator(*FloatOp);
+	if (TestTrue(TEXT("single-precision operator succeeded"), FloatResult.IsValid()))
+	{
+		TestTrue(TEXT("single-precision positions are close to the reference"), Local::GetMaxVertexDeviation(*FloatResult, *Reference) < 1e-2);
+	}
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshProcessingOperatorCancelTest, "SampleModelingModeExtension.Operators.Cancellation", Local::OperatorTestFlags)
+
+bool FMeshProcessingOperatorCancelTest::RunTest(const FString& Parameters)
+{
+	Local::FTestMesh Mesh = Local::MakeTestSphere(32);
+
+	TUniquePtr<FMeshNoiseOp> CancelledOp = Local::MakeNoiseOp(Mesh, Local::MakeNoiseOptions());
+	FProgressCancel Progress;
+	Progress.CancelF = []() { return true; };
+	CancelledOp->CalculateResult(&Progress);
+	TestEqual(TEXT("cancelled operator result"), CancelledOp->GetResultInfo().Result, EGeometryResultType::Cancelled);
+
+	TSharedPtr<FOperatorGenerationCounter, ESPMode::ThreadSafe> Generation = MakeShared<FOperatorGenerationCounter, ESPMode::ThreadSafe>();
+	TUniquePtr<FMeshNoiseOp> SupersededOp = Local::MakeNoiseOp(Mesh, Local::MakeNoiseOptions());
+	SupersededOp->SetGenerationCounter(Generation);
+	TestFalse(TEXT("operator of the current generation is not superseded"), SupersededOp->IsSuperseded());
+	Generation->Advance();
+	TestTrue(TEXT("operator of a previous generation is superseded"), SupersededOp->IsSuperseded());
+	TUniquePtr<FDynamicMesh3> SupersededResult = Local::RunOperator(*SupersededOp);
+	TestFalse(TEXT("superseded operator returns no result"), SupersededResult.IsValid());
+	TestEqual(TEXT("superseded operator result"), SupersededOp->GetResultInfo().Result, EGeometryResultType::Cancelled);
+	TestEqual(TEXT("superseded operator recorded a stale exit"), Generation->GetNumStaleExits(), (int64)1);
+
+	// a new operator of the current generation is unaffected
+	TUniquePtr<FMeshNoiseOp> CurrentOp = Local::MakeNoiseOp(Mesh, Local::MakeNoiseOptions());
+	CurrentOp->SetGenerationCounter(Generation);
+	TestTrue(TEXT("current operator succeeded"), Local::RunOperator(*CurrentOp).IsValid());
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshChunkedExecutionTest, "SampleModelingModeExtension.Operators.ChunkedMatchesUnchunked", Local::OperatorTestFlags)
+
+bool FMeshChunkedExecutionTest::RunTest(const FString& Parameters)
+{
+	Local::FTestMesh Mesh = Local::MakeTestSphere(96);
+
+	// displacement in vertex chunks of a small memory budget, against a single batch
+	TUniquePtr<FMeshNoiseOp> SingleBatchOp = Local::MakeNoiseOp(Mesh, Local::MakeNoiseOptions());
+	TUniquePtr<FDynamicMesh3> SingleBatch = Local::RunOperator(*SingleBatchOp);
+	FMeshNoiseOp::FOptions ChunkedOptions = Local::MakeNoiseOptions();
+	ChunkedOptions.BatchMemoryBudget = 64 * 1024;
+	TUniquePtr<FMeshNoiseOp> ChunkedOp = Local::MakeNoiseOp(Mesh, ChunkedOptions);
+	TUniquePtr<FDynamicMesh3> Chunked = Local::RunOperator(*ChunkedOp);
+	if (TestTrue(TEXT("noise operators succeeded"), SingleBatch.IsValid() && Chunked.IsValid()))
+	{
+		TestEqual(TEXT("chunked displacement is identical"), Local::GetMaxVertexDeviation(*Chunked, *SingleBatch), 0.0);
+		TestEqual(TEXT("chunked normals are identical"), Local::GetMaxNormalDeviation(*Chunked, *SingleBatch), 0.0);
+	}
+
+	// the same chunks with the analytic normals in a scratch file
+	FMeshNoiseOp::FOptions ScratchOptions = ChunkedOptions;
+	ScratchOptions.ScratchFileDirectory = FScratchFile::GetDefaultDirectory();
+	TUniquePtr<FMeshNoiseOp> ScratchOp = Local::MakeNoiseOp(Mesh, ScratchOptions);
+	TUniquePtr<FDynamicMesh3> ScratchResult = Local::RunOperator(*ScratchOp);
+	if (TestTrue(TEXT("scratch file operator succeeded"), SingleBatch.IsValid() && ScratchResult.IsValid()))
+	{
+		TestEqual(TEXT("scratch file displacement is identical"), Local::GetMaxVertexDeviation(*ScratchResult, *SingleBatch), 0.0);
+		TestEqual(TEXT("scratch file normals are identical"), Local::GetMaxNormalDeviation(*ScratchResult, *SingleBatch), 0.0);
+		TestTrue(TEXT("scratch file normals stay within the budget"), ScratchOp->GetTrackedPeakMemory() < SingleBatchOp->GetTrackedPeakMemory());
+	}
+
+	// Operation chain in spatial chunks, against the whole mesh
+	FMeshProcessingOperationChain Chain;
+	Chain.AddOperation(GetDefault<UMeshProcessingRecomputeNormalsChainStep>()->MakeOperation(FMeshProcessingBPToolParameters()));
+	TestTrue(TEXT("chain can be executed in chunks"), FMeshChunkedExecution::CanExecuteChunked(Chain));
+
+	TUniquePtr<FMeshProcessingOperator> WholeOp = UMeshProcessingBPTool::MakeNativeChainOperator(Chain);
+	FMeshChunkedExecutionOptions ChunkOptions;
+	ChunkOptions.NumChunks = 8;
+	TUniquePtr<FMeshProcessingOperator> ChunkedChainOp = UMeshProcessingBPTool::MakeNativeChainOperator(Chain, &ChunkOptions);
+	if (TestTrue(TEXT("chain operators created"), WholeOp.IsValid() && ChunkedChainOp.IsValid()) == false)
+	{
+		return false;
+	}
+	for (FMeshProcessingOperator* Op : { WholeOp.Get(), ChunkedChainOp.Get() })
+	{
+		Op->SetInputMesh(Mesh.Mesh);
+		Op->SetTransform(FTransformSRT3d::Identity());
+	}
+	TUniquePtr<FDynamicMesh3> Whole = Local::RunOperator(*WholeOp);
+	TUniquePtr<FDynamicMesh3> ChunkedChain = Local::RunOperator(*ChunkedChainOp);
+	if (TestTrue(TEXT("chain operators succeeded"), Whole.IsValid() && ChunkedChain.IsValid()))
+	{
+		TestEqual(TEXT("chunked chain vertex count"), ChunkedChain->VertexCount(), Whole->VertexCount());
+		TestEqual(TEXT("chunked chain triangle count"), ChunkedChain->TriangleCount(), Whole->TriangleCount());
+		TestEqual(TEXT("chunked chain positions are identical"), Local::GetMaxVertexDeviation(*ChunkedChain, *Whole), 0.0);
+		// the chunk meshes sum the triangle normals in a different order
+		TestTrue(TEXT("chunked chain normals match"), Local::GetMaxNormalDeviation(*ChunkedChain, *Whole) < 1e-3);
+	}
+	return true;
+}
+
+#endif
@@ -2,17 +2,60 @@
 // https://www.boost.org/LICENSE_1_0.txt
 
 #include "Tools/ActorClickedBPTool.h"
+#include "InteractiveToolManager.h"
 #include "ToolSceneQueriesUtil.h"
+#include "Mechanics/RectangleMarqueeMechanic.h"
+#include "EngineUtils.h"
+#include "Engine/Engine.h"
+#include "Editor.h"
+
+#define LOCTEXT_NAMESPACE "UActorClickedBPTool"
 
 
 
 UInteractiveTool* UActorClickedBPToolBuilder::BuildTool(const FToolBuilderState& SceneState) const
 {
 	UActorClickedBPTool* NewTool = NewObject<UActorClickedBPTool>(SceneState.ToolManager);
+	NewTool->SetWorld(SceneState.World);
+	NewTool->SetInitialSelection(SceneState.SelectedActors);
 	return NewTool;
 }
 
 
+
+void UActorClickedBPToolBatchActions::ApplyToSelection()
+{
+	if (ParentTool.IsValid())
+	{
+		ParentTool->RequestAction_ApplyToSelection();
+	}
+}
+
+void UActorClickedBPToolBatchActions::CancelBatch()
+{
+	if (ParentTool.IsValid())
+	{
+		ParentTool->CancelBatch();
+	}
+}
+
+
+
+void UActorClickedBPTool::SetWorld(UWorld* World)
+{
+	TargetWorld = World;
+}
+
+void UActorClickedBPTool::SetInitialSelection(const TArray<AActor*>& Actors)
+{
+	InitialSelection.Reset();
+	for (AActor* Actor : Actors)
+	{
+		InitialSelection.Add(Actor);
+	}
+}
+
+
 void UActorClickedBPTool::Setup()
 {
 	USingleClickTool::Setup();
@@ -20,21 +63,125 @@ void UActorClickedBPTool::Setup()
 	PropertySet = NewObject<UActorClickedBPToolProperties>(this);
 	AddToolPropertySource(PropertySet);
 	PropertySet->RestoreProperties(this);
+
+	BatchActions = NewObject<UActorClickedBPToolBatchActions>(this);
+	BatchActions->Initialize(this);
+	AddToolPropertySource(BatchActions);
+
+	// the marquee mechanic replaces single-click processing while enabled
+	MarqueeMechanic = NewObject<URectangleMarqueeMechanic>(this);
+	MarqueeMechanic->Setup(this);
+	MarqueeMechanic->OnDragRectangleFinished.AddUObject(this, &UActorClickedBPTool::OnMarqueeRectangleFinished);
+	MarqueeMechanic->SetIsEnabled(PropertySet->bMarqueeSelect);
+	PropertySet->WatchProperty(PropertySet->bMarqueeSelect, [this](bool bNewValue)
+	{
+		MarqueeMechanic->SetIsEnabled(bNewValue);
+	});
+
+	// a new Operation type requires a new instance
+	PropertySet->WatchProperty(PropertySet->Operation, [this](TSubclassOf<UActorClickedBPToolOperation>)
+	{
+		OperationInstance = nullptr;
+	});
+
+	// track Actor changes, to keep the hit cache and acceleration tree valid
+	OnActorMovedHandle = GEngine->OnActorMoved().AddUObject(this, &UActorClickedBPTool::OnActorChanged);
+	OnActorAddedHandle = GEngine->OnLevelActorAdded().AddUObject(this, &UActorClickedBPTool::OnActorChanged);
+	OnActorDeletedHandle = GEngine->OnLevelActorDeleted().AddUObject(this, &UActorClickedBPTool::OnActorDeleted);
+	// undo and redo can restore Actors without the notifications above
+	OnPostUndoRedoHandle = FEditorDelegates::PostUndoRedo.AddUObject(this, &UActorClickedBPTool::InvalidateHitCache);
+
+	UpdateAccelerationTree();
+	PropertySet->WatchProperty(PropertySet->bUseAccelerationTree, [this](bool) { UpdateAccelerationTree(); });
 }
 
 void UActorClickedBPTool::Shutdown(EToolShutdownType ShutdownType)
 {
+	// a running batch is stopped, the Actors processed so far are still covered by its transaction
+	if (bBatchRunning)
+	{
+		EndBatch(true);
+	}
+
 	PropertySet->SaveProperties(this);
 
+	MarqueeMechanic->Shutdown();
+	OperationInstance = nullptr;
+
+	GEngine->OnActorMoved().Remove(OnActorMovedHandle);
+	GEngine->OnLevelActorAdded().Remove(OnActorAddedHandle);
+	GEngine->OnLevelActorDeleted().Remove(OnActorDeletedHandle);
+	FEditorDelegates::PostUndoRedo.Remove(OnPostUndoRedoHandle);
+	ActorTree.Reset();
+
 	USingleClickTool::Shutdown(ShutdownType);
 }
 
 
+void UActorClickedBPTool::OnTick(float DeltaTime)
+{
+	// the hit cache only spans the queries of a single input event, eg visibility changes have no notification
+	InvalidateHitCache();
+
+	if (bBatchRunning == false)
+	{
+		return;
+	}
+
+	UActorClickedBPToolOperation* Operation = GetOperationInstance();
+	if (Operation == nullptr)
+	{
+		EndBatch(true);
+		return;
+	}
+
+	// always process at least one Actor per frame, so that the batch makes progress even if the Blueprint is slow
+	double StartTime = FPlatformTime::Seconds();
+	double Budget = (double)PropertySet->FrameBudgetMs * 0.001;
+	do
+	{
+		AActor* Actor = BatchActors[BatchIndex].Get();
+		BatchIndex++;
+		if (Actor != nullptr)
+		{
+			Operation->OnApplyActionToActor(Actor);
+		}
+	}
+	while (BatchIndex < BatchActors.Num() && (FPlatformTime::Seconds() - StartTime) < Budget);
+
+	if (BatchIndex >= BatchActors.Num())
+	{
+		EndBatch(false);
+	}
+	else
+	{
+		UpdateBatchMessage();
+	}
+}
+
+
+void UActorClickedBPTool::Render(IToolsContextRenderAPI* RenderAPI)
+{
+	MarqueeMechanic->Render(RenderAPI);
+}
+
+void UActorClickedBPTool::DrawHUD(FCanvas* Canvas, IToolsContextRenderAPI* RenderAPI)
+{
+	MarqueeMechanic->DrawHUD(Canvas, RenderAPI);
+}
+
+
 FInputRayHit UActorClickedBPTool::IsHitByClick(const FInputDeviceRay& ClickPos)
 {
+	// clicks are ignored in marquee mode and while a batch is running
+	if (PropertySet->bMarqueeSelect || bBatchRunning)
+	{
+		return FInputRayHit();
+	}
+
 	// cast ray into scene
 	FHitResult Result;
-	if (ToolSceneQueriesUtil::FindNearestVisibleObjectHit(this, Result, ClickPos.WorldRay))
+	if (FindHit(ClickPos.WorldRay, Result))
 	{
 		return FInputRayHit(Result.Distance);
 	}
@@ -45,17 +192,185 @@ FInputRayHit UActorClickedBPTool::IsHitByClick(const FInputDeviceRay& ClickPos)
 void UActorClickedBPTool::OnClicked(const FInputDeviceRay& ClickPos)
 {
 	FHitResult Result;
-	if (ToolSceneQueriesUtil::FindNearestVisibleObjectHit(this, Result, ClickPos.WorldRay))
+	bool bHit = FindHit(ClickPos.WorldRay, Result);
+	// the click consumes the hit of IsHitByClick(), and the Blueprint may modify the Actor
+	InvalidateHitCache();
+	if (bHit)
 	{
 		AActor* Actor = Result.HitObjectHandle.FetchActor<AActor>();
-		if (Actor != nullptr && PropertySet->Operation != nullptr)
+		if (Actor != nullptr)
 		{
-			UClass* ClassType = PropertySet->Operation;
-			UActorClickedBPToolOperation* ClassObject = NewObject<UActorClickedBPToolOperation>((UObject*)GetTransientPackage(), ClassType);
-			if (ClassObject)
+			if (UActorClickedBPToolOperation* Operation = GetOperationInstance())
 			{
-				ClassObject->OnApplyActionToActor(Actor);
+				Operation->OnApplyActionToActor(Actor);
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+
+bool UActorClickedBPTool::FindHit(const FRay& WorldRay, FHitResult& HitOut)
+{
+	if (CachedHit.bValid && CachedHit.Ray.Origin.Equals(WorldRay.Origin) && CachedHit.Ray.Direction.Equals(WorldRay.Direction))
+	{
+		HitOut = CachedHit.Hit;
+		return CachedHit.bHit;
+	}
+
+	CachedHit.Ray = WorldRay;
+	CachedHit.Hit = FHitResult();
+	if (ActorTree.IsBuilt())
+	{
+		CachedHit.bHit = ActorTree.FindNearestHit(WorldRay, HALF_WORLD_MAX, CachedHit.Hit);
+	}
+	else
+	{
+		CachedHit.bHit = ToolSceneQueriesUtil::FindNearestVisibleObjectHit(this, CachedHit.Hit, WorldRay);
+	}
+	CachedHit.bValid = true;
+
+	HitOut = CachedHit.Hit;
+	return CachedHit.bHit;
+}
+
+
+void UActorClickedBPTool::OnActorChanged(AActor* Actor)
+{
+	InvalidateHitCache();
+	ActorTree.UpdateActor(Actor);
+}
+
+void UActorClickedBPTool::OnActorDeleted(AActor* Actor)
+{
+	InvalidateHitCache();
+	ActorTree.RemoveActor(Actor);
+}
+
+
+void UActorClickedBPTool::UpdateAccelerationTree()
+{
+	InvalidateHitCache();
+	if (PropertySet->bUseAccelerationTree && TargetWorld.IsValid())
+	{
+		ActorTree.Build(TargetWorld.Get());
+	}
+	else
+	{
+		ActorTree.Reset();
+	}
+}
+
+
+UActorClickedBPToolOperation* UActorClickedBPTool::GetOperationInstance()
+{
+	if (PropertySet->Operation == nullptr)
+	{
+		return nullptr;
+	}
+	if (OperationInstance == nullptr || OperationInstance->GetClass() != PropertySet->Operation)
+	{
+		UClass* ClassType = PropertySet->Operation;
+		OperationInstance = NewObject<UActorClickedBPToolOperation>((UObject*)GetTransientPackage(), ClassType);
+	}
+	return OperationInstance;
+}
+
+
+void UActorClickedBPTool::OnMarqueeRectangleFinished(const FCameraRectangle& Rectangle, bool bCancelled)
+{
+	if (bCancelled || bBatchRunning || TargetWorld.IsValid() == false)
+	{
+		return;
+	}
+
+	// collect the visible Actors whose bounds center projects into the rectangle
+	TArray<AActor*> MarqueeActors;
+	for (TActorIterator<AActor> It(TargetWorld.Get()); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (Actor->IsHiddenEd() || Actor->GetRootComponent() == nullptr)
+		{
+			continue;
+		}
+		FVector Origin, Extent;
+		Actor->GetActorBounds(true, Origin, Extent);
+		if (Extent.IsNearlyZero() == false && Rectangle.IsProjectedPointInRectangle(Origin))
+		{
+			MarqueeActors.Add(Actor);
+		}
+	}
+
+	StartBatch(MarqueeActors);
+}
+
+
+void UActorClickedBPTool::RequestAction_ApplyToSelection()
+{
+	TArray<AActor*> Actors;
+	for (const TWeakObjectPtr<AActor>& Actor : InitialSelection)
+	{
+		if (Actor.IsValid())
+		{
+			Actors.Add(Actor.Get());
+		}
+	}
+	StartBatch(Actors);
+}
+
+
+void UActorClickedBPTool::StartBatch(const TArray<AActor*>& Actors)
+{
+	if (bBatchRunning || Actors.Num() == 0 || GetOperationInstance() == nullptr)
+	{
+		return;
+	}
+
+	BatchActors.Reset(Actors.Num());
+	for (AActor* Actor : Actors)
+	{
+		BatchActors.Add(Actor);
+	}
+	BatchIndex = 0;
+	bBatchRunning = true;
+
+	// the transaction stays open until the batch is finished or cancelled, so the whole batch is undone in one step
+	GetToolManager()->BeginUndoTransaction(LOCTEXT("BatchTransaction", "Apply BP to Actors"));
+
+	UpdateBatchMessage();
+}
+
+
+void UActorClickedBPTool::CancelBatch()
+{
+	if (bBatchRunning)
+	{
+		EndBatch(true);
+	}
+}
+
+
+void UActorClickedBPTool::EndBatch(bool bCancelled)
+{
+	GetToolManager()->EndUndoTransaction();
+
+	FText Message = (bCancelled) ?
+		FText::Format(LOCTEXT("BatchCancelledMessage", "Batch cancelled after {0} of {1} Actors"), FText::AsNumber(BatchIndex), FText::AsNumber(BatchActors.Num())) :
+		FText::Format(LOCTEXT("BatchFinishedMessage", "Batch finished, processed {0} Actors"), FText::AsNumber(BatchActors.Num()));
+	GetToolManager()->DisplayMessage(Message, EToolMessageLevel::UserNotification);
+
+	bBatchRunning = false;
+	BatchActors.Reset();
+	BatchIndex = 0;
+}
+
+
+void UActorClickedBPTool::UpdateBatchMessage()
+{
+	GetToolManager()->DisplayMessage(
+		FText::Format(LOCTEXT("BatchProgressMessage", "Processing Actors: {0} of {1}"), FText::AsNumber(BatchIndex), FText::AsNumber(BatchActors.Num())),
+		EToolMessageLevel::UserNotification);
+}
+
+
+
+#undef LOCTEXT_NAMESPACE
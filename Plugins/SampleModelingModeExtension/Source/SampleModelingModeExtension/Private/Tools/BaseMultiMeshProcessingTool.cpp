@@ -0,0 +1,770 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Tools/BaseMultiMeshProcessingTool.h"
+#include "Tools/MeshProcessingPreview.h"
+#include "Tools/ToolInputMeshCache.h"
+#include "Tools/MeshVertexDeltaChange.h"
+#include "Operations/MeshProcessingComputePool.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "InteractiveToolManager.h"
+#include "ToolTargetManager.h"
+#include "ToolSetupUtil.h"
+#include "ModelingToolTargetUtil.h"
+#include "TargetInterfaces/MaterialProvider.h"
+#include "TargetInterfaces/MeshDescriptionCommitter.h"
+#include "TargetInterfaces/MeshDescriptionProvider.h"
+#include "TargetInterfaces/PrimitiveComponentBackedTarget.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "Misc/ScopedSlowTask.h"
+#include "HAL/PlatformProcess.h"
+#include "Util/ProgressCancel.h"
+#include <atomic>
+
+using namespace UE::Geometry;
+
+#define LOCTEXT_NAMESPACE "UBaseMultiMeshProcessingTool"
+
+DECLARE_CYCLE_STAT(TEXT("MakeNewOperator"), STAT_MultiMeshProcessing_MakeNewOperator, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Invalidations"), STAT_MultiMeshProcessing_Invalidations, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Discarded Results"), STAT_MultiMeshProcessing_DiscardedResults, STATGROUP_SampleModelingModeExtension);
+
+TRACE_DECLARE_INT_COUNTER(MultiMeshProcessing_Invalidations, TEXT("ModelingModeExtension/Invalidations"));
+TRACE_DECLARE_INT_COUNTER(MultiMeshProcessing_DiscardedResults, TEXT("ModelingModeExtension/DiscardedResults"));
+
+
+
+const FToolTargetTypeRequirements& UBaseMultiMeshProcessingToolBuilder::GetTargetRequirements() const
+{
+	static FToolTargetTypeRequirements TypeRequirements({
+		UMaterialProvider::StaticClass(),
+		UMeshDescriptionCommitter::StaticClass(),
+		UMeshDescriptionProvider::StaticClass(),
+		UPrimitiveComponentBackedTarget::StaticClass()
+		});
+	return TypeRequirements;
+}
+
+bool UBaseMultiMeshProcessingToolBuilder::CanBuildTool(const FToolBuilderState& SceneState) const
+{
+	return SceneState.TargetManager->CountSelectedAndTargetable(SceneState, GetTargetRequirements()) > 0;
+}
+
+UInteractiveTool* UBaseMultiMeshProcessingToolBuilder::BuildTool(const FToolBuilderState& SceneState) const
+{
+	UBaseMultiMeshProcessingTool* NewTool = MakeNewToolInstance(SceneState.ToolManager);
+	TArray<TObjectPtr<UToolTarget>> Targets = SceneState.TargetManager->BuildAllSelectedTargetable(SceneState, GetTargetRequirements());
+	NewTool->SetTargets(Targets);
+	NewTool->SetWorld(SceneState.World);
+	return NewTool;
+}
+
+
+
+void UBaseMultiMeshProcessingTool::SetWorld(UWorld* World)
+{
+	TargetWorld = World;
+}
+
+
+void UBaseMultiMeshProcessingTool::Setup()
+{
+	UInteractiveTool::Setup();
+
+	// start loading all the targets, the subclass initializes while the meshes are converted in the background
+	ProcessingTargets.SetNum(Targets.Num());
+	for (int32 k = 0; k < Targets.Num(); ++k)
+	{
+		InitializeProcessingTarget(k);
+	}
+
+	InitializeProperties();
+
+	MultiMeshProperties = NewObject<UMultiMeshProcessingProperties>(this);
+	AddToolPropertySource(MultiMeshProperties);
+	MultiMeshProperties->RestoreProperties(this);
+	SetToolPropertySourceEnabled(MultiMeshProperties, Targets.Num() > 1);
+
+	for (int32 k = 0; k < Targets.Num(); ++k)
+	{
+		InitializePreview(k);
+	}
+
+	// inputs that were cached are ready immediately
+	UpdatePendingInputs();
+	UpdateMemoryMessage(true);
+
+	bInternalInvalidate = true;
+	InvalidateResult();
+	bInternalInvalidate = false;
+}
+
+
+void UBaseMultiMeshProcessingTool::InitializeProcessingTarget(int32 TargetIndex)
+{
+	FProcessingTarget& ProcessingTarget = ProcessingTargets[TargetIndex];
+	ProcessingTarget.PendingInput = FToolInputMeshCache::Get().GetInputAsync(Targets[TargetIndex], RequiresInitialVtxNormals());
+	ProcessingTarget.Transform = (FTransform3d)UE::ToolTarget::GetLocalToWorldTransform(Targets[TargetIndex]);
+	ProcessingTarget.Generation = MakeShared<FOperatorGenerationCounter, ESPMode::ThreadSafe>();
+}
+
+
+void UBaseMultiMeshProcessingTool::InitializePreview(int32 TargetIndex)
+{
+	FProcessingTarget& ProcessingTarget = ProcessingTargets[TargetIndex];
+
+	UMeshProcessingPreview* Preview = NewObject<UMeshProcessingPreview>(this);
+	FComponentMaterialSet MaterialSet = UE::ToolTarget::GetMaterialSet(Targets[TargetIndex]);
+	Preview->Setup(TargetWorld.Get(), (FTransform)ProcessingTarget.Transform, MaterialSet.Materials, ToolSetupUtil::GetDefaultWorkingMaterial(GetToolManager()));
+
+	Preview->OnOpDiscarded.AddLambda([this, TargetIndex](const FMeshProcessingOperator* Operator)
+	{
+		if (Operator->IsSuperseded())
+		{
+			ProcessingTargets[TargetIndex].Generation->RecordDiscardedResult();
+			INC_DWORD_STAT(STAT_MultiMeshProcessing_DiscardedResults);
+			TRACE_COUNTER_INCREMENT(MultiMeshProcessing_DiscardedResults);
+		}
+		else if (Operator->GetResultInfo().Result == EGeometryResultType::Failed)
+		{
+			const TArray<FGeometryError>& Errors = Operator->GetResultInfo().Errors;
+			DisplayComputeWarning(
+				FText::Format(LOCTEXT("ComputeFailedMessage", "Compute failed, the preview shows the previous result: {0}"),
+					(Errors.Num() > 0) ? Errors.Last().Message : LOCTEXT("ComputeFailedUnknown", "no details")));
+		}
+	});
+
+	Preview->OnOpCompleted.AddLambda([this, TargetIndex](const FMeshProcessingOperator* Operator)
+	{
+		ProcessingTargets[TargetIndex].ResultQualityReduction = ProcessingTargets[TargetIndex].ComputeQualityReduction;
+		UpdateQualityGovernor(Previews[TargetIndex]->GetLastComputeSeconds());
+
+		OnOperatorCompleted(TargetIndex, Operator);
+
+		// the next refinement level belongs to the same generation, so the previous level stays valid until it is replaced
+		FProcessingTarget& ProcessingTarget = ProcessingTargets[TargetIndex];
+		if (ProcessingTarget.bComputePending == false && ProcessingTarget.RefinementLevel + 1 < GetNumRefinementLevels(TargetIndex))
+		{
+			ProcessingTarget.RefinementLevel++;
+			ProcessingTarget.bComputePending = true;
+		}
+	});
+
+	Previews.Add(Preview);
+}
+
+
+void UBaseMultiMeshProcessingTool::UpdatePendingInputs()
+{
+	for (int32 k = 0; k < ProcessingTargets.Num(); ++k)
+	{
+		FProcessingTarget& ProcessingTarget = ProcessingTargets[k];
+		if (ProcessingTarget.PendingInput.IsValid() && ProcessingTarget.PendingInput.IsReady())
+		{
+			FToolInputMeshCache::FInput Input = ProcessingTarget.PendingInput.Get();
+			ProcessingTarget.PendingInput.Reset();
+			ProcessingTarget.InitialMesh = Input.Mesh;
+			ProcessingTarget.InitialVtxNormals = Input.VertexNormals;
+
+			// the source object stays visible until the preview can replace it
+			Previews[k]->SetInitialResult(*ProcessingTarget.InitialMesh);
+			Previews[k]->SetVisibility(true);
+			UE::ToolTarget::HideSourceObject(Targets[k]);
+
+			OnInputReady(k);
+		}
+	}
+}
+
+
+bool UBaseMultiMeshProcessingTool::AreAllInputsReady() const
+{
+	for (int32 k = 0; k < ProcessingTargets.Num(); ++k)
+	{
+		if (IsInputReady(k) == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void UBaseMultiMeshProcessingTool::Shutdown(EToolShutdownType ShutdownType)
+{
+	// deferred operators never run, release them before the subclass waits for its operators to finish.
+	// Inputs that are still loading read the source MeshDescriptions, so they must finish before anything is committed.
+	for (FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		ProcessingTarget.DeferredOperator.Reset();
+		if (ProcessingTarget.PendingInput.IsValid())
+		{
+			ProcessingTarget.PendingInput.Wait();
+			ProcessingTarget.PendingInput.Reset();
+		}
+	}
+
+	OnShutdown(ShutdownType);
+
+	MultiMeshProperties->SaveProperties(this);
+
+	UE_LOG(LogSampleModelingModeExtension, Verbose, TEXT("%s: %lld stale operator exits, %lld discarded results"),
+		*GetClass()->GetName(), GetNumStaleOperatorExits(), GetNumDiscardedResults());
+	FMeshProcessingComputePool::FMetrics PoolMetrics = FMeshProcessingComputePool::Get().GetMetrics();
+	UE_LOG(LogSampleModelingModeExtension, Verbose, TEXT("Compute pool: %d threads, %lld completed, %lld dropped, peak queue depth %d"),
+		PoolMetrics.NumThreads, PoolMetrics.NumCompleted, PoolMetrics.NumDropped, PoolMetrics.PeakQueueDepth);
+
+	TArray<TUniquePtr<FDynamicMesh3>> Results;
+	for (UMeshProcessingPreview* Preview : Previews)
+	{
+		Results.Add(Preview->Shutdown());
+	}
+	for (UToolTarget* Target : Targets)
+	{
+		UE::ToolTarget::ShowSourceObject(Target);
+	}
+
+	if (ShutdownType == EToolShutdownType::Accept && (RequiresFinalCompute() || HaveReducedQualityResults()))
+	{
+		ComputeFinalResults(Results);
+	}
+
+	if (ShutdownType == EToolShutdownType::Accept)
+	{
+		// all targets are updated in a single transaction
+		GetToolManager()->BeginUndoTransaction(GetAcceptTransactionName());
+		for (int32 k = 0; k < Results.Num(); ++k)
+		{
+			if (Results[k].IsValid() && CommitVertexDeltaUpdate(k, *Results[k]) == false)
+			{
+				// eg a vertex delta was rejected because the result has a different number of vertices or triangles
+				const FDynamicMesh3* InitialMesh = ProcessingTargets[k].InitialMesh.Get();
+				bool bTopologyChanged = HasMeshTopologyChanged() || InitialMesh == nullptr
+					|| InitialMesh->VertexCount() != Results[k]->VertexCount() || InitialMesh->TriangleCount() != Results[k]->TriangleCount();
+				UE::ToolTarget::CommitDynamicMeshUpdate(Targets[k], *Results[k], bTopologyChanged);
+			}
+		}
+		GetToolManager()->EndUndoTransaction();
+	}
+
+	Previews.Reset();
+	ProcessingTargets.Reset();
+}
+
+
+bool UBaseMultiMeshProcessingTool::CommitVertexDeltaUpdate(int32 TargetIndex, const FDynamicMesh3& Result)
+{
+	if (HasMeshTopologyChanged())
+	{
+		return false;
+	}
+
+	// only the LOD0 source mesh of a Static Mesh asset can be updated in place
+	const UStaticMeshComponent* Component = Cast<UStaticMeshComponent>(UE::ToolTarget::GetTargetComponent(Targets[TargetIndex]));
+	UStaticMesh* StaticMesh = (Component != nullptr) ? Component->GetStaticMesh() : nullptr;
+	if (StaticMesh == nullptr || StaticMesh->GetNumSourceModels() == 0
+		|| UE::ToolTarget::GetMeshDescription(Targets[TargetIndex]) != StaticMesh->GetMeshDescription(0))
+	{
+		return false;
+	}
+
+	return FMeshVertexDeltaChange::CommitVertexUpdate(StaticMesh, Result, GetToolManager(), GetAcceptTransactionName());
+}
+
+
+void UBaseMultiMeshProcessingTool::ComputeFinalResults(TArray<TUniquePtr<FDynamicMesh3>>& Results)
+{
+	// The operators are computed one at a time on the compute pool, which keeps them within the memory limit. The game thread
+	// keeps the progress dialog responsive, and services the work that operators queue for it (eg Blueprints), see TickFinalCompute().
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	// nothing is previewed any more, so the retained memory is not needed
+	ReleaseRetainedMemory();
+	uint64 MemoryLimit = GetOperatorMemoryLimit();
+
+	FScopedSlowTask SlowTask((float)Results.Num(), LOCTEXT("ComputeFinalResults", "Computing final results..."));
+	SlowTask.MakeDialog(true);
+
+	// state of a final compute, shared with the pool task
+	struct FFinalCompute
+	{
+		TUniquePtr<FMeshProcessingOperator> Operator;
+		FProgressCancel Progress;
+		std::atomic<bool> bCancelled{ false };
+		std::atomic<bool> bFinished{ false };
+	};
+
+	bool bCancelled = false;
+	for (int32 k = 0; k < Results.Num(); ++k)
+	{
+		SlowTask.EnterProgressFrame(1.0f);
+		if (bCancelled || Results[k].IsValid() == false)
+		{
+			continue;
+		}
+
+		bFinalCompute = true;
+		TUniquePtr<FMeshProcessingOperator> Operator = MakeNewOperator(k);
+		bFinalCompute = false;
+		if (Operator.IsValid() == false)
+		{
+			continue;
+		}
+
+		uint64 EstimatedMemory = Operator->EstimatePeakMemory();
+		while (EstimatedMemory > MemoryLimit && Settings->bDowngradeOverMemoryLimit && Operator->Downgrade())
+		{
+			EstimatedMemory = Operator->EstimatePeakMemory();
+		}
+		if (EstimatedMemory > MemoryLimit)
+		{
+			// the preview result is committed instead
+			UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("%s: the final result of target %d would exceed the memory limit, committing the preview result"),
+				*GetClass()->GetName(), k);
+			continue;
+		}
+
+		TSharedPtr<FFinalCompute, ESPMode::ThreadSafe> Compute = MakeShared<FFinalCompute, ESPMode::ThreadSafe>();
+		Compute->Operator = MoveTemp(Operator);
+		Compute->Progress.CancelF = [ComputePtr = Compute.Get()]() { return ComputePtr->bCancelled.load(); };
+		FMeshProcessingComputePool::Get().Submit(this, [Compute]()
+		{
+			Compute->Operator->CalculateResult(&Compute->Progress);
+			Compute->bFinished = true;
+		});
+
+		// a cancelled operator exits at its next stage boundary, it is waited for as it shares the Tool inputs
+		while (Compute->bFinished == false)
+		{
+			TickFinalCompute();
+			SlowTask.EnterProgressFrame(0.0f);
+			if (bCancelled == false && SlowTask.ShouldCancel())
+			{
+				bCancelled = true;
+				Compute->bCancelled = true;
+			}
+			FPlatformProcess::Sleep(0.01f);
+		}
+
+		TUniquePtr<FDynamicMesh3> FinalResult = Compute->Operator->ExtractResult();
+		if (bCancelled == false && FinalResult.IsValid() && Compute->Operator->GetResultInfo().Result == EGeometryResultType::Success)
+		{
+			Results[k] = MoveTemp(FinalResult);
+		}
+	}
+
+	if (bCancelled)
+	{
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("%s: the final compute was cancelled, committing the preview results of the remaining targets"),
+			*GetClass()->GetName());
+	}
+}
+
+
+void UBaseMultiMeshProcessingTool::OnTick(float DeltaTime)
+{
+	UpdatePendingInputs();
+
+	UpdateIdleFullQuality();
+
+	for (UMeshProcessingPreview* Preview : Previews)
+	{
+		Preview->Tick(DeltaTime);
+	}
+
+	UpdatePendingComputes();
+
+	UpdateMemoryMessage();
+}
+
+
+bool UBaseMultiMeshProcessingTool::CanAccept() const
+{
+	for (const FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		if (ProcessingTarget.bComputePending || ProcessingTarget.bComputeRefused)
+		{
+			return false;
+		}
+	}
+	for (const UMeshProcessingPreview* Preview : Previews)
+	{
+		if (Preview->HaveValidResult() == false)
+		{
+			return false;
+		}
+	}
+	return Previews.Num() > 0;
+}
+
+
+FText UBaseMultiMeshProcessingTool::GetAcceptTransactionName() const
+{
+	return LOCTEXT("DefaultTransactionName", "Mesh Processing");
+}
+
+
+void UBaseMultiMeshProcessingTool::InvalidateResult()
+{
+	if (bInternalInvalidate == false)
+	{
+		LastInteractionTime = FPlatformTime::Seconds();
+		bIdleFullQuality = false;
+	}
+	for (int32 k = 0; k < ProcessingTargets.Num(); ++k)
+	{
+		ProcessingTargets[k].Generation->Advance();
+		ProcessingTargets[k].bComputePending = true;
+		ProcessingTargets[k].RefinementLevel = 0;
+	}
+	INC_DWORD_STAT_BY(STAT_MultiMeshProcessing_Invalidations, ProcessingTargets.Num());
+	TRACE_COUNTER_ADD(MultiMeshProcessing_Invalidations, ProcessingTargets.Num());
+	UpdatePendingComputes();
+}
+
+
+void UBaseMultiMeshProcessingTool::InvalidateResult(int32 TargetIndex)
+{
+	if (bInternalInvalidate == false)
+	{
+		LastInteractionTime = FPlatformTime::Seconds();
+		bIdleFullQuality = false;
+	}
+	ProcessingTargets[TargetIndex].Generation->Advance();
+	ProcessingTargets[TargetIndex].bComputePending = true;
+	ProcessingTargets[TargetIndex].RefinementLevel = 0;
+	INC_DWORD_STAT(STAT_MultiMeshProcessing_Invalidations);
+	TRACE_COUNTER_INCREMENT(MultiMeshProcessing_Invalidations);
+	UpdatePendingComputes();
+}
+
+
+UBaseMultiMeshProcessingTool::EStartComputeResult UBaseMultiMeshProcessingTool::StartCompute(int32 TargetIndex, uint64 AvailableMemory)
+{
+	FProcessingTarget& ProcessingTarget = ProcessingTargets[TargetIndex];
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	uint64 MemoryLimit = GetOperatorMemoryLimit();
+
+	// reuse the operator of a deferred compute, unless it has been superseded in the meantime
+	TUniquePtr<FMeshProcessingOperator> Operator = MoveTemp(ProcessingTarget.DeferredOperator);
+	if (Operator.IsValid() == false || Operator->IsSuperseded())
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MultiMeshProcessing_MakeNewOperator);
+		Operator = MakeNewOperator(TargetIndex);
+		if (Operator.IsValid() == false)
+		{
+			// the target cannot be processed with the current settings, it keeps showing its current result
+			ProcessingTarget.bComputePending = false;
+			return EStartComputeResult::Skipped;
+		}
+		Operator->SetGenerationCounter(ProcessingTarget.Generation);
+		ProcessingTarget.ComputeQualityReduction = GetPreviewQualityReduction();
+	}
+
+	uint64 EstimatedMemory = Operator->EstimatePeakMemory();
+	uint64 RetainedMemory = GetRetainedMemory();
+	if (EstimatedMemory > MemoryLimit && RetainedMemory > 0)
+	{
+		// the retained memory only saves time, so it is released before the quality is reduced
+		ReleaseRetainedMemory();
+		uint64 ReleasedMemory = RetainedMemory - FMath::Min(RetainedMemory, GetRetainedMemory());
+		MemoryLimit = GetOperatorMemoryLimit();
+		AvailableMemory += ReleasedMemory;
+	}
+	bool bDowngraded = false;
+	while (EstimatedMemory > MemoryLimit && Settings->bDowngradeOverMemoryLimit && Operator->Downgrade())
+	{
+		EstimatedMemory = Operator->EstimatePeakMemory();
+		bDowngraded = true;
+	}
+
+	if (EstimatedMemory > MemoryLimit)
+	{
+		// this compute can never fit, so the preview must not keep showing a result for the previous settings
+		Previews[TargetIndex]->CancelCompute();
+		ProcessingTarget.bComputePending = false;
+		ProcessingTarget.bComputeRefused = true;
+		DisplayComputeWarning(
+			FText::Format(LOCTEXT("ComputeRefusedMessage", "Compute refused: estimated {0} MB exceeds the memory limit of {1} MB"),
+				FText::AsNumber(EstimatedMemory / (1024 * 1024)), FText::AsNumber(MemoryLimit / (1024 * 1024))));
+		return EStartComputeResult::Refused;
+	}
+
+	if (EstimatedMemory > AvailableMemory)
+	{
+		// wait for the running computes to release their memory
+		ProcessingTarget.DeferredOperator = MoveTemp(Operator);
+		return EStartComputeResult::Deferred;
+	}
+
+	ProcessingTarget.bComputePending = false;
+	ProcessingTarget.bComputeRefused = false;
+	if (bDowngraded)
+	{
+		// higher refinement levels would be downgraded to the same result
+		ProcessingTarget.RefinementLevel = FMath::Max(ProcessingTarget.RefinementLevel, GetNumRefinementLevels(TargetIndex) - 1);
+	}
+	DisplayComputeWarning((bDowngraded) ?
+		LOCTEXT("ComputeDowngradedMessage", "Compute quality was reduced to fit the memory limit") : FText::GetEmpty());
+	// refinements keep showing the previous level rather than the working material
+	Previews[TargetIndex]->StartCompute(MoveTemp(Operator), ProcessingTarget.RefinementLevel == 0);
+	return EStartComputeResult::Started;
+}
+
+
+void UBaseMultiMeshProcessingTool::UpdatePendingComputes()
+{
+	uint64 MemoryLimit = GetOperatorMemoryLimit();
+	auto GetAvailableMemory = [this, MemoryLimit](int32 ExcludeIndex)
+	{
+		uint64 ReservedMemory = 0;
+		for (int32 k = 0; k < Previews.Num(); ++k)
+		{
+			ReservedMemory += (k != ExcludeIndex) ? Previews[k]->GetActiveComputeEstimatedMemory() : 0;
+		}
+		return (ReservedMemory < MemoryLimit) ? (MemoryLimit - ReservedMemory) : 0;
+	};
+
+	int32 NumRunning = 0;
+	for (int32 k = 0; k < Previews.Num(); ++k)
+	{
+		if (Previews[k]->IsComputing())
+		{
+			// restarting an already-running compute does not add to the concurrency, and releases its own memory
+			if (ProcessingTargets[k].bComputePending)
+			{
+				if (StartCompute(k, GetAvailableMemory(k)) != EStartComputeResult::Started)
+				{
+					Previews[k]->CancelCompute();
+					continue;
+				}
+			}
+			NumRunning++;
+		}
+	}
+
+	int32 MaxConcurrent = FMath::Max(1, MultiMeshProperties->MaxConcurrentComputes);
+	for (int32 k = 0; k < Previews.Num() && NumRunning < MaxConcurrent; ++k)
+	{
+		if (ProcessingTargets[k].bComputePending && IsInputReady(k) && Previews[k]->IsComputing() == false)
+		{
+			// a compute that fits under the limit on its own always starts if nothing else is running
+			uint64 AvailableMemory = (NumRunning == 0) ? MemoryLimit : GetAvailableMemory(-1);
+			if (StartCompute(k, AvailableMemory) == EStartComputeResult::Started)
+			{
+				NumRunning++;
+			}
+		}
+	}
+}
+
+
+void UBaseMultiMeshProcessingTool::DisplayComputeWarning(const FText& Message)
+{
+	if (Message.EqualTo(DisplayedComputeWarning) == false)
+	{
+		DisplayedComputeWarning = Message;
+		GetToolManager()->DisplayMessage(Message, EToolMessageLevel::UserWarning);
+	}
+}
+
+
+uint64 UBaseMultiMeshProcessingTool::GetOperatorMemoryLimit() const
+{
+	uint64 MemoryLimit = GetDefault<USampleModelingModeExtensionSettings>()->GetOperatorMemoryLimit();
+	uint64 RetainedMemory = GetRetainedMemory();
+	return (RetainedMemory < MemoryLimit) ? (MemoryLimit - RetainedMemory) : 0;
+}
+
+
+int32 UBaseMultiMeshProcessingTool::GetPreviewQualityReduction() const
+{
+	if (bFinalCompute || bIdleFullQuality || GetDefault<USampleModelingModeExtensionSettings>()->bAdaptivePreviewQuality == false)
+	{
+		return 0;
+	}
+	return FMath::Clamp(QualityReduction, 0, GetMaxPreviewQualityReduction());
+}
+
+
+FText UBaseMultiMeshProcessingTool::GetPreviewQualityDescription(int32 Reduction) const
+{
+	return (Reduction == 0) ? LOCTEXT("FullPreviewQuality", "full quality") :
+		FText::Format(LOCTEXT("ReducedPreviewQuality", "reduced quality ({0})"), FText::AsNumber(Reduction));
+}
+
+
+void UBaseMultiMeshProcessingTool::UpdateQualityGovernor(double ComputeSeconds)
+{
+	LastLatency = ComputeSeconds;
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	if (Settings->bAdaptivePreviewQuality == false || bIdleFullQuality)
+	{
+		return;
+	}
+
+	// the latency is smoothed over a few computes, and measured again from scratch after each quality change
+	SmoothedLatency = (SmoothedLatency > 0) ? 0.5 * (SmoothedLatency + ComputeSeconds) : ComputeSeconds;
+	double TargetLatency = (double)FMath::Max(1, Settings->TargetPreviewLatencyMs) / 1000.0;
+	if (SmoothedLatency > TargetLatency && QualityReduction < GetMaxPreviewQualityReduction())
+	{
+		QualityReduction++;
+		SmoothedLatency = 0;
+	}
+	else if (SmoothedLatency < 0.25 * TargetLatency && QualityReduction > 0)
+	{
+		// well below the target, so the next step up is likely to fit
+		QualityReduction--;
+		SmoothedLatency = 0;
+	}
+}
+
+
+bool UBaseMultiMeshProcessingTool::HaveReducedQualityResults() const
+{
+	for (const FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		if (ProcessingTarget.ResultQualityReduction > 0 || (ProcessingTarget.bComputePending && ProcessingTarget.ComputeQualityReduction > 0))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void UBaseMultiMeshProcessingTool::UpdateIdleFullQuality()
+{
+	if (bIdleFullQuality || GetMaxPreviewQualityReduction() == 0)
+	{
+		return;
+	}
+	double IdleSeconds = FMath::Max(0.0f, GetDefault<USampleModelingModeExtensionSettings>()->FullQualityIdleSeconds);
+	if (FPlatformTime::Seconds() - LastInteractionTime < IdleSeconds)
+	{
+		return;
+	}
+
+	// the governed reduction is kept, so that the next interaction starts at the same quality
+	bool bRecompute = HaveReducedQualityResults();
+	for (const FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		bRecompute = bRecompute || ProcessingTarget.ComputeQualityReduction > 0;
+	}
+	bIdleFullQuality = true;
+	if (bRecompute)
+	{
+		bInternalInvalidate = true;
+		InvalidateResult();
+		bInternalInvalidate = false;
+	}
+}
+
+
+uint64 UBaseMultiMeshProcessingTool::GetCurrentOperatorMemory() const
+{
+	uint64 CurrentMemory = 0;
+	for (const UMeshProcessingPreview* Preview : Previews)
+	{
+		CurrentMemory += Preview->GetActiveComputeCurrentMemory();
+	}
+	return CurrentMemory;
+}
+
+
+void UBaseMultiMeshProcessingTool::UpdateMemoryMessage(bool bForce)
+{
+	uint64 CurrentMemory = GetCurrentOperatorMemory();
+	PeakOperatorMemory = FMath::Max(PeakOperatorMemory, CurrentMemory);
+
+	uint64 CurrentMB = CurrentMemory / (1024 * 1024);
+	uint64 PeakMB = PeakOperatorMemory / (1024 * 1024);
+	int32 NumLoading = 0;
+	for (int32 k = 0; k < ProcessingTargets.Num(); ++k)
+	{
+		NumLoading += (IsInputReady(k)) ? 0 : 1;
+	}
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	bool bShowQuality = Settings->bAdaptivePreviewQuality && GetMaxPreviewQualityReduction() > 0;
+	int32 DisplayReduction = GetPreviewQualityReduction();
+	int32 LatencyMs = (int32)(LastLatency * 1000.0);
+	if (bForce || CurrentMB != DisplayedCurrentMemoryMB || PeakMB != DisplayedPeakMemoryMB || NumLoading != DisplayedNumLoading
+		|| (bShowQuality && (DisplayReduction != DisplayedQualityReduction || LatencyMs != DisplayedLatencyMs)))
+	{
+		DisplayedCurrentMemoryMB = CurrentMB;
+		DisplayedPeakMemoryMB = PeakMB;
+		DisplayedNumLoading = NumLoading;
+		DisplayedQualityReduction = DisplayReduction;
+		DisplayedLatencyMs = LatencyMs;
+		FText MemoryText = FText::Format(LOCTEXT("OperatorMemoryMessage", "Compute memory: {0} MB (peak {1} MB, limit {2} MB)"),
+			FText::AsNumber(CurrentMB), FText::AsNumber(PeakMB), FText::AsNumber(Settings->OperatorMemoryLimitMB));
+		if (NumLoading > 0)
+		{
+			MemoryText = FText::Format(LOCTEXT("LoadingInputsMessage", "Loading meshes: {0} of {1} ready\n{2}"),
+				FText::AsNumber(ProcessingTargets.Num() - NumLoading), FText::AsNumber(ProcessingTargets.Num()), MemoryText);
+		}
+		if (bShowQuality)
+		{
+			MemoryText = FText::Format(LOCTEXT("PreviewQualityMessage", "Preview: {0}, {1} ms (target {2} ms)\n{3}"),
+				GetPreviewQualityDescription(DisplayReduction), FText::AsNumber(LatencyMs), FText::AsNumber(Settings->TargetPreviewLatencyMs), MemoryText);
+		}
+		FText ToolMessage = GetToolMessageString();
+		GetToolManager()->DisplayMessage(
+			(ToolMessage.IsEmpty()) ? MemoryText : FText::Format(LOCTEXT("ToolMessageWithMemory", "{0}\n{1}"), ToolMessage, MemoryText),
+			EToolMessageLevel::UserNotification);
+	}
+}
+
+
+int64 UBaseMultiMeshProcessingTool::GetNumStaleOperatorExits() const
+{
+	int64 Count = 0;
+	for (const FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		Count += ProcessingTarget.Generation->GetNumStaleExits();
+	}
+	return Count;
+}
+
+
+int64 UBaseMultiMeshProcessingTool::GetNumDiscardedResults() const
+{
+	int64 Count = 0;
+	for (const FProcessingTarget& ProcessingTarget : ProcessingTargets)
+	{
+		Count += ProcessingTarget.Generation->GetNumDiscardedResults();
+	}
+	return Count;
+}
+
+
+FAxisAlignedBox3d UBaseMultiMeshProcessingTool::GetCombinedWorldBounds() const
+{
+	FAxisAlignedBox3d WorldBounds = FAxisAlignedBox3d::Empty();
+	for (int32 TargetIndex = 0; TargetIndex < ProcessingTargets.Num(); ++TargetIndex)
+	{
+		const FProcessingTarget& ProcessingTarget = ProcessingTargets[TargetIndex];
+		if (IsInputReady(TargetIndex) == false)
+		{
+			// the component bounds are available immediately, and are close enough eg for initial Gizmo placement
+			if (const UPrimitiveComponent* Component = UE::ToolTarget::GetTargetComponent(Targets[TargetIndex]))
+			{
+				WorldBounds.Contain(FAxisAlignedBox3d(Component->Bounds.GetBox()));
+			}
+			continue;
+		}
+		FAxisAlignedBox3d LocalBounds = ProcessingTarget.InitialMesh->GetBounds();
+		for (int32 k = 0; k < 8; ++k)
+		{
+			WorldBounds.Contain(ProcessingTarget.Transform.TransformPosition(LocalBounds.GetCorner(k)));
+		}
+	}
+	return WorldBounds;
+}
+
+
+
+#undef LOCTEXT_NAMESPACE
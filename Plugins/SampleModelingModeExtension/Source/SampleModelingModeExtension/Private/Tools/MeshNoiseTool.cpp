@@ -5,9 +5,9 @@
 #include "InteractiveToolManager.h"
 #include "ToolBuilderUtil.h"
 #include "DynamicMesh/DynamicMesh3.h"
-#include "DynamicMesh/MeshNormals.h"
-#include "Operations/PNTriangles.h"
-#include "ModelingOperators.h"
+#include "Operations/MeshNoiseOp.h"
+#include "Operations/TessellationDiskCache.h"
+#include "SampleModelingModeExtensionSettings.h"
 
 using namespace UE::Geometry;
 
@@ -28,11 +28,33 @@ void UMeshNoiseTool::InitializeProperties()
 	NoiseProperties = NewObject<UMeshNoiseProperties>(this);
 	AddToolPropertySource(NoiseProperties);
 	NoiseProperties->RestoreProperties(this);
-	NoiseProperties->WatchProperty(NoiseProperties->Subdivisions, [&](int) { InvalidateResult();  });
+	NoiseProperties->WatchProperty(NoiseProperties->Subdivisions, [&](int) { TrimTessellationCache(); InvalidateResult();  });
 	NoiseProperties->WatchProperty(NoiseProperties->NoiseType, [&](EMeshNoiseToolNoiseType) { InvalidateResult();  });
 	NoiseProperties->WatchProperty(NoiseProperties->Scale, [&](float) { InvalidateResult();  });
 	NoiseProperties->WatchProperty(NoiseProperties->Frequency, [&](float) { InvalidateResult();  });
 	NoiseProperties->WatchProperty(NoiseProperties->Seed, [&](int NewSeed) { InvalidateResult();  });
+	NoiseProperties->WatchProperty(NoiseProperties->bFastPreview, [&](bool) { InvalidateResult();  });
+	NoiseProperties->WatchProperty(NoiseProperties->bProgressivePreview, [&](bool) { TrimTessellationCache(); InvalidateResult();  });
+	NoiseProperties->WatchProperty(NoiseProperties->bAnalyticNormals, [&](bool) { InvalidateResult();  });
+
+	MaskProperties = NewObject<UMeshNoiseMaskProperties>(this);
+	AddToolPropertySource(MaskProperties);
+	MaskProperties->RestoreProperties(this);
+
+	// the mask box is initialized to the middle of the target objects
+	FAxisAlignedBox3d WorldBounds = GetCombinedWorldBounds();
+	MaskProperties->VolumeCenter = WorldBounds.Center();
+	MaskProperties->VolumeExtents = 0.25 * WorldBounds.Extents();
+}
+
+
+void UMeshNoiseTool::OnPropertyModified(UObject* PropertySet, FProperty* Property)
+{
+	// the mask does not change the tessellation, so the cached tessellations stay valid
+	if (PropertySet == MaskProperties)
+	{
+		InvalidateResult();
+	}
 }
 
 
@@ -40,170 +62,199 @@ void UMeshNoiseTool::InitializeProperties()
 void UMeshNoiseTool::OnShutdown(EToolShutdownType ShutdownType)
 {
 	NoiseProperties->SaveProperties(this);
+	MaskProperties->SaveProperties(this);
 }
 
 
-FText UMeshNoiseTool::GetToolMessageString() const
+void UMeshNoiseTool::OnOperatorCompleted(int32 TargetIndex, const FMeshProcessingOperator* Operator)
 {
-	return LOCTEXT("StartMeshNoiseMessage", "Add noise to the mesh vertex positions.");
-}
+	// all the operators of this Tool are FMeshNoiseOp
+	const FMeshNoiseOp* NoiseOp = static_cast<const FMeshNoiseOp*>(Operator);
 
-FText UMeshNoiseTool::GetAcceptTransactionName() const
-{
-	return LOCTEXT("MeshNoiseToolTransactionName", "Mesh Noise");
+	// the input mesh hash is computed by the first operator that uses the disk cache, the later operators reuse it
+	if (NoiseOp->InputMeshHash != 0)
+	{
+		InputMeshHashes.SetNumZeroed(GetNumTargets());
+		InputMeshHashes[TargetIndex] = NoiseOp->InputMeshHash;
+	}
+
+	// only the completed level and the next one are kept, the lower levels are tessellated again after a restart
+	int32 CurrentLevel = NoiseOp->GetOptions().Subdivisions;
+	TessellationCache.SetNum(GetNumTargets());
+	TArray<FMeshNoiseOp::FTessellation, TFixedAllocator<2>>& Levels = TessellationCache[TargetIndex];
+	Levels.RemoveAll([CurrentLevel](const FMeshNoiseOp::FTessellation& Cached)
+	{
+		return Cached.Subdivisions != CurrentLevel && Cached.Subdivisions != CurrentLevel + 1;
+	});
+
+	const FMeshNoiseOp::FTessellation& Tessellation = NoiseOp->Tessellation;
+	if (NoiseProperties->bProgressivePreview == false || Tessellation.Mesh.IsValid() == false
+		|| Tessellation.Subdivisions <= 0 || Tessellation.Subdivisions > NoiseProperties->Subdivisions
+		|| FindCachedTessellation(TargetIndex, Tessellation.Subdivisions) != nullptr)
+	{
+		return;
+	}
+	Levels.Add(Tessellation);
 }
 
 
-bool UMeshNoiseTool::HasMeshTopologyChanged() const
+const FMeshNoiseOp::FTessellation* UMeshNoiseTool::FindCachedTessellation(int32 TargetIndex, int32 Subdivisions) const
 {
-	return false;
+	if (TessellationCache.IsValidIndex(TargetIndex) == false)
+	{
+		return nullptr;
+	}
+	return TessellationCache[TargetIndex].FindByPredicate([Subdivisions](const FMeshNoiseOp::FTessellation& Cached) { return Cached.Subdivisions == Subdivisions; });
 }
 
 
-
-namespace Local
+void UMeshNoiseTool::TrimTessellationCache()
 {
+	int32 MaxSubdivisions = (NoiseProperties->bProgressivePreview) ? NoiseProperties->Subdivisions : 0;
+	for (TArray<FMeshNoiseOp::FTessellation, TFixedAllocator<2>>& Levels : TessellationCache)
+	{
+		Levels.RemoveAll([MaxSubdivisions](const FMeshNoiseOp::FTessellation& Cached) { return Cached.Subdivisions > MaxSubdivisions; });
+	}
+}
+
 
-/**
- * FMeshPlaneCutOp actually computes the mesh deformation. The constructor runs on the game thread
- * (called in MakeNewOperator below) however the CalculateResult function is run from a
- * background compute thread.
- */
-class FMeshNoiseOp : public FDynamicMeshOperator
+uint64 UMeshNoiseTool::GetRetainedMemory() const
 {
-public:
-	struct FOptions
+	// tessellations that are shared with a running operator are counted here as well as in its estimate
+	uint64 Bytes = 0;
+	for (const TArray<FMeshNoiseOp::FTessellation, TFixedAllocator<2>>& Levels : TessellationCache)
 	{
-		int32 Subdivisions = 0;
+		for (const FMeshNoiseOp::FTessellation& Cached : Levels)
+		{
+			Bytes += FMeshProcessingOperator::EstimateMeshMemory(*Cached.Mesh) + (uint64)Cached.VertexNormals->GetAllocatedSize();
+		}
+	}
+	return Bytes;
+}
 
-		EMeshNoiseToolNoiseType NoiseType;
-		double Magnitude = 1.0;
-		int32 RandomSeed = 0;
-		double Frequency = 1.0;
-	};
 
-	TSharedPtr<FMeshNormals> BaseMeshNormals;
+void UMeshNoiseTool::ReleaseRetainedMemory()
+{
+	TessellationCache.Reset();
+}
 
-	FMeshNoiseOp(const FDynamicMesh3* Mesh, FOptions Options)
-	{
-		UseOptions = Options;
-		ResultMesh->Copy(*Mesh);		// copy input mesh into output mesh. Do not hold onto input Mesh reference as it is temporary!!
-	}
 
-	virtual ~FMeshNoiseOp() override {}
+FText UMeshNoiseTool::GetToolMessageString() const
+{
+	return LOCTEXT("StartMeshNoiseMessage", "Add noise to the mesh vertex positions.");
+}
 
-	// set ability on protected transform.
-	void SetTransform(const FTransformSRT3d& XForm)
-	{
-		ResultTransform = XForm;
-	}
+FText UMeshNoiseTool::GetAcceptTransactionName() const
+{
+	return LOCTEXT("MeshNoiseToolTransactionName", "Mesh Noise");
+}
 
-	// Called on background thread to compute the mesh op result. 
-	// The input mesh is stored and returned via .ResultMesh member.
-	// .ResultInfo member is used to indicate success/failure
-	virtual void CalculateResult(FProgressCancel* Progress) override
-	{
-		ResultInfo = FGeometryResult();
 
-		FMeshNormals SubdividedMeshNormals;
+bool UMeshNoiseTool::HasMeshTopologyChanged() const
+{
+	// the PN tessellation adds vertices and triangles
+	return NoiseProperties->Subdivisions > 0;
+}
 
-		// If subdivisions were requested, compute it
-		// (Excercise for the reader: This mesh could be cached at the Tool level...)
-		if (UseOptions.Subdivisions > 0)
-		{
-			FPNTriangles PNTriangles(ResultMesh.Get());
-			PNTriangles.TessellationLevel = UseOptions.Subdivisions;
-			PNTriangles.Progress = Progress;
-			if (PNTriangles.Validate() == EOperationValidationResult::Ok)
-			{
-				PNTriangles.Compute();
-			}
-
-			// once we have subdivided, we will need to recompute vertex normals on the base mesh...
-			if (Progress->Cancelled() == false)
-			{
-				SubdividedMeshNormals = FMeshNormals(ResultMesh.Get());
-				SubdividedMeshNormals.ComputeVertexNormals();
-			}
-		}
+bool UMeshNoiseTool::RequiresFinalCompute() const
+{
+	return NoiseProperties->bFastPreview;
+}
 
-		// abort if we were cancelled
-		if (ResultInfo.CheckAndSetCancelled(Progress))
-		{
-			return;
-		}
+int32 UMeshNoiseTool::GetNumRefinementLevels(int32 TargetIndex) const
+{
+	// level 0 displaces the input mesh directly, so the first result is available quickly
+	return (NoiseProperties->bProgressivePreview) ? GetPreviewSubdivisions(GetPreviewQualityReduction()) + 1 : 1;
+}
 
-		// create stream for randomization
-		FRandomStream Stream(UseOptions.RandomSeed);
+int32 UMeshNoiseTool::GetMaxPreviewQualityReduction() const
+{
+	return NoiseProperties->Subdivisions + ((NoiseProperties->bFastPreview) ? 0 : 1);
+}
 
-		// Loop over vertices and update positions in-place
-		for (int32 vid : ResultMesh->VertexIndicesItr())
-		{
-			FVector3d Position = ResultMesh->GetVertex(vid);
-			FVector3d Normal = (UseOptions.Subdivisions > 0) ? SubdividedMeshNormals[vid] : (*BaseMeshNormals)[vid];
-
-			FVector3d NewPosition = Position;
-			if (UseOptions.NoiseType == EMeshNoiseToolNoiseType::Random)
-			{
-				double RandomAlpha = Stream.GetFraction();
-				NewPosition = Position + (UseOptions.Magnitude * RandomAlpha * Normal);
-			}
-			else
-			{
-				// Frequency is manipulated here to provide a nicer range for the slider. This is scale-dependent, though!
-				double NoiseValue = FMath::PerlinNoise3D( FMathd::Pow(UseOptions.Frequency * 0.1, 2.0) * Position);
-				NewPosition = Position + (UseOptions.Magnitude * NoiseValue * Normal);
-			}
-			
-			ResultMesh->SetVertex(vid, NewPosition);
-
-			// don't check for cancel every iteration because it is somewhat expensive
-			if ( vid % 1000 && ResultInfo.CheckAndSetCancelled(Progress))
-			{
-				return;
-			}
-		}
+bool UMeshNoiseTool::IsSinglePrecisionPreview(int32 QualityReduction) const
+{
+	return NoiseProperties->bFastPreview || QualityReduction > 0;
+}
 
-		// recalculate normals
-		if (Progress->Cancelled() == false)
-		{
-			if (ResultMesh->HasAttributes())
-			{
-				FMeshNormals::QuickRecomputeOverlayNormals(*ResultMesh);
-			}
-			else
-			{
-				FMeshNormals::QuickComputeVertexNormals(*ResultMesh);
-			}
-		}
+int32 UMeshNoiseTool::GetPreviewSubdivisions(int32 QualityReduction) const
+{
+	int32 SubdivisionReduction = QualityReduction - ((NoiseProperties->bFastPreview) ? 0 : 1);
+	return FMath::Clamp(NoiseProperties->Subdivisions - SubdivisionReduction, 0, NoiseProperties->Subdivisions);
+}
 
-		ResultInfo.SetSuccess(true, Progress);
+FText UMeshNoiseTool::GetPreviewQualityDescription(int32 QualityReduction) const
+{
+	if (QualityReduction == 0)
+	{
+		return Super::GetPreviewQualityDescription(QualityReduction);
 	}
+	return FText::Format(LOCTEXT("NoisePreviewQuality", "{0} of {1} subdivisions, single precision"),
+		FText::AsNumber(GetPreviewSubdivisions(QualityReduction)), FText::AsNumber(NoiseProperties->Subdivisions));
+}
 
 
-protected:
-	FOptions UseOptions;
-};
-
 
+FMeshNoiseOp::FOptions UMeshNoiseTool::MakeOperatorOptions(const UMeshNoiseProperties* Properties)
+{
+	FMeshNoiseOp::FOptions Options;
+	Options.Magnitude = Properties->Scale;
+	Options.NoiseType = Properties->NoiseType;
+	Options.RandomSeed = Properties->Seed;
+	Options.Frequency = Properties->Frequency;
+	Options.Subdivisions = Properties->Subdivisions;
+	Options.bAnalyticNormals = Properties->bAnalyticNormals;
+	const USampleModelingModeExtensionSettings* Settings = GetDefault<USampleModelingModeExtensionSettings>();
+	Options.BatchMemoryBudget = (uint64)FMath::Max(0, Settings->DisplacementBatchBudgetMB) * 1024 * 1024;
+	Options.ScratchFileDirectory = (Settings->bDisplacementScratchFile) ? FScratchFile::GetDefaultDirectory() : FString();
+	return Options;
 }
 
 
+FMeshNoiseOp::FMaskOptions UMeshNoiseTool::MakeMaskOptions(const UMeshNoiseMaskProperties* Properties)
+{
+	FMeshNoiseOp::FMaskOptions Mask;
+	Mask.Type = Properties->MaskType;
+	Mask.VolumeTransform = FTransformSRT3d(Properties->VolumeRotation.Quaternion(), (FVector3d)Properties->VolumeCenter);
+	Mask.VolumeExtents = (FVector3d)Properties->VolumeExtents;
+	Mask.VolumeFalloff = Properties->VolumeFalloff;
+	Mask.PolyGroupID = Properties->PolyGroupID;
+	Mask.WeightLayer = Properties->WeightLayer;
+	Mask.BlendRings = Properties->BlendRings;
+	return Mask;
+}
+
 
-TUniquePtr<FDynamicMeshOperator> UMeshNoiseTool::MakeNewOperator()
+TUniquePtr<FMeshProcessingOperator> UMeshNoiseTool::MakeNewOperator(int32 TargetIndex)
 {
 	// Copy options from the Property Sets. Note that it is not safe to pass the PropertySet directly
 	// to the MeshOp because the property set may be modified while the MeshOp computes in the background!
-	Local::FMeshNoiseOp::FOptions Options;
-	Options.Magnitude = NoiseProperties->Scale;
-	Options.NoiseType = NoiseProperties->NoiseType;
-	Options.RandomSeed = NoiseProperties->Seed;
-	Options.Frequency = NoiseProperties->Frequency;
-	Options.Subdivisions = NoiseProperties->Subdivisions;
-
-	TUniquePtr<Local::FMeshNoiseOp> MeshOp = MakeUnique<Local::FMeshNoiseOp>(&GetInitialMesh(), Options);
-	MeshOp->SetTransform( (FTransform3d)GetPreviewTransform() );
-	MeshOp->BaseMeshNormals = GetInitialVtxNormals();
+	FMeshNoiseOp::FOptions Options = MakeOperatorOptions(NoiseProperties);
+	if (IsFinalCompute() == false)
+	{
+		int32 QualityReduction = GetPreviewQualityReduction();
+		Options.bSinglePrecision = IsSinglePrecisionPreview(QualityReduction);
+		Options.Subdivisions = GetPreviewSubdivisions(QualityReduction);
+	}
+	if (GetNumRefinementLevels(TargetIndex) > 1 && IsFinalCompute() == false)
+	{
+		Options.Subdivisions = FMath::Min(GetRefinementLevel(TargetIndex), Options.Subdivisions);
+	}
+	Options.bKeepTessellation = NoiseProperties->bProgressivePreview;
+	Options.bTessellationDiskCache = FTessellationDiskCache::IsEnabled();
+	Options.Mask = MakeMaskOptions(MaskProperties);
+	TUniquePtr<FMeshNoiseOp> MeshOp = MakeUnique<FMeshNoiseOp>(Options);
+	MeshOp->SetInputMesh(GetSharedInitialMesh(TargetIndex));
+	MeshOp->SetTransform( (FTransform3d)GetPreviewTransform(TargetIndex) );
+	MeshOp->BaseMeshNormals = GetInitialVtxNormals(TargetIndex);
+	if (const FMeshNoiseOp::FTessellation* Cached = FindCachedTessellation(TargetIndex, Options.Subdivisions))
+	{
+		MeshOp->Tessellation = *Cached;
+	}
+	if (InputMeshHashes.IsValidIndex(TargetIndex))
+	{
+		MeshOp->InputMeshHash = InputMeshHashes[TargetIndex];
+	}
 
 	return MeshOp;
 }
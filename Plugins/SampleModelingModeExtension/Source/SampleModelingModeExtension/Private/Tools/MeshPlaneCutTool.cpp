@@ -5,14 +5,9 @@
 #include "InteractiveToolManager.h"
 #include "InteractiveGizmoManager.h"
 #include "DynamicMesh/DynamicMesh3.h"
-#include "DynamicMesh/MeshNormals.h"
-#include "DynamicMesh/MeshTransforms.h"
-#include "ModelingOperators.h"
+#include "Operations/MeshPlaneCutOp.h"
 #include "BaseGizmos/TransformGizmoUtil.h"
 
-#include "Operations/MeshPlaneCut.h"
-#include "ConstrainedDelaunay2.h"
-
 using namespace UE::Geometry;
 
 #define LOCTEXT_NAMESPACE "UMeshPlaneCutTool"
@@ -34,10 +29,9 @@ void UMeshPlaneCutTool::InitializeProperties()
 	AddToolPropertySource(Properties);
 	Properties->RestoreProperties(this);
 
-	// initialize the plane to be at the center of the target object bounding box, in world space
-	FAxisAlignedBox3d Bounds = GetInitialMesh().GetBounds();
-	FVector3d WorldSpaceOrigin = GetPreviewTransform().TransformPosition(Bounds.Center());
-	PlaneTransform = FTransform3d(WorldSpaceOrigin);
+	// initialize the plane to be at the center of the bounding box of all the target objects, in world space
+	FAxisAlignedBox3d WorldBounds = GetCombinedWorldBounds();
+	PlaneTransform = FTransform3d(WorldBounds.Center());
 
 	// Initialize the Position and Rotation tool properties. This should be done before
 	// setting up the Gizmo to avoid triggering an initial change event
@@ -126,81 +120,31 @@ bool UMeshPlaneCutTool::HasMeshTopologyChanged() const
 	return true;
 }
 
-
-
-namespace Local
+int32 UMeshPlaneCutTool::GetMaxPreviewQualityReduction() const
 {
+	return (Properties->bFillHole) ? 1 : 0;
+}
 
-/**
- * FMeshPlaneCutOp actually computes the plane cut. The constructor runs on the game thread
- * (called in MakeNewOperator below) however the CalculateResult function is run from a
- * background compute thread.
- */
-class FMeshPlaneCutOp : public FDynamicMeshOperator
+FText UMeshPlaneCutTool::GetPreviewQualityDescription(int32 QualityReduction) const
 {
-public:
-	struct FOptions
-	{
-		FTransform LocalToWorld;
-		FTransform WorldPlane;
-		bool bFillHole;
-	};
-
-	FMeshPlaneCutOp(const FDynamicMesh3* Mesh, FOptions Options)
-	{
-		UseOptions = Options;
-		ResultMesh->Copy(*Mesh);		// copy input mesh into output mesh. Do not hold onto input Mesh reference as it is temporary!!
-	}
-
-	virtual ~FMeshPlaneCutOp() override {}
-
-	// set ability on protected transform.
-	void SetTransform(const FTransformSRT3d& XForm)
-	{
-		ResultTransform = XForm;
-	}
-
-	// base class overrides this.  Results in updated ResultMesh. This function runs in a background thread!!
-	virtual void CalculateResult(FProgressCancel* Progress) override
-	{
-		// transform mesh to world space because that is where plane is (this will correctly handle nonuniform scale)
-		MeshTransforms::ApplyTransform(*ResultMesh, (FTransformSRT3d)UseOptions.LocalToWorld);
-
-		FFrame3d Frame(UseOptions.WorldPlane);
-		FMeshPlaneCut Cut(ResultMesh.Get(), Frame.Origin, Frame.Z());
-		Cut.Cut();
-
-		if (UseOptions.bFillHole)
-		{
-			Cut.HoleFill(ConstrainedDelaunayTriangulate<double>, false);
-		}
-
-		MeshTransforms::ApplyTransformInverse(*ResultMesh, (FTransformSRT3d)UseOptions.LocalToWorld);
-	}
-
-
-protected:
-	FOptions UseOptions;
-};
-
-
+	return (QualityReduction > 0) ? LOCTEXT("NoHoleFillPreviewQuality", "hole fill skipped") : Super::GetPreviewQualityDescription(QualityReduction);
 }
 
 
 
-TUniquePtr<FDynamicMeshOperator> UMeshPlaneCutTool::MakeNewOperator()
+TUniquePtr<FMeshProcessingOperator> UMeshPlaneCutTool::MakeNewOperator(int32 TargetIndex)
 {
 	// Copy options from the Property Sets. Note that it is not safe to pass the PropertySet directly
 	// to the MeshOp because the property set may be modified while the MeshOp computes in the background!
-	Local::FMeshPlaneCutOp::FOptions Options;
-	Options.LocalToWorld = GetPreviewTransform();
+	FMeshPlaneCutOp::FOptions Options;
+	Options.LocalToWorld = (FTransform)GetPreviewTransform(TargetIndex);
 	Options.WorldPlane = PlaneTransform;
-	Options.bFillHole = Properties->bFillHole;
+	Options.bFillHole = Properties->bFillHole && GetPreviewQualityReduction() == 0;
 
-	const FDynamicMesh3* Mesh = &GetInitialMesh();
-	TUniquePtr<Local::FMeshPlaneCutOp> MeshOp = MakeUnique<Local::FMeshPlaneCutOp>(Mesh, Options);
+	TUniquePtr<FMeshPlaneCutOp> MeshOp = MakeUnique<FMeshPlaneCutOp>(Options);
+	MeshOp->SetInputMesh(GetSharedInitialMesh(TargetIndex));
 
-	FTransform3d XForm3d(GetPreviewTransform());
+	FTransform3d XForm3d(GetPreviewTransform(TargetIndex));
 	MeshOp->SetTransform(XForm3d);
 
 	return MeshOp;
@@ -6,21 +6,36 @@
 #include "DynamicMesh/DynamicMesh3.h"
 #include "DynamicMesh/MeshNormals.h"
 #include "Operations/PNTriangles.h"
-#include "ModelingOperators.h"
+#include "Operations/MeshProcessingOperator.h"
 #include "Util/ProgressCancel.h"
 #include "UObject/StrongObjectPtr.h"
+#include "UDynamicMesh.h"
+#include "Operations/MeshProcessingOperationChain.h"
+#include "Operations/MeshChunkedExecution.h"
+#include "Operations/MeshProcessingPreset.h"
+#include "Operations/MeshProcessingWorkerOp.h"
+#include "MeshSimplification.h"
+#include "Async/Async.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
 
 using namespace UE::Geometry;
 
 #define LOCTEXT_NAMESPACE "UMeshProcessingBPTool"
 
+DECLARE_CYCLE_STAT(TEXT("BP Executor Queue Wait"), STAT_MeshProcessingBP_QueueWait, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("BP Executor Execute"), STAT_MeshProcessingBP_Execute, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("BP Chain"), STAT_MeshProcessingBP_Chain, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("BP Recompute Normals"), STAT_MeshProcessingBP_Normals, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("BP Preview Proxy"), STAT_MeshProcessingBP_PreviewProxy, STATGROUP_SampleModelingModeExtension);
+
 
 
 /**
  * FBackgroundMeshProcessingExecutor is a helper class that the UMeshProcessingBPTool and 
  * FBPMeshProcessingOp's can use to force the UMeshProcessingBPToolOperation blueprints subclasses
  * to execute on the Game Thread. Basically if the UMeshProcessingBPToolOperation::GetEnableBackgroundExecution()
- * function returns true (default false), then instead of directly calling UMeshProcessingBPToolOperation::OnRecomputeMesh,
+ * function returns false (the default), then instead of directly calling UMeshProcessingBPToolOperation::OnRecomputeMesh,
  * the Op will call QueueForMainThread() below, and then busy-wait. The Tool calls ExecuteOneOperationOnGameThread()
  * once per tick, allowing a BP execution on the game thread, which then cancels the busy-wait
  * in the background-thread FBPMeshProcessingOp, allowing it to complete (if not cancelled). 
@@ -83,6 +98,7 @@ public:
 		{
 			Operation.Target->ExecuteBlueprint(Operation.Progress);
 		}
+		PendingOperations.Reset();
 		PendingLock.Unlock();
 	}
 
@@ -150,6 +166,9 @@ public:
 		bool bDone = false;
 		while (!bDone)
 		{
+			// an operation chain may request more than one game-thread execution, so keep servicing them
+			ExecuteOneOperationOnGameThread();
+
 			bDone = true;
 			TempMeshesLock.Lock();
 			bDone = bDone && (TempMeshes.Num() == 0);
@@ -174,6 +193,12 @@ bool UMeshProcessingBPToolOperation::GetEnableBackgroundExecution_Implementation
 	return false;
 }
 
+// By default, a UMeshProcessingBPToolOperation BP-subclass is assumed to depend on the entire mesh
+bool UMeshProcessingBPToolOperation::GetIsLocalOperation_Implementation()
+{
+	return false;
+}
+
 
 
 UMeshProcessingBPTool::UMeshProcessingBPTool()
@@ -188,6 +213,7 @@ void UMeshProcessingBPTool::InitializeProperties()
 	Properties->RestoreProperties(this);
 
 	Executor = MakeShared<FBackgroundMeshProcessingExecutor>();
+	WorkerProcessAbortFlag = MakeShared<std::atomic<bool>, ESPMode::ThreadSafe>(false);
 }
 
 void UMeshProcessingBPTool::OnPropertyModified(UObject* PropertySet, FProperty* Property)
@@ -197,15 +223,22 @@ void UMeshProcessingBPTool::OnPropertyModified(UObject* PropertySet, FProperty*
 
 void UMeshProcessingBPTool::OnTick(float DeltaTime)
 {
-	UBaseMeshProcessingTool::OnTick(DeltaTime);
+	UBaseMultiMeshProcessingTool::OnTick(DeltaTime);
 
 	Executor->ExecuteOneOperationOnGameThread();
 }
 
+void UMeshProcessingBPTool::TickFinalCompute()
+{
+	// the Blueprint operations of the final computes are queued like those of the previews
+	Executor->ExecuteOneOperationOnGameThread();
+}
+
 void UMeshProcessingBPTool::OnShutdown(EToolShutdownType ShutdownType)
 {
 	Executor->ClearOnToolShutdown();
 	Executor->WaitForAllPendingToFinish();
+	WorkerProcessAbortFlag->store(true);
 
 	Properties->SaveProperties(this);
 }
@@ -228,20 +261,185 @@ bool UMeshProcessingBPTool::HasMeshTopologyChanged() const
 }
 
 
+namespace Local
+{
+	// smaller meshes are always previewed at full quality, the proxy would not make the chain significantly faster
+	static constexpr int32 PreviewProxyMinTriangles = 100000;
+	static constexpr int32 PreviewProxyTriangleDivisor = 4;
+}
+
+int32 UMeshProcessingBPTool::GetMaxPreviewQualityReduction() const
+{
+	for (int32 k = 0; k < GetNumTargets(); ++k)
+	{
+		if (IsPreviewProxyTarget(k))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+FText UMeshProcessingBPTool::GetPreviewQualityDescription(int32 QualityReduction) const
+{
+	return (QualityReduction > 0) ? LOCTEXT("ProxyPreviewQuality", "decimated proxy") : Super::GetPreviewQualityDescription(QualityReduction);
+}
+
+bool UMeshProcessingBPTool::IsPreviewProxyTarget(int32 TargetIndex) const
+{
+	return IsInputReady(TargetIndex) && GetSharedInitialMesh(TargetIndex)->TriangleCount() >= Local::PreviewProxyMinTriangles;
+}
+
+TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> UMeshProcessingBPTool::GetPreviewProxy(int32 TargetIndex)
+{
+	if (IsPreviewProxyTarget(TargetIndex) == false)
+	{
+		return nullptr;
+	}
+	PreviewProxies.SetNum(GetNumTargets());
+	FPreviewProxy& Proxy = PreviewProxies[TargetIndex];
+	if (Proxy.Mesh.IsValid())
+	{
+		return Proxy.Mesh;
+	}
+	if (Proxy.PendingMesh.IsValid() == false)
+	{
+		// the task only references the immutable input mesh, so it can outlive the Tool
+		TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> InputMesh = GetSharedInitialMesh(TargetIndex);
+		Proxy.PendingMesh = Async(EAsyncExecution::ThreadPool, [InputMesh]()
+		{
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingBP_PreviewProxy);
+			TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> ProxyMesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>(*InputMesh);
+			FQEMSimplification Simplifier(ProxyMesh.Get());
+			Simplifier.SimplifyToTriangleCount(InputMesh->TriangleCount() / Local::PreviewProxyTriangleDivisor);
+			ProxyMesh->CompactInPlace();
+			return TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe>(ProxyMesh);
+		});
+	}
+	if (Proxy.PendingMesh.IsReady())
+	{
+		Proxy.Mesh = Proxy.PendingMesh.Get();
+		Proxy.PendingMesh = TFuture<TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe>>();
+	}
+	return Proxy.Mesh;
+}
+
+
 
 namespace Local
 {
 
-class FBPMeshProcessingOp : public FDynamicMeshOperator, public FBackgroundMeshProcessingExecutor::IExecuteTarget
+/**
+ * FBlueprintMeshProcessingOperation wraps an instance of a UMeshProcessingBPToolOperation Blueprint
+ * as a step in a FMeshProcessingOperationChain. The Blueprint instance is kept alive by the
+ * FBackgroundMeshProcessingExecutor until this Operation is destroyed.
+ */
+class FBlueprintMeshProcessingOperation : public IMeshProcessingOperation
+{
+public:
+	FBlueprintMeshProcessingOperation(UMeshProcessingBPToolOperation* OperationIn, const FMeshProcessingBPToolParameters& SettingsIn, TSharedPtr<FBackgroundMeshProcessingExecutor> ExecutorIn)
+		: Operation(OperationIn), Settings(SettingsIn), Executor(ExecutorIn)
+	{
+		// query this here, on the game thread, as it is not safe to call arbitrary BP functions in the background
+		bBackgroundExecution = Operation->GetEnableBackgroundExecution();
+		bLocalOperation = Operation->GetIsLocalOperation();
+	}
+
+	virtual ~FBlueprintMeshProcessingOperation()
+	{
+		// Operations created outside of a Tool have no Executor, the creator keeps the Blueprint instance alive
+		if (Executor.IsValid())
+		{
+			Executor->ReleaseTempOperation(Operation);
+		}
+	}
+
+	virtual EMeshProcessingOperationThreading GetThreading() const override
+	{
+		return (bBackgroundExecution) ? EMeshProcessingOperationThreading::AnyThread : EMeshProcessingOperationThreading::GameThread;
+	}
+
+	virtual bool IsLocalOperation() const override { return bLocalOperation; }
+
+	// the graph state and variables of a Blueprint belong to its instance
+	virtual bool CanExecuteConcurrently() const override { return false; }
+
+	virtual bool RequiresDynamicMeshObject() const override { return true; }
+
+	// this may be called on Game Thread or in background compute thread, depending on Operation requirements
+	virtual void ApplyToDynamicMesh(UDynamicMesh* TargetMesh, FProgressCancel* Progress) override
+	{
+		// if the Operation cannot be executed in a background thread, make sure we are in the game thread...
+		if (bBackgroundExecution == false && ensure(IsInGameThread()) == false)
+		{
+			return;
+		}
+
+		if (Progress == nullptr || Progress->Cancelled() == false)
+		{
+			Operation->OnRecomputeMesh(TargetMesh, Settings);
+		}
+	}
+
+protected:
+	UMeshProcessingBPToolOperation* Operation;
+	FMeshProcessingBPToolParameters Settings;
+	TSharedPtr<FBackgroundMeshProcessingExecutor> Executor;
+	bool bBackgroundExecution = false;
+	bool bLocalOperation = false;
+};
+
+
+/**
+ * Native Operation for UMeshProcessingRecomputeNormalsChainStep
+ */
+class FRecomputeNormalsOperation : public IMeshProcessingOperation
+{
+public:
+	virtual EMeshProcessingOperationThreading GetThreading() const override { return EMeshProcessingOperationThreading::AnyThread; }
+
+	// normals only depend on the one-ring, so the owned vertices of a chunk need a halo of one ring
+	virtual bool IsLocalOperation() const override { return true; }
+	virtual int32 GetRequiredHaloRings() const override { return 1; }
+
+	virtual void Apply(FDynamicMesh3& Mesh, FProgressCancel* Progress) override
+	{
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingBP_Normals);
+		if (Mesh.HasAttributes())
+		{
+			FMeshNormals::QuickRecomputeOverlayNormals(Mesh);
+		}
+		else
+		{
+			FMeshNormals::QuickComputeVertexNormals(Mesh);
+		}
+	}
+};
+
+
+
+/**
+ * FBPMeshProcessingOp executes a FMeshProcessingOperationChain on a copy of the input mesh. The chain
+ * runs in the background compute thread, and any runs of Operations that must execute on the game thread
+ * are pushed to the FBackgroundMeshProcessingExecutor, while the background thread busy-waits for them.
+ * The Chain sees a FProgressCancel that also reports cancellation once this operator has been superseded,
+ * so that long Chains stop at the next Operation boundary.
+ */
+class FBPMeshProcessingOp : public FMeshProcessingOperator, public FBackgroundMeshProcessingExecutor::IExecuteTarget
 {
 public:
 	struct FOptions
 	{
-		// TStrongObjectPtr is ugly here but Operation and TempMesh need to be kept alive for lifetime of the Op
-		UMeshProcessingBPToolOperation* Operation;
-		FMeshProcessingBPToolParameters Settings;
+		FMeshProcessingOperationChain Chain;
 
-		UDynamicMesh* TempMesh;
+		// TempMesh is kept alive by the Executor for lifetime of the Op, and is only required if the Chain contains Blueprints
+		UDynamicMesh* TempMesh = nullptr;
+
+		// if set, the Chain is executed in spatial chunks, each chunk requires its own TempMesh and Blueprint instances if the Chain contains Blueprints
+		bool bChunkedExecution = false;
+		FMeshChunkedExecutionOptions ChunkOptions;
+		TArray<UDynamicMesh*> ChunkTempMeshes;
+		TArray<FMeshProcessingOperationChain> ChunkChains;
 
 		TSharedPtr<FBackgroundMeshProcessingExecutor> Executor;
 	};
@@ -250,42 +448,26 @@ public:
 	// this boolean to become true
 	std::atomic<bool> bBlueprintExecuted;
 
-	FBPMeshProcessingOp(const FDynamicMesh3* Mesh, FOptions Options)
+	FBPMeshProcessingOp(FOptions Options)
 	{
 		UseOptions = Options;
-		ResultMesh->Copy(*Mesh);		// copy input mesh into output mesh. Do not hold onto input Mesh reference as it is temporary!!
 
 		bBlueprintExecuted = false;
 	}
 
-	virtual ~FBPMeshProcessingOp() override {}
-
-	// set ability on protected transform.
-	void SetTransform(const FTransformSRT3d& XForm)
+	// an operator that is discarded before its compute runs still has to release its Operations and temp meshes
+	virtual ~FBPMeshProcessingOp() override
 	{
-		ResultTransform = XForm;
+		ReleaseOperations();
 	}
 
-	// this may be called on Game Thread or in background compute thread, depending on Operation requirements
+	// called on the Game Thread by the Executor, to run the pending game-thread part of the Chain
 	virtual void ExecuteBlueprint(FProgressCancel* Progress)
 	{
-		// if the Operation cannot be executed in a background thread, make sure we are in the game thread...
-		bool bSkipOperation = false;
-		if (UseOptions.Operation->GetEnableBackgroundExecution() == false)
-		{
-			if ( ! ensure(IsInGameThread()) )
-			{
-				bSkipOperation = true;
-			}
-		}
-		else
+		SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingBP_Execute);
+		if (ensure(PendingGameThreadWork != nullptr))
 		{
-			ensure(IsInGameThread() == false);		// just a sanity check to make sure we are actually in a background thread...
-		}
-
-		if (bSkipOperation == false && Progress->Cancelled() == false)
-		{
-			UseOptions.Operation->OnRecomputeMesh(UseOptions.TempMesh, UseOptions.Settings);
+			(*PendingGameThreadWork)();
 		}
 
 		bBlueprintExecuted = true;		// indicate that we have completed work, to end busy wait in CalculateResult()
@@ -299,40 +481,62 @@ public:
 		ResultInfo = FGeometryResult();
 
 		// abort if we don't have valid inputs
-		if (UseOptions.Operation == nullptr)
+		if (UseOptions.Chain.IsEmpty())
 		{
 			ResultInfo.SetSuccess(false , Progress);
-			UseOptions.Executor->ReleaseTempMesh(UseOptions.TempMesh);
+			ReleaseOperations();
 			return;
 		}
 
-		// can this ever happen?
-		check(UseOptions.TempMesh != nullptr);
-
-		UseOptions.TempMesh->SetMesh(MoveTemp(*ResultMesh));
-
-		if (UseOptions.Operation->GetEnableBackgroundExecution())
+		if (CopyInputMesh(Progress) == false)
 		{
-			ExecuteBlueprint(Progress);
+			ReleaseOperations();
+			return;
 		}
-		else
+
+		FProgressCancel ChainProgress;
+		ChainProgress.CancelF = [this, Progress]() { return (Progress != nullptr && Progress->Cancelled()) || IsSuperseded(); };
+
+		// if an Operation cannot be executed on background, push to game thread and then wait until it has been executed
+		auto RunOnGameThread = [this, &ChainProgress](TFunctionRef<void()> Work)
 		{
-			// if we cannot execute on background, push to game thread and then wait until it has been executed
-			UseOptions.Executor->QueueForMainThread( FBackgroundMeshProcessingExecutor::FPendingOperation{ this, Progress } );
+			// eg an operator that is computed directly on the game thread, queueing would wait for a Tick that never comes
+			if (IsInGameThread())
+			{
+				Work();
+				return;
+			}
+			PendingGameThreadWork = &Work;
+			bBlueprintExecuted = false;
+			UseOptions.Executor->QueueForMainThread( FBackgroundMeshProcessingExecutor::FPendingOperation{ this, &ChainProgress } );
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingBP_QueueWait);
 			while (bBlueprintExecuted == false)
 			{
 				FPlatformProcess::Sleep(0.01f);
 			}
-		}
+			PendingGameThreadWork = nullptr;
+		};
 
-		if (Progress->Cancelled() == false)
+		// The Chain is executed directly on the ResultMesh, the Blueprint steps move it in and out of TempMesh as necessary
 		{
-			TUniquePtr<UE::Geometry::FDynamicMesh3> EditedMesh = UseOptions.TempMesh->ExtractMesh();
-			*ResultMesh = MoveTemp(*EditedMesh);
+			SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshProcessingBP_Chain);
+			FScopedStage Stage(*this, TEXT("Chain"));
+			if (UseOptions.bChunkedExecution)
+			{
+				FMeshChunkedExecution::Execute(UseOptions.Chain, *ResultMesh, UseOptions.ChunkOptions, &ChainProgress, UseOptions.ChunkTempMeshes, UseOptions.ChunkChains);
+			}
+			else
+			{
+				UseOptions.Chain.Execute(*ResultMesh, &ChainProgress, UseOptions.TempMesh, RunOnGameThread);
+			}
 		}
 
-		UseOptions.Executor->ReleaseTempOperation(UseOptions.Operation);
-		UseOptions.Executor->ReleaseTempMesh(UseOptions.TempMesh);
+		ReleaseOperations();
+
+		if (CheckStageCancelled(Progress))
+		{
+			return;
+		}
 
 		ResultInfo.SetSuccess(true, Progress);
 	}
@@ -340,6 +544,30 @@ public:
 
 protected:
 	FOptions UseOptions;
+
+	const TFunctionRef<void()>* PendingGameThreadWork = nullptr;
+
+	// release the Operations (and hence any Blueprint instances) as soon as possible, as the Tool may be waiting for them to shut down
+	void ReleaseOperations()
+	{
+		UseOptions.Chain.Reset();
+		UseOptions.ChunkChains.Reset();
+		ReleaseTempMesh();
+	}
+
+	void ReleaseTempMesh()
+	{
+		if (UseOptions.TempMesh != nullptr)
+		{
+			UseOptions.Executor->ReleaseTempMesh(UseOptions.TempMesh);
+			UseOptions.TempMesh = nullptr;
+		}
+		for (UDynamicMesh* ChunkTempMesh : UseOptions.ChunkTempMeshes)
+		{
+			UseOptions.Executor->ReleaseTempMesh(ChunkTempMesh);
+		}
+		UseOptions.ChunkTempMeshes.Reset();
+	}
 };
 
 
@@ -347,26 +575,161 @@ protected:
 
 
 
-TUniquePtr<FDynamicMeshOperator> UMeshProcessingBPTool::MakeNewOperator()
+TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> UMeshProcessingRecomputeNormalsChainStep::MakeOperation(const FMeshProcessingBPToolParameters& Parameters) const
+{
+	return MakeShared<Local::FRecomputeNormalsOperation, ESPMode::ThreadSafe>();
+}
+
+
+
+TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> UMeshProcessingBPTool::MakeBlueprintOperation(TSubclassOf<UMeshProcessingBPToolOperation> OperationType)
+{
+	UClass* ClassType = OperationType;
+	UMeshProcessingBPToolOperation* OperationInstance = NewObject<UMeshProcessingBPToolOperation>((UObject*)GetTransientPackage(), ClassType);
+	this->Executor->AddTempOperation(OperationInstance);
+	return MakeShared<Local::FBlueprintMeshProcessingOperation, ESPMode::ThreadSafe>(OperationInstance, Properties->Parameters, this->Executor);
+}
+
+
+TUniquePtr<FMeshProcessingOperator> UMeshProcessingBPTool::MakeNativeChainOperator(const FMeshProcessingOperationChain& Chain, const FMeshChunkedExecutionOptions* ChunkOptions)
+{
+	// without an Executor, nothing can be run on the game thread or kept alive for the Chain
+	if (!ensure(Chain.IsThreadSafe() && Chain.RequiresDynamicMeshObject() == false))
+	{
+		return nullptr;
+	}
+
+	Local::FBPMeshProcessingOp::FOptions Options;
+	Options.Chain = Chain;
+	// the chunks share the Operation instances of the Chain, as there are no Blueprints to duplicate
+	if (ChunkOptions != nullptr && FMeshChunkedExecution::CanExecuteChunked(Chain) && Chain.CanExecuteConcurrently())
+	{
+		Options.bChunkedExecution = true;
+		Options.ChunkOptions = *ChunkOptions;
+	}
+	return MakeUnique<Local::FBPMeshProcessingOp>(Options);
+}
+
+
+void UMeshProcessingBPTool::BuildOperationChain(const UMeshProcessingBPToolProperties* Properties,
+	TFunctionRef<TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>(TSubclassOf<UMeshProcessingBPToolOperation>)> MakeBlueprintOperationFunc,
+	FMeshProcessingOperationChain& Chain)
 {
 	// spawn a new instance of the Operation BP type, if it is set
-	UMeshProcessingBPToolOperation* OperationInstance = nullptr;
 	if (Properties->Operation != nullptr)
 	{
-		UClass* ClassType = Properties->Operation;
-		OperationInstance = NewObject<UMeshProcessingBPToolOperation>((UObject*)GetTransientPackage(), ClassType);
-		this->Executor->AddTempOperation(OperationInstance);
+		Chain.AddOperation(MakeBlueprintOperationFunc(Properties->Operation));
+	}
+
+	// append the additional steps
+	for (const UMeshProcessingChainStep* Step : Properties->AdditionalSteps)
+	{
+		if (const UMeshProcessingBlueprintChainStep* BlueprintStep = Cast<UMeshProcessingBlueprintChainStep>(Step))
+		{
+			if (BlueprintStep->Operation != nullptr)
+			{
+				Chain.AddOperation(MakeBlueprintOperationFunc(BlueprintStep->Operation));
+			}
+		}
+		else if (Step != nullptr)
+		{
+			TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> StepOperation = Step->MakeOperation(Properties->Parameters);
+			if (StepOperation.IsValid())
+			{
+				Chain.AddOperation(StepOperation);
+			}
+		}
+	}
+}
+
+
+TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> UMeshProcessingBPTool::MakeBlueprintChainOperation(UMeshProcessingBPToolOperation* OperationInstance, const FMeshProcessingBPToolParameters& Parameters)
+{
+	return MakeShared<Local::FBlueprintMeshProcessingOperation, ESPMode::ThreadSafe>(OperationInstance, Parameters, TSharedPtr<FBackgroundMeshProcessingExecutor>());
+}
+
+
+TUniquePtr<FMeshProcessingOperator> UMeshProcessingBPTool::MakeNewOperator(int32 TargetIndex)
+{
+	// reduced-quality previews use the proxy once it is built, the input mesh until then
+	TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> InputMesh = (GetPreviewQualityReduction() > 0) ? GetPreviewProxy(TargetIndex) : nullptr;
+	if (InputMesh.IsValid() == false)
+	{
+		InputMesh = GetSharedInitialMesh(TargetIndex);
+	}
+
+	// the worker process creates its own Blueprint instances from the preset, none are needed here
+	if (Properties->bOutOfProcess)
+	{
+		FString PresetJson = FMeshProcessingPreset::MakePresetJsonString(FMeshProcessingPreset::EOperation::Blueprint, Properties);
+		TUniquePtr<FMeshProcessingWorkerOp> WorkerOp = MakeUnique<FMeshProcessingWorkerOp>(PresetJson, GetDefault<USampleModelingModeExtensionSettings>()->WorkerProcessTimeoutSeconds);
+		// the final computes on Accept run after shutdown has been flagged
+		if (IsFinalCompute() == false)
+		{
+			WorkerOp->AbortFlag = WorkerProcessAbortFlag;
+		}
+		WorkerOp->SetInputMesh(InputMesh);
+		WorkerOp->SetTransform( (FTransform3d)GetPreviewTransform(TargetIndex) );
+		return WorkerOp;
 	}
 
 	Local::FBPMeshProcessingOp::FOptions Options;
-	Options.Operation = OperationInstance;
-	Options.TempMesh = NewObject<UDynamicMesh>(this);		// TODO: this could come from a pool, to avoid UObject garbage spew
-	this->Executor->AddTempMesh(Options.TempMesh);
-	Options.Settings = Properties->Parameters;
 	Options.Executor = this->Executor;
 
-	TUniquePtr<Local::FBPMeshProcessingOp> MeshOp = MakeUnique<Local::FBPMeshProcessingOp>(&GetInitialMesh(), Options);
-	MeshOp->SetTransform( (FTransform3d)GetPreviewTransform() );
+	// spawn new instances of the Operation BP types, and append the additional steps
+	BuildOperationChain(Properties, [this](TSubclassOf<UMeshProcessingBPToolOperation> OperationType)
+	{
+		return MakeBlueprintOperation(OperationType);
+	}, Options.Chain);
+
+	// chunked execution is only possible if every step is a thread-safe local operation
+	if (Properties->bChunkedExecution)
+	{
+		Options.bChunkedExecution = FMeshChunkedExecution::CanExecuteChunked(Options.Chain);
+		if (Options.bChunkedExecution == false)
+		{
+			UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("MeshProcessingBPTool: Chunked Execution requires all steps to be local and thread-safe, executing on the whole mesh"));
+		}
+		Options.ChunkOptions.NumChunks = Properties->NumChunks;
+		Options.ChunkOptions.HaloRings = Properties->HaloWidth;
+		Options.ChunkOptions.bValidate = Properties->bValidateChunking;
+	}
+
+	// chunks are executed concurrently, so each chunk needs its own instances of the Operation BP types
+	if (Options.bChunkedExecution && Options.Chain.CanExecuteConcurrently() == false)
+	{
+		for (int32 k = 0; k < Options.ChunkOptions.NumChunks; ++k)
+		{
+			FMeshProcessingOperationChain& ChunkChain = Options.ChunkChains.AddDefaulted_GetRef();
+			BuildOperationChain(Properties, [this](TSubclassOf<UMeshProcessingBPToolOperation> OperationType)
+			{
+				return MakeBlueprintOperation(OperationType);
+			}, ChunkChain);
+		}
+	}
+
+	// native-only chains do not need a UDynamicMesh at all
+	if (Options.Chain.RequiresDynamicMeshObject())
+	{
+		if (Options.bChunkedExecution)
+		{
+			for (int32 k = 0; k < Options.ChunkOptions.NumChunks; ++k)
+			{
+				UDynamicMesh* ChunkTempMesh = NewObject<UDynamicMesh>(this);
+				this->Executor->AddTempMesh(ChunkTempMesh);
+				Options.ChunkTempMeshes.Add(ChunkTempMesh);
+			}
+		}
+		else
+		{
+			Options.TempMesh = NewObject<UDynamicMesh>(this);		// TODO: this could come from a pool, to avoid UObject garbage spew
+			this->Executor->AddTempMesh(Options.TempMesh);
+		}
+	}
+
+	TUniquePtr<Local::FBPMeshProcessingOp> MeshOp = MakeUnique<Local::FBPMeshProcessingOp>(Options);
+	MeshOp->SetInputMesh(InputMesh);
+	MeshOp->SetTransform( (FTransform3d)GetPreviewTransform(TargetIndex) );
 
 	return MeshOp;
 }
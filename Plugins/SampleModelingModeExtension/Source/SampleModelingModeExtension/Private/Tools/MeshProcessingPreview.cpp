@@ -0,0 +1,173 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Tools/MeshProcessingPreview.h"
+#include "PreviewMesh.h"
+#include "Operations/MeshProcessingComputePool.h"
+#include "Util/ProgressCancel.h"
+
+using namespace UE::Geometry;
+
+
+// state of a background compute, shared between the preview and the background task
+struct UMeshProcessingPreview::FActiveCompute
+{
+	TUniquePtr<FMeshProcessingOperator> Operator;
+	FProgressCancel Progress;
+	std::atomic<bool> bCancelled{ false };
+	std::atomic<bool> bFinished{ false };
+	double StartTime = 0;
+	uint64 EstimatedMemory = 0;
+	bool bShowWorkingMaterial = true;
+};
+
+
+void UMeshProcessingPreview::Setup(UWorld* World, const FTransform& Transform, const TArray<UMaterialInterface*>& Materials, UMaterialInterface* WorkingMaterialIn)
+{
+	PreviewMesh = NewObject<UPreviewMesh>(this);
+	PreviewMesh->CreateInWorld(World, Transform);
+	PreviewMesh->SetTangentsMode(EDynamicMeshComponentTangentsMode::AutoCalculated);
+	PreviewMesh->SetMaterials(Materials);
+
+	WorkingMaterial = WorkingMaterialIn;
+}
+
+
+TUniquePtr<FDynamicMesh3> UMeshProcessingPreview::Shutdown()
+{
+	CancelCompute();
+
+	if (PreviewMesh != nullptr)
+	{
+		PreviewMesh->SetVisible(false);
+		PreviewMesh->Disconnect();
+		PreviewMesh = nullptr;
+	}
+
+	if (bResultValid)
+	{
+		bResultValid = false;
+		return MoveTemp(ResultMesh);
+	}
+	return nullptr;
+}
+
+
+void UMeshProcessingPreview::SetInitialResult(const FDynamicMesh3& Mesh)
+{
+	PreviewMesh->UpdatePreview(&Mesh);
+}
+
+
+void UMeshProcessingPreview::SetVisibility(bool bVisible)
+{
+	PreviewMesh->SetVisible(bVisible);
+}
+
+
+void UMeshProcessingPreview::StartCompute(TUniquePtr<FMeshProcessingOperator> Operator, bool bShowWorkingMaterial)
+{
+	CancelCompute();
+
+	bResultValid = false;
+
+	TSharedPtr<FActiveCompute, ESPMode::ThreadSafe> Compute = MakeShared<FActiveCompute, ESPMode::ThreadSafe>();
+	Compute->Operator = MoveTemp(Operator);
+	Compute->Progress.CancelF = [ComputePtr = Compute.Get()]() { return ComputePtr->bCancelled.load(); };
+	Compute->StartTime = FPlatformTime::Seconds();
+	Compute->EstimatedMemory = Compute->Operator->EstimatePeakMemory();
+	Compute->bShowWorkingMaterial = bShowWorkingMaterial;
+	ActiveCompute = Compute;
+
+	// the task holds its own reference to the compute state, so that it can safely outlive this preview.
+	// A compute that is still queued when the next one is started is replaced and never runs.
+	FMeshProcessingComputePool::Get().Submit(this, [Compute]()
+	{
+		Compute->Operator->CalculateResult(&Compute->Progress);
+		Compute->bFinished = true;
+	});
+}
+
+
+uint64 UMeshProcessingPreview::GetActiveComputeEstimatedMemory() const
+{
+	return (ActiveCompute.IsValid()) ? ActiveCompute->EstimatedMemory : 0;
+}
+
+
+uint64 UMeshProcessingPreview::GetActiveComputeCurrentMemory() const
+{
+	return (ActiveCompute.IsValid()) ? ActiveCompute->Operator->GetTrackedCurrentMemory() : 0;
+}
+
+
+void UMeshProcessingPreview::CancelCompute()
+{
+	if (ActiveCompute.IsValid())
+	{
+		if (ActiveCompute->bFinished)
+		{
+			// finished but not yet picked up by Tick, the result is dropped here
+			OnOpDiscarded.Broadcast(ActiveCompute->Operator.Get());
+		}
+		ActiveCompute->bCancelled = true;
+		ActiveCompute.Reset();
+		FMeshProcessingComputePool::Get().CancelQueued(this);
+	}
+	SetShowingWorkingMaterial(false);
+}
+
+
+void UMeshProcessingPreview::Tick(float DeltaTime)
+{
+	if (ActiveCompute.IsValid() == false)
+	{
+		return;
+	}
+
+	if (ActiveCompute->bFinished == false)
+	{
+		if (ActiveCompute->bShowWorkingMaterial && FPlatformTime::Seconds() - ActiveCompute->StartTime > WorkingMaterialDelay)
+		{
+			SetShowingWorkingMaterial(true);
+		}
+		return;
+	}
+
+	TSharedPtr<FActiveCompute, ESPMode::ThreadSafe> Compute = ActiveCompute;
+	ActiveCompute.Reset();
+	SetShowingWorkingMaterial(false);
+
+	FMeshProcessingOperator* Operator = Compute->Operator.Get();
+	if (Operator->IsSuperseded() || Operator->GetResultInfo().Result != EGeometryResultType::Success)
+	{
+		// late, cancelled or failed result, the preview keeps showing the last valid result
+		OnOpDiscarded.Broadcast(Operator);
+		return;
+	}
+
+	ResultMesh = Operator->ExtractResult();
+	PreviewMesh->SetTransform((FTransform)Operator->GetResultTransform());
+	PreviewMesh->UpdatePreview(ResultMesh.Get());
+	bResultValid = true;
+	LastComputeSeconds = FPlatformTime::Seconds() - Compute->StartTime;
+
+	OnOpCompleted.Broadcast(Operator);
+}
+
+
+void UMeshProcessingPreview::SetShowingWorkingMaterial(bool bShow)
+{
+	if (bShow != bShowingWorkingMaterial && PreviewMesh != nullptr)
+	{
+		if (bShow)
+		{
+			PreviewMesh->SetOverrideRenderMaterial(WorkingMaterial);
+		}
+		else
+		{
+			PreviewMesh->ClearOverrideRenderMaterial();
+		}
+		bShowingWorkingMaterial = bShow;
+	}
+}
@@ -0,0 +1,245 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Tools/MeshVertexDeltaChange.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "InteractiveToolManager.h"
+#include "Engine/StaticMesh.h"
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "DynamicMeshToMeshDescription.h"
+#include "Misc/Compression.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Vertex Delta Encode"), STAT_MeshVertexDeltaChange_Encode, STATGROUP_SampleModelingModeExtension);
+DECLARE_CYCLE_STAT(TEXT("Vertex Delta Apply"), STAT_MeshVertexDeltaChange_Apply, STATGROUP_SampleModelingModeExtension);
+
+
+namespace Local
+{
+
+static uint32 FloatBits(float Value)
+{
+	uint32 Bits;
+	FMemory::Memcpy(&Bits, &Value, sizeof(uint32));
+	return Bits;
+}
+
+static float BitsFloat(uint32 Bits)
+{
+	float Value;
+	FMemory::Memcpy(&Value, &Bits, sizeof(uint32));
+	return Value;
+}
+
+}
+
+
+void FMeshVertexDeltaChange::GatherValues(const FMeshDescription& Mesh, TArray<uint32>& ValuesOut)
+{
+	FStaticMeshConstAttributes Attributes(Mesh);
+	TVertexAttributesConstRef<FVector3f> Positions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesConstRef<FVector3f> Normals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesConstRef<FVector3f> Tangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesConstRef<float> BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+
+	ValuesOut.Reserve(ValuesOut.Num() + Mesh.Vertices().Num() * 3 + Mesh.VertexInstances().Num() * 7);
+	for (FVertexID VertexID : Mesh.Vertices().GetElementIDs())
+	{
+		const FVector3f& Position = Positions[VertexID];
+		ValuesOut.Add(Local::FloatBits(Position.X));
+		ValuesOut.Add(Local::FloatBits(Position.Y));
+		ValuesOut.Add(Local::FloatBits(Position.Z));
+	}
+	for (FVertexInstanceID InstanceID : Mesh.VertexInstances().GetElementIDs())
+	{
+		const FVector3f& Normal = Normals[InstanceID];
+		const FVector3f& Tangent = Tangents[InstanceID];
+		ValuesOut.Add(Local::FloatBits(Normal.X));
+		ValuesOut.Add(Local::FloatBits(Normal.Y));
+		ValuesOut.Add(Local::FloatBits(Normal.Z));
+		ValuesOut.Add(Local::FloatBits(Tangent.X));
+		ValuesOut.Add(Local::FloatBits(Tangent.Y));
+		ValuesOut.Add(Local::FloatBits(Tangent.Z));
+		ValuesOut.Add(Local::FloatBits(BinormalSigns[InstanceID]));
+	}
+}
+
+
+void FMeshVertexDeltaChange::ScatterValues(const TArray<uint32>& Values, FMeshDescription& Mesh)
+{
+	FStaticMeshAttributes Attributes(Mesh);
+	TVertexAttributesRef<FVector3f> Positions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector3f> Normals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector3f> Tangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+
+	int32 Index = 0;
+	for (FVertexID VertexID : Mesh.Vertices().GetElementIDs())
+	{
+		Positions[VertexID] = FVector3f(Local::BitsFloat(Values[Index]), Local::BitsFloat(Values[Index + 1]), Local::BitsFloat(Values[Index + 2]));
+		Index += 3;
+	}
+	for (FVertexInstanceID InstanceID : Mesh.VertexInstances().GetElementIDs())
+	{
+		Normals[InstanceID] = FVector3f(Local::BitsFloat(Values[Index]), Local::BitsFloat(Values[Index + 1]), Local::BitsFloat(Values[Index + 2]));
+		Tangents[InstanceID] = FVector3f(Local::BitsFloat(Values[Index + 3]), Local::BitsFloat(Values[Index + 4]), Local::BitsFloat(Values[Index + 5]));
+		BinormalSigns[InstanceID] = Local::BitsFloat(Values[Index + 6]);
+		Index += 7;
+	}
+}
+
+
+bool FMeshVertexDeltaChange::Initialize(const TArray<uint32>& Before, const TArray<uint32>& After)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshVertexDeltaChange_Encode);
+
+	if (Before.Num() != After.Num() || Before.Num() == 0)
+	{
+		return false;
+	}
+	NumValues = Before.Num();
+
+	// byte plane k holds byte k of all the XOR values, so that the mostly-zero high bytes are contiguous
+	TArray<uint8> Planes;
+	Planes.SetNumUninitialized(NumValues * sizeof(uint32));
+	for (int32 Index = 0; Index < NumValues; ++Index)
+	{
+		uint32 Delta = Before[Index] ^ After[Index];
+		for (int32 Plane = 0; Plane < (int32)sizeof(uint32); ++Plane)
+		{
+			Planes[Plane * NumValues + Index] = (uint8)(Delta >> (8 * Plane));
+		}
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Planes.Num());
+	CompressedDelta.SetNumUninitialized(CompressedSize);
+	if (FCompression::CompressMemory(NAME_Zlib, CompressedDelta.GetData(), CompressedSize, Planes.GetData(), Planes.Num()) == false)
+	{
+		CompressedDelta = MoveTemp(Planes);
+	}
+	else
+	{
+		CompressedDelta.SetNum(CompressedSize);
+		CompressedDelta.Shrink();
+	}
+	return true;
+}
+
+
+void FMeshVertexDeltaChange::ApplyDelta(UObject* Object) const
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_MeshVertexDeltaChange_Apply);
+
+	UStaticMesh* StaticMesh = Cast<UStaticMesh>(Object);
+	FMeshDescription* MeshDescription = (StaticMesh != nullptr) ? StaticMesh->GetMeshDescription(0) : nullptr;
+	if (MeshDescription == nullptr)
+	{
+		return;
+	}
+
+	TArray<uint32> Values;
+	GatherValues(*MeshDescription, Values);
+	if (Values.Num() != NumValues)
+	{
+		// the transaction history guarantees the matching state, this only happens if the asset was modified outside of it
+		UE_LOG(LogSampleModelingModeExtension, Warning, TEXT("Vertex delta change does not match the current mesh of %s, skipped"), *StaticMesh->GetName());
+		return;
+	}
+
+	TArray<uint8> Planes;
+	if (CompressedDelta.Num() == NumValues * (int32)sizeof(uint32))
+	{
+		// stored uncompressed
+		Planes = CompressedDelta;
+	}
+	else
+	{
+		Planes.SetNumUninitialized(NumValues * sizeof(uint32));
+		if (FCompression::UncompressMemory(NAME_Zlib, Planes.GetData(), Planes.Num(), CompressedDelta.GetData(), CompressedDelta.Num()) == false)
+		{
+			UE_LOG(LogSampleModelingModeExtension, Error, TEXT("Vertex delta change of %s could not be decompressed"), *StaticMesh->GetName());
+			return;
+		}
+	}
+
+	for (int32 Index = 0; Index < NumValues; ++Index)
+	{
+		uint32 Delta = 0;
+		for (int32 Plane = 0; Plane < (int32)sizeof(uint32); ++Plane)
+		{
+			Delta |= (uint32)Planes[Plane * NumValues + Index] << (8 * Plane);
+		}
+		Values[Index] ^= Delta;
+	}
+
+	ScatterValues(Values, *MeshDescription);
+	StaticMesh->CommitMeshDescription(0);
+	StaticMesh->PostEditChange();
+}
+
+
+void FMeshVertexDeltaChange::Apply(UObject* Object)
+{
+	ApplyDelta(Object);
+}
+
+void FMeshVertexDeltaChange::Revert(UObject* Object)
+{
+	ApplyDelta(Object);
+}
+
+FString FMeshVertexDeltaChange::ToString() const
+{
+	return FString::Printf(TEXT("FMeshVertexDeltaChange (%d values, %llu bytes)"), NumValues, GetCompressedSize());
+}
+
+
+bool FMeshVertexDeltaChange::CommitVertexUpdate(UStaticMesh* StaticMesh, const FDynamicMesh3& Mesh,
+	UInteractiveToolManager* ToolManager, const FText& Description)
+{
+	FMeshDescription* MeshDescription = (StaticMesh != nullptr) ? StaticMesh->GetMeshDescription(0) : nullptr;
+	if (MeshDescription == nullptr)
+	{
+		return false;
+	}
+
+	// the vertex IDs of a mesh converted from a compact MeshDescription are the MeshDescription vertex IDs
+	if (Mesh.VertexCount() != MeshDescription->Vertices().Num() || Mesh.MaxVertexID() != MeshDescription->Vertices().GetArraySize()
+		|| Mesh.TriangleCount() != MeshDescription->Triangles().Num())
+	{
+		return false;
+	}
+
+	TArray<uint32> Before;
+	GatherValues(*MeshDescription, Before);
+
+	FConversionToMeshDescriptionOptions ConversionOptions;
+	ConversionOptions.bSetPolyGroups = false;
+	ConversionOptions.bUpdatePositions = true;
+	ConversionOptions.bUpdateNormals = true;
+	ConversionOptions.bUpdateUVs = false;
+	ConversionOptions.bUpdateVtxColors = false;
+	FDynamicMeshToMeshDescription Converter(ConversionOptions);
+	Converter.UpdateUsingConversionOptions(&Mesh, *MeshDescription);
+
+	TArray<uint32> After;
+	GatherValues(*MeshDescription, After);
+
+	TUniquePtr<FMeshVertexDeltaChange> Change = MakeUnique<FMeshVertexDeltaChange>();
+	if (Change->Initialize(Before, After) == false)
+	{
+		ScatterValues(Before, *MeshDescription);
+		return false;
+	}
+	UE_LOG(LogSampleModelingModeExtension, Verbose, TEXT("Vertex delta change of %s: %llu bytes (%llu uncompressed)"),
+		*StaticMesh->GetName(), Change->GetCompressedSize(), Change->GetUncompressedSize());
+
+	// the Static Mesh is not Modify()'d, the change replaces the transaction record of its MeshDescription
+	StaticMesh->CommitMeshDescription(0);
+	StaticMesh->PostEditChange();
+	StaticMesh->MarkPackageDirty();
+	ToolManager->EmitObjectChange(StaticMesh, MoveTemp(Change), Description);
+	return true;
+}
@@ -0,0 +1,207 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#include "Tools/ToolInputMeshCache.h"
+#include "SampleModelingModeExtensionModule.h"
+#include "SampleModelingModeExtensionSettings.h"
+#include "Operations/MeshProcessingOperator.h"
+#include "ModelingToolTargetUtil.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "MeshDescription.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+
+using namespace UE::Geometry;
+
+DECLARE_CYCLE_STAT(TEXT("Input Mesh Conversion"), STAT_ToolInputMeshCache_Convert, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input Mesh Cache Hits"), STAT_ToolInputMeshCache_Hits, STATGROUP_SampleModelingModeExtension);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input Mesh Cache Misses"), STAT_ToolInputMeshCache_Misses, STATGROUP_SampleModelingModeExtension);
+
+
+FToolInputMeshCache& FToolInputMeshCache::Get()
+{
+	static FToolInputMeshCache Cache;
+	return Cache;
+}
+
+
+bool FToolInputMeshCache::GetTargetKey(UToolTarget* Target, FKey& KeyOut)
+{
+#if WITH_EDITORONLY_DATA
+	const UStaticMeshComponent* Component = Cast<UStaticMeshComponent>(UE::ToolTarget::GetTargetComponent(Target));
+	UStaticMesh* StaticMesh = (Component != nullptr) ? Component->GetStaticMesh() : nullptr;
+	if (StaticMesh == nullptr || StaticMesh->GetNumSourceModels() == 0)
+	{
+		return false;
+	}
+
+	// only the LOD0 source mesh is versioned by the key
+	if (UE::ToolTarget::GetMeshDescription(Target) != StaticMesh->GetMeshDescription(0))
+	{
+		return false;
+	}
+	const FStaticMeshSourceModel& SourceModel = StaticMesh->GetSourceModel(0);
+	if (SourceModel.MeshDescriptionBulkData.IsValid() == false || SourceModel.MeshDescriptionBulkData->IsEmpty())
+	{
+		return false;
+	}
+
+	KeyOut.Source = StaticMesh;
+	KeyOut.Version = SourceModel.MeshDescriptionBulkData->GetIdString();
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+uint64 FToolInputMeshCache::GetEntryMemory(const FInput& Input)
+{
+	uint64 Memory = FMeshProcessingOperator::EstimateMeshMemory(*Input.Mesh);
+	if (Input.VertexNormals.IsValid())
+	{
+		Memory += (uint64)Input.VertexNormals->GetNormals().GetAllocatedSize();
+	}
+	return Memory;
+}
+
+
+TFuture<FToolInputMeshCache::FInput> FToolInputMeshCache::GetInputAsync(UToolTarget* Target, bool bRequireNormals)
+{
+	check(IsInGameThread());
+
+	FKey Key;
+	bool bCacheable = GetDefault<USampleModelingModeExtensionSettings>()->InputMeshCacheLimitMB > 0 && GetTargetKey(Target, Key);
+
+	FInput Cached;
+	if (bCacheable)
+	{
+		FScopeLock ScopeLock(&Lock);
+		FEntry* Entry = Entries.FindByPredicate([&Key](const FEntry& Existing) { return Existing.Key.Source == Key.Source && Existing.Key.Version == Key.Version; });
+		if (Entry != nullptr)
+		{
+			Entry->LastUsed = ++UseCounter;
+			Cached = Entry->Input;
+			if (bRequireNormals == false || Cached.VertexNormals.IsValid())
+			{
+				NumHits++;
+				INC_DWORD_STAT(STAT_ToolInputMeshCache_Hits);
+				TPromise<FInput> Promise;
+				Promise.SetValue(Cached);
+				return Promise.GetFuture();
+			}
+		}
+		NumMisses++;
+		INC_DWORD_STAT(STAT_ToolInputMeshCache_Misses);
+	}
+
+	// the MeshDescription must be fetched on the game thread, as it may be loaded from bulk data.
+	// A cached mesh without normals is reused, and only the normals are computed.
+	const FMeshDescription* MeshDescription = (Cached.Mesh.IsValid()) ? nullptr : UE::ToolTarget::GetMeshDescription(Target);
+	return Async(EAsyncExecution::ThreadPool, [this, Key, bCacheable, Cached, MeshDescription, bRequireNormals]()
+	{
+		FInput Input = ConvertInput(Cached, MeshDescription, bRequireNormals);
+		if (bCacheable)
+		{
+			// the weak Source pointer of the key is only resolved on the game thread
+			AsyncTask(ENamedThreads::GameThread, [this, Key, Input]()
+			{
+				AddEntry(Key, Input);
+			});
+		}
+		return Input;
+	});
+}
+
+
+FToolInputMeshCache::FInput FToolInputMeshCache::ConvertInput(FInput Cached, const FMeshDescription* MeshDescription, bool bRequireNormals)
+{
+	SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(STAT_ToolInputMeshCache_Convert);
+
+	FInput Input = Cached;
+	if (Input.Mesh.IsValid() == false)
+	{
+		TSharedPtr<FDynamicMesh3, ESPMode::ThreadSafe> Mesh = MakeShared<FDynamicMesh3, ESPMode::ThreadSafe>();
+		if (MeshDescription != nullptr)
+		{
+			FMeshDescriptionToDynamicMesh Converter;
+			Converter.Convert(MeshDescription, *Mesh);
+		}
+		Input.Mesh = Mesh;
+	}
+	if (bRequireNormals && Input.VertexNormals.IsValid() == false)
+	{
+		TSharedPtr<FMeshNormals, ESPMode::ThreadSafe> VertexNormals = MakeShared<FMeshNormals, ESPMode::ThreadSafe>(Input.Mesh.Get());
+		VertexNormals->ComputeVertexNormals();
+		Input.VertexNormals = VertexNormals;
+	}
+	return Input;
+}
+
+
+void FToolInputMeshCache::AddEntry(const FKey& Key, const FInput& Input)
+{
+	FScopeLock ScopeLock(&Lock);
+	FEntry* Entry = Entries.FindByPredicate([&Key](const FEntry& Existing) { return Existing.Key.Source == Key.Source && Existing.Key.Version == Key.Version; });
+	if (Entry == nullptr)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Key = Key;
+	}
+	Entry->Input = Input;
+	Entry->Memory = GetEntryMemory(Input);
+	Entry->LastUsed = ++UseCounter;
+	Trim(&Key);
+}
+
+
+void FToolInputMeshCache::Trim(const FKey* AddedKey)
+{
+	// an asset only has a single current version, and destroyed assets can never be hit again
+	Entries.RemoveAll([AddedKey](const FEntry& Entry)
+	{
+		return Entry.Key.Source.IsValid() == false
+			|| (AddedKey != nullptr && Entry.Key.Source == AddedKey->Source && Entry.Key.Version != AddedKey->Version);
+	});
+
+	uint64 MemoryLimit = (uint64)FMath::Max(0, GetDefault<USampleModelingModeExtensionSettings>()->InputMeshCacheLimitMB) * 1024 * 1024;
+	uint64 TotalMemory = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		TotalMemory += Entry.Memory;
+	}
+	while (TotalMemory > MemoryLimit && Entries.Num() > 0)
+	{
+		int32 OldestIndex = 0;
+		for (int32 k = 1; k < Entries.Num(); ++k)
+		{
+			if (Entries[k].LastUsed < Entries[OldestIndex].LastUsed)
+			{
+				OldestIndex = k;
+			}
+		}
+		TotalMemory -= Entries[OldestIndex].Memory;
+		Entries.RemoveAtSwap(OldestIndex);
+	}
+}
+
+
+void FToolInputMeshCache::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Reset();
+}
+
+
+uint64 FToolInputMeshCache::GetCachedMemory() const
+{
+	FScopeLock ScopeLock(&Lock);
+	uint64 TotalMemory = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		TotalMemory += Entry.Memory;
+	}
+	return TotalMemory;
+}
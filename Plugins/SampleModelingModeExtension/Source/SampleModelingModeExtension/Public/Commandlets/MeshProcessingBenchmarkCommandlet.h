@@ -0,0 +1,30 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MeshProcessingBenchmarkCommandlet.generated.h"
+
+
+/**
+ * UMeshProcessingBenchmarkCommandlet runs the operators of the plugin Tools directly (ie without a Tool or
+ * background compute) on the SM_Bunny and SM_Sphere assets and on generated spheres of increasing size,
+ * and reports wall time, throughput and memory of each operator stage. The results are logged and written
+ * to a JSON file that can be compared between runs to detect regressions. The click hit test of UActorClickedBPTool is
+ * also timed in a temporary world of FindHitActors cubes, against a target of 1 ms per click at 100k Actors.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd <Project> -run=MeshProcessingBenchmark -nullrhi [-Sizes=10000,100000,...] [-Iterations=3]
+ *       [-MaxTessellatedTriangles=4000000] [-FindHitActors=100000] [-Output=<path.json>]
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UMeshProcessingBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,41 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MeshProcessingBulkCommandlet.generated.h"
+
+
+/**
+ * UMeshProcessingBulkCommandlet applies the Noise, Plane Cut or Blueprint processing operation of the plugin Tools
+ * to all the UStaticMesh assets under a content path, and saves the modified assets. The operators are the same
+ * ones the Tools use, configured from a parameter preset.
+ *
+ * Assets are processed as a pipeline: loading and saving run on the game thread, while mesh conversion and the
+ * operators of up to -MaxInFlight assets run concurrently on the task thread pool. Blueprint Operations that do not
+ * enable background execution are executed on the game thread, between the conversion stages.
+ *
+ * A preset is a JSON file with the Operation name and the Tool settings of that Operation, eg
+ *   { "Operation": "Noise", "Properties": { "Subdivisions": 1, "NoiseType": "Perlin", "Scale": 2.0 } }
+ *   { "Operation": "PlaneCut", "PlaneAtBoundsCenter": true, "Properties": { "Rotation": { "Pitch": 90, "Yaw": 0, "Roll": 0 } } }
+ *   { "Operation": "BP", "Properties": { "Operation": "/Game/BP_MyOperation.BP_MyOperation_C" }, "Steps": [ "MeshProcessingRecomputeNormalsChainStep" ] }
+ * -Preset is either a path to a preset file, or the name of a file in <Project>/Config/MeshProcessingPresets (see FMeshProcessingPreset).
+ *
+ * With -OutOfProcess, the operations are executed by the worker processes of FMeshProcessingWorkerPool, so that an
+ * asset whose operation crashes or exceeds -WorkerTimeout only fails that asset rather than the whole run.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd <Project> -run=MeshProcessingBulk -nullrhi -Path=/Game/Meshes (-Preset=<name or path> | -Operation=Noise|PlaneCut|BP)
+ *       [-MaxInFlight=<N>] [-OutOfProcess [-WorkerTimeout=<seconds>]] [-Build] [-NoSave]
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBulkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UMeshProcessingBulkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
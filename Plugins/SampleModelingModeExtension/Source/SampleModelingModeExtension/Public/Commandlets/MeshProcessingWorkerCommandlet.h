@@ -0,0 +1,27 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MeshProcessingWorkerCommandlet.generated.h"
+
+
+/**
+ * UMeshProcessingWorkerCommandlet is the worker process of FMeshProcessingWorkerPool. It executes the mesh
+ * processing requests of the host process until the host shuts it down or exits. It is started by the pool,
+ * and is not intended to be run manually.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd <Project> -run=MeshProcessingWorker -nullrhi -Control=<control region name> [-HostPID=<process ID>]
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingWorkerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UMeshProcessingWorkerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
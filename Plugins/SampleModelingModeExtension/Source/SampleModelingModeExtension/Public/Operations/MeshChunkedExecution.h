@@ -0,0 +1,89 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Operations/MeshProcessingOperationChain.h"
+
+class FProgressCancel;
+class UDynamicMesh;
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * Settings for FMeshChunkedExecution
+ */
+struct SAMPLEMODELINGMODEEXTENSION_API FMeshChunkedExecutionOptions
+{
+	/** Number of spatial chunks the mesh is split into */
+	int32 NumChunks = 8;
+
+	/** Number of one-ring triangle layers added around each chunk, so that local Operations see the neighbourhood of the chunk border. Raised to the halo the chain requires. */
+	int32 HaloRings = 2;
+
+	/** Tolerance used to weld the chunk seams back together if the Operations changed the mesh topology */
+	double WeldTolerance = FMathd::ZeroTolerance;
+
+	/** If true, the chain is also executed on the whole mesh and the chunked result is compared against it */
+	bool bValidate = false;
+};
+
+
+/**
+ * Information about a FMeshChunkedExecution::Execute() call
+ */
+struct SAMPLEMODELINGMODEEXTENSION_API FMeshChunkedExecutionInfo
+{
+	int32 NumChunks = 0;
+	bool bTopologyPreserved = true;
+
+	bool bValidated = false;
+	bool bValidationTopologyMatched = false;
+	double ValidationMaxDeviation = 0;
+};
+
+
+/**
+ * FMeshChunkedExecution executes a FMeshProcessingOperationChain of local Operations (see IMeshProcessingOperation::IsLocalOperation())
+ * in parallel on spatial chunks of a mesh. The mesh is partitioned into NumChunks cells by recursive median splits of the triangle
+ * centroids, and each chunk is extracted into its own mesh along with a halo of HaloRings triangle rings (at least the halo that
+ * the Operations require, see IMeshProcessingOperation::GetRequiredHaloRings()). After the chunks have been processed
+ * concurrently, the results are stitched back together:
+ *   - if the Operations did not change the chunk topology, the vertex positions and overlay values of each chunk's owned
+ *     (non-halo) region are written back into the original mesh
+ *   - otherwise, the output triangles of each chunk that derive from its owned input triangles are appended into a new mesh and
+ *     the seams are welded. The input triangle IDs are carried through the Operations in a polygroup layer. If a chunk mesh
+ *     has no attributes, or an Operation dropped the layer, the chain is executed on the whole mesh instead.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshChunkedExecution
+{
+public:
+	/** @return true if the Chain can be executed in chunks, ie it is thread-safe and only contains local Operations */
+	static bool CanExecuteChunked(const FMeshProcessingOperationChain& Chain);
+
+	/**
+	 * Execute the Chain on Mesh in chunks, in-place.
+	 * @param ChunkTempMeshes UDynamicMesh for each chunk, required if the Chain contains Operations that need one. These must be created (and kept alive) by the caller.
+	 * @param ChunkChains copy of the Chain with its own Operation instances for each chunk, required if Chain.CanExecuteConcurrently() is false.
+	 *        Chain itself is then only used for validation.
+	 * @param InfoOut optional information about the execution, including validation results
+	 * @return false if execution was cancelled
+	 */
+	static bool Execute(
+		const FMeshProcessingOperationChain& Chain,
+		FDynamicMesh3& Mesh,
+		const FMeshChunkedExecutionOptions& Options,
+		FProgressCancel* Progress,
+		TArrayView<UDynamicMesh*> ChunkTempMeshes,
+		TArrayView<const FMeshProcessingOperationChain> ChunkChains,
+		FMeshChunkedExecutionInfo* InfoOut = nullptr);
+};
+
+
+}
+}
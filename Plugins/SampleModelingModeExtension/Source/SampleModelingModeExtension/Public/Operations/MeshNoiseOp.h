@@ -0,0 +1,225 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Operations/MeshProcessingOperator.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Operations/ScratchFile.h"
+
+enum class EMeshNoiseToolNoiseType : uint8;
+enum class EMeshNoiseToolMaskType : uint8;
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FMeshNoiseOp computes the mesh deformation of the UMeshNoiseTool: optional PN tessellation, followed by
+ * Random or Perlin displacement along the vertex normals. The operator is created on the game thread,
+ * however the CalculateResult function is run from a background compute thread.
+ *
+ * The displacement can be limited to a masked region of the mesh (see FMaskOptions), in which case only the
+ * vertices of the region and its blend rings are displaced, and only the normals around them are recomputed.
+ * The tessellation is still computed for the whole mesh, as a partial PN tessellation would crack at the region border.
+ *
+ * Perlin noise is evaluated with FPerlinNoise, whose analytic gradient gives the displaced normals directly (see FOptions::bAnalyticNormals).
+ *
+ * For meshes whose per-vertex working arrays exceed FOptions::BatchMemoryBudget, the vertices are displaced in chunks, and the
+ * analytic normals can be kept in a memory-mapped FScratchFile (see FOptions::ScratchFileDirectory), so that only the chunk
+ * being displaced is resident. The result is the same as with everything in memory.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshNoiseOp : public FMeshProcessingOperator
+{
+public:
+	struct FMaskOptions
+	{
+		// EMeshNoiseToolMaskType::None, ie the whole mesh is displaced
+		EMeshNoiseToolMaskType Type = EMeshNoiseToolMaskType(0);
+
+		/** Mask box, in the space of the operator result transform (ie world space in the Tool) */
+		FTransformSRT3d VolumeTransform;
+		FVector3d VolumeExtents = FVector3d::Zero();
+		/** Distance outside the box over which the weight fades to zero */
+		double VolumeFalloff = 0;
+
+		int32 PolyGroupID = 0;
+		int32 WeightLayer = 0;
+
+		/** Number of vertex rings around the masked vertices over which the weight fades to zero */
+		int32 BlendRings = 0;
+	};
+
+	struct FOptions
+	{
+		int32 Subdivisions = 0;
+
+		EMeshNoiseToolNoiseType NoiseType;
+		double Magnitude = 1.0;
+		int32 RandomSeed = 0;
+		double Frequency = 1.0;
+
+		/** Displace the vertices as a parallel batch kernel over contiguous arrays (see TVertexBatch), instead of one indexed vertex at a time */
+		bool bBatchedDisplacement = true;
+
+		/**
+		 * Compute the batched displacement in single precision, relative to the bounds center of the mesh. This is intended
+		 * for interactive previews, the result deviates slightly from the double-precision result.
+		 */
+		bool bSinglePrecision = false;
+
+		/**
+		 * Maximum memory of the batched displacement arrays in bytes, 0 for no limit. Larger meshes are displaced in chunks of vertices
+		 * that fit into the budget, with the same result as a single batch.
+		 */
+		uint64 BatchMemoryBudget = 0;
+
+		/**
+		 * If set, and the batched displacement arrays and the analytic normals of all vertices would exceed BatchMemoryBudget, the
+		 * analytic normals are written to a memory-mapped scratch file in this directory, and only the window of the current
+		 * chunk is mapped. Empty keeps the normals in memory.
+		 */
+		FString ScratchFileDirectory;
+
+		/** Keep a shared copy of the tessellated mesh and its vertex normals in Tessellation, so that later operators with the same Subdivisions can reuse it */
+		bool bKeepTessellation = false;
+
+		/**
+		 * For Perlin noise, compute the displaced vertex normals from the noise gradient and the base normals in the displacement
+		 * kernel, instead of recomputing them from the displaced mesh. The normals are recomputed instead for Random noise, for
+		 * masked displacement, and for meshes with split normals (ie more than one normal element at a vertex).
+		 */
+		bool bAnalyticNormals = true;
+
+		/**
+		 * Load the tessellation from the FTessellationDiskCache if it has an entry for the input mesh, and write the tessellation
+		 * to it otherwise. Only used for meshes that are large enough that loading is faster than tessellating.
+		 */
+		bool bTessellationDiskCache = false;
+
+		FMaskOptions Mask;
+	};
+
+	/** Vertex normals of the input mesh, used for displacement if there are no subdivisions */
+	TSharedPtr<const FMeshNormals, ESPMode::ThreadSafe> BaseMeshNormals;
+
+	/** PN tessellation of the input mesh at a subdivision level, before displacement */
+	struct FTessellation
+	{
+		int32 Subdivisions = 0;
+		TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> Mesh;
+		TSharedPtr<const TArray<FVector3d>, ESPMode::ThreadSafe> VertexNormals;
+	};
+
+	/**
+	 * If set to a tessellation of the input mesh with the same Subdivisions, it is copied instead of tessellating the input mesh.
+	 * If FOptions::bKeepTessellation is enabled, CalculateResult() sets this to the tessellation it computed.
+	 */
+	FTessellation Tessellation;
+
+	/**
+	 * Content hash of the input mesh for the FTessellationDiskCache, see FTessellationDiskCache::HashMesh(). If 0, CalculateResult()
+	 * computes it when the disk cache is used, so the caller can keep it for later operators on the same input mesh.
+	 */
+	uint64 InputMeshHash = 0;
+
+	FMeshNoiseOp(FOptions Options)
+	{
+		UseOptions = Options;
+	}
+
+	virtual ~FMeshNoiseOp() override {}
+
+	// Called on background thread to compute the mesh op result. 
+	// The input mesh is stored and returned via .ResultMesh member.
+	// .ResultInfo member is used to indicate success/failure
+	virtual void CalculateResult(FProgressCancel* Progress) override;
+
+	// the tessellated mesh and its normals dominate the peak memory
+	virtual uint64 EstimatePeakMemory() const override;
+	// reduces the number of subdivisions
+	virtual bool Downgrade() override;
+
+	const FOptions& GetOptions() const { return UseOptions; }
+
+	/**
+	 * Apply the noise operation to Mesh in place, without the copy of the operator input, eg for Blueprint functions that
+	 * edit a UDynamicMesh. The vertex normals are computed from Mesh. If cancelled, Mesh may be partially modified.
+	 * @return false if cancelled
+	 */
+	static bool ApplyToMesh(FDynamicMesh3& Mesh, const FOptions& Options, FProgressCancel* Progress = nullptr);
+
+protected:
+	FOptions UseOptions;
+
+	// the stages of CalculateResult() after ResultMesh has been initialized
+	void ComputeFromResultMesh(bool bReuseTessellation, FProgressCancel* Progress);
+
+	// @return true if Tessellation can be used for the current options
+	bool CanReuseTessellation() const;
+
+	// @return true if the tessellation is loaded from and stored to the FTessellationDiskCache
+	bool UseTessellationDiskCache() const;
+	// load the tessellation of the input mesh into ResultMesh and Tessellation from the FTessellationDiskCache
+	// @return false if there is no entry, or if cancelled
+	bool LoadCachedTessellation(FProgressCancel* Progress);
+
+	// displacement weight of each vertex of the result mesh, indexed by vertex ID, and the IDs of the vertices with a
+	// non-zero weight in increasing order. Unmasked operators do not compute it.
+	struct FVertexMask
+	{
+		TArray<float> Weights;
+		TArray<int32> VertexIDs;
+	};
+	bool IsMasked() const;
+	void ComputeMask(FVertexMask& Mask) const;
+	// @return memory of the mask for the given number of vertices, in bytes
+	uint64 EstimateMaskMemory(int64 NumVertices) const;
+
+	// @return true if the analytic normals can be written to the normals of the result mesh
+	bool CanUseAnalyticNormals() const;
+	// @return memory of the analytic normals for the given number of vertices, in bytes, if they are computed
+	uint64 EstimateAnalyticNormalsMemory(int64 NumVertices) const;
+
+	// the analytic normals, indexed by vertex ID. Either an array of all vertices, or a scratch file of which only the window
+	// of the vertex IDs that are being written or read is mapped.
+	struct FDisplacedNormals
+	{
+		TArray<FVector3f> Normals;
+		TUniquePtr<FScratchFile> ScratchFile;
+		TArrayView<FVector3f> Window;
+		int32 WindowStart = 0;
+		// number of vertex IDs that are mapped at a time
+		int32 WindowVertexIDs = 0;
+
+		// map the normals of the vertex IDs [StartVertexID, EndVertexID), a no-op for the in-memory array. @return false on failure
+		bool MapWindow(int32 StartVertexID, int32 EndVertexID);
+
+		FVector3f& operator[](int32 VertexID) { return Window[VertexID - WindowStart]; }
+	};
+	// @return true if the analytic normals for the given number of vertices are kept in a scratch file
+	bool UseNormalsScratchFile(int64 NumVertices) const;
+	// allocate the analytic normals for the vertex IDs of the result mesh, in memory if the scratch file cannot be created
+	void InitializeDisplacedNormals(FDisplacedNormals& DisplacedNormals);
+	// set the normals of the result mesh from the analytic normals. @return false if the scratch file could not be mapped
+	bool SetAnalyticNormals(FDisplacedNormals& DisplacedNormals);
+
+	// @return number of vertex IDs that are displaced per batch, ie all of them unless the batch would exceed the memory budget.
+	// If bNormalsWindow is true, the mapped window of the analytic normals counts against the budget as well.
+	template<typename RealType>
+	int32 GetBatchVertexIDs(int32 MaxVertexID, bool bNormalsWindow) const;
+	// @return memory of the batched displacement arrays for the given number of vertices, within the memory budget
+	uint64 EstimateBatchMemory(int64 NumVertices) const;
+
+	// If DisplacedNormals is non-null, the normals of the displaced surface are written to it, indexed by vertex ID (Perlin noise only).
+	// @return false if cancelled
+	bool DisplaceIndexed(const TArray<FVector3d>& VertexNormals, const FVertexMask* Mask, FDisplacedNormals* DisplacedNormals, FProgressCancel* Progress);
+	template<typename RealType>
+	bool DisplaceBatched(const TArray<FVector3d>& VertexNormals, const FVertexMask* Mask, FDisplacedNormals* DisplacedNormals, FProgressCancel* Progress);
+};
+
+
+}
+}
@@ -0,0 +1,57 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Operations/MeshProcessingOperator.h"
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FMeshPlaneCutOp computes the plane cut of the UMeshPlaneCutTool, optionally filling the cut holes.
+ * The operator is created on the game thread, however the CalculateResult function is run from a
+ * background compute thread.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshPlaneCutOp : public FMeshProcessingOperator
+{
+public:
+	struct FOptions
+	{
+		FTransform LocalToWorld;
+		FTransform WorldPlane;
+		bool bFillHole;
+	};
+
+	FMeshPlaneCutOp(FOptions Options)
+	{
+		UseOptions = Options;
+	}
+
+	virtual ~FMeshPlaneCutOp() override {}
+
+	// base class overrides this.  Results in updated ResultMesh. This function runs in a background thread!!
+	virtual void CalculateResult(FProgressCancel* Progress) override;
+
+	virtual uint64 EstimatePeakMemory() const override;
+
+	/**
+	 * Apply the plane cut to Mesh in place, without the copy of the operator input, eg for Blueprint functions that
+	 * edit a UDynamicMesh. If cancelled, Mesh may be partially modified.
+	 * @return false if cancelled
+	 */
+	static bool ApplyToMesh(FDynamicMesh3& Mesh, const FOptions& Options, FProgressCancel* Progress = nullptr);
+
+protected:
+	FOptions UseOptions;
+
+	// the stages of CalculateResult() after ResultMesh has been initialized
+	void ComputeFromResultMesh(FProgressCancel* Progress);
+};
+
+
+}
+}
@@ -0,0 +1,83 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+
+
+/**
+ * FMeshProcessingComputePool runs the background computes of the plugin Tools on its own worker threads, so that
+ * the number of concurrent operators, and their thread priority and affinity, can be limited independently of the
+ * engine thread pool that is shared with eg shader compilation and asset loading. The pool is configured by
+ * USampleModelingModeExtensionSettings, and the threads are created on the first Submit().
+ *
+ * Tasks are queued per channel (eg a Tool preview): a task that is submitted while an earlier task of the same
+ * channel is still queued replaces it, ie the latest request wins and superseded requests never start.
+ * Note that operators may still use ParallelFor internally, which runs on the task graph workers.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingComputePool
+{
+public:
+	/** @return the module-wide pool */
+	static FMeshProcessingComputePool& Get();
+
+	~FMeshProcessingComputePool();
+
+	/**
+	 * Queue Task for execution on a worker thread
+	 * @param Channel if non-null, a queued task of the same channel is dropped and replaced by Task
+	 */
+	void Submit(const void* Channel, TUniqueFunction<void()> Task);
+
+	/** Drop the queued task of Channel, if any. A task that is already running is not affected. */
+	void CancelQueued(const void* Channel);
+
+	/** Stop the worker threads after their running tasks, queued tasks are dropped. The pool restarts on the next Submit(). */
+	void Shutdown();
+
+	struct FMetrics
+	{
+		int32 NumThreads = 0;
+		int32 QueueDepth = 0;
+		int32 PeakQueueDepth = 0;
+		int32 NumRunning = 0;
+		int64 NumCompleted = 0;
+		// queued tasks that were replaced or cancelled before they started
+		int64 NumDropped = 0;
+	};
+	FMetrics GetMetrics() const;
+
+protected:
+	class FWorker;
+	friend class FWorker;
+
+	struct FQueuedTask
+	{
+		const void* Channel = nullptr;
+		TUniqueFunction<void()> Task;
+	};
+	TArray<FQueuedTask> Queue;
+	mutable FCriticalSection QueueLock;
+
+	TArray<FWorker*> Workers;
+	TArray<FRunnableThread*> Threads;
+	std::atomic<bool> bStopping{ false };
+
+	int32 PeakQueueDepth = 0;
+	std::atomic<int32> NumRunning{ 0 };
+	std::atomic<int64> NumCompleted{ 0 };
+	int64 NumDropped = 0;
+
+	// create the worker threads from the current settings, must be called with QueueLock held
+	void StartThreads();
+	// @return false if the queue is empty
+	bool DequeueTask(TUniqueFunction<void()>& TaskOut);
+	void WakeWorkers();
+	void UpdateQueueStats();
+};
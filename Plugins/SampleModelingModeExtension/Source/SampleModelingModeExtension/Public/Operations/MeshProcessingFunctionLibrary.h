@@ -0,0 +1,50 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Tools/MeshNoiseTool.h"
+#include "MeshProcessingFunctionLibrary.generated.h"
+
+class UDynamicMesh;
+
+
+/**
+ * UMeshProcessingFunctionLibrary exposes the native mesh processing of the plugin Tools to Blueprints, eg to be used
+ * in UMeshProcessingBPToolOperation::OnRecomputeMesh() next to Geometry Script functions. The functions edit the
+ * TargetMesh in place (via UDynamicMesh::EditMesh()), and return it so that calls can be chained.
+ * The functions only access the TargetMesh, so they can be used from Operations that enable background execution.
+ */
+UCLASS(meta = (ScriptName = "SampleModelingModeExtension_MeshProcessing"))
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingFunctionLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+public:
+
+	/**
+	 * Apply the Noise Tool operation to TargetMesh: optional PN tessellation, followed by Random or Perlin displacement along the vertex normals
+	 * @param bSinglePrecision compute the displacement in single precision, which is faster but deviates slightly from the double-precision result
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MeshProcessing|Deformations", meta = (ScriptMethod))
+	static UPARAM(DisplayName = "Target Mesh") UDynamicMesh* ApplyMeshNoise(
+		UDynamicMesh* TargetMesh,
+		int Subdivisions = 0,
+		EMeshNoiseToolNoiseType NoiseType = EMeshNoiseToolNoiseType::Perlin,
+		float Scale = 5.0f,
+		float Frequency = 1.0f,
+		int Seed = 10,
+		bool bSinglePrecision = false);
+
+	/**
+	 * Apply the Plane Cut Tool operation to TargetMesh, ie remove the part of the mesh on the positive side of the plane
+	 * @param CutPlane the plane is the XY plane of this frame, in the space of the mesh
+	 * @param bFillHole fill the holes created by the cut
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MeshProcessing|Editing", meta = (ScriptMethod))
+	static UPARAM(DisplayName = "Target Mesh") UDynamicMesh* ApplyMeshPlaneCut(
+		UDynamicMesh* TargetMesh,
+		FTransform CutPlane,
+		bool bFillHole = true);
+};
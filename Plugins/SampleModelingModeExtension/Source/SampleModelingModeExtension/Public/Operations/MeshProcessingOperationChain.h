@@ -0,0 +1,131 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+
+class FProgressCancel;
+class UDynamicMesh;
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * Threading contract of an IMeshProcessingOperation
+ */
+enum class EMeshProcessingOperationThreading : uint8
+{
+	/**
+	 * The Operation only reads its own settings (which must be copied at construction time) and
+	 * only modifies the mesh passed to it. It can be executed on any thread, and unless
+	 * IMeshProcessingOperation::CanExecuteConcurrently() is overridden, the same Operation instance
+	 * can be executed concurrently on different meshes.
+	 */
+	AnyThread,
+	/**
+	 * The Operation accesses UObjects, Subsystems or other Engine state (eg a Blueprint) and
+	 * must only be executed on the Game Thread.
+	 */
+	GameThread
+};
+
+
+/**
+ * IMeshProcessingOperation is a single step of a FMeshProcessingOperationChain. Operations
+ * edit the mesh in-place, either as a FDynamicMesh3 (native operations) or as a UDynamicMesh
+ * (eg for Blueprints, which can only operate on the UObject wrapper).
+ */
+class SAMPLEMODELINGMODEEXTENSION_API IMeshProcessingOperation
+{
+public:
+	virtual ~IMeshProcessingOperation() {}
+
+	/** @return the threading contract of this Operation */
+	virtual EMeshProcessingOperationThreading GetThreading() const = 0;
+
+	/**
+	 * @return true if the result of this Operation at any vertex/triangle only depends on a bounded neighbourhood
+	 * of the input mesh (eg per-vertex displacement, or local remeshing). Local Operations can be executed on
+	 * spatial chunks of the mesh in parallel, see FMeshChunkedExecution.
+	 */
+	virtual bool IsLocalOperation() const { return false; }
+
+	/**
+	 * @return number of one-ring triangle layers around a region that a local Operation reads to compute the region (eg 1 for
+	 * vertex normals). FMeshChunkedExecution extracts at least this halo around each chunk.
+	 */
+	virtual int32 GetRequiredHaloRings() const { return 0; }
+
+	/**
+	 * @return true if this Operation instance can be executed concurrently on different meshes. Operations that keep
+	 * state in the instance (eg a Blueprint that runs in the background) return false, and each concurrent execution
+	 * then needs its own instance.
+	 */
+	virtual bool CanExecuteConcurrently() const { return GetThreading() == EMeshProcessingOperationThreading::AnyThread; }
+
+	/** @return true if this Operation must be applied via ApplyToDynamicMesh() instead of Apply() */
+	virtual bool RequiresDynamicMeshObject() const { return false; }
+
+	/** Apply the Operation to the Mesh in-place. Only called if RequiresDynamicMeshObject() is false. */
+	virtual void Apply(FDynamicMesh3& Mesh, FProgressCancel* Progress) {}
+
+	/** Apply the Operation to the Mesh in-place. Only called if RequiresDynamicMeshObject() is true. */
+	virtual void ApplyToDynamicMesh(UDynamicMesh* Mesh, FProgressCancel* Progress) {}
+};
+
+
+/**
+ * FMeshProcessingOperationChain executes a sequence of IMeshProcessingOperations on a single mesh buffer.
+ * Consecutive native operations are applied directly to the FDynamicMesh3, and the mesh is only moved into
+ * a UDynamicMesh (and back) once for each run of consecutive operations that require it. Runs of
+ * GameThread operations are dispatched to the Game Thread as a single unit of work.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingOperationChain
+{
+public:
+	/** Function that executes the passed work function on the Game Thread, and blocks until it is complete */
+	typedef TFunctionRef<void(TFunctionRef<void()>)> FGameThreadDispatcher;
+
+	void AddOperation(TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe> Operation);
+
+	/** Release all Operations in the chain */
+	void Reset() { Operations.Reset(); }
+
+	int32 Num() const { return Operations.Num(); }
+	bool IsEmpty() const { return Operations.Num() == 0; }
+
+	/** @return true if no Operation in the chain requires the Game Thread */
+	bool IsThreadSafe() const;
+
+	/** @return true if every Operation in the chain can be executed concurrently, ie the same chain can be executed on several meshes at once */
+	bool CanExecuteConcurrently() const;
+
+	/** @return true if every Operation in the chain is a local Operation */
+	bool IsLocal() const;
+
+	/** @return the halo that the chain reads around a region, ie the sum of the halos of its Operations, as each reads the result of the previous one */
+	int32 GetRequiredHaloRings() const;
+
+	/** @return true if any Operation in the chain requires a UDynamicMesh */
+	bool RequiresDynamicMeshObject() const;
+
+	/**
+	 * Execute the chain on Mesh, in-place.
+	 * @param TempMesh UDynamicMesh used for Operations that require it. May be null if RequiresDynamicMeshObject() is false.
+	 * @param RunOnGameThread used to execute GameThread Operations if Execute() is not called on the Game Thread
+	 * @return false if execution was cancelled
+	 */
+	bool Execute(FDynamicMesh3& Mesh, FProgressCancel* Progress, UDynamicMesh* TempMesh, FGameThreadDispatcher RunOnGameThread) const;
+
+protected:
+	TArray<TSharedPtr<IMeshProcessingOperation, ESPMode::ThreadSafe>> Operations;
+};
+
+
+
+}
+}
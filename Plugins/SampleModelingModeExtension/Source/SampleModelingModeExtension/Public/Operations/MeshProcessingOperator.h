@@ -0,0 +1,162 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ModelingOperators.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include <atomic>
+
+class FProgressCancel;
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FOperatorGenerationCounter is shared between a Tool and the operators it creates. The Tool advances
+ * the generation each time it invalidates its result, and operators compare against the generation they
+ * were created with at each stage boundary, so that superseded computes can exit early. The counter also
+ * accumulates statistics about how much background work was wasted.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FOperatorGenerationCounter
+{
+public:
+	/** Start a new generation, all operators created before this call are now superseded */
+	int64 Advance() { return ++Generation; }
+
+	int64 GetCurrent() const { return Generation.load(); }
+
+	/** Called by an operator that exited early because it was superseded */
+	void RecordStaleExit() { StaleExits++; }
+	/** Called by a Tool that received the result of a superseded operator */
+	void RecordDiscardedResult() { DiscardedResults++; }
+
+	int64 GetNumStaleExits() const { return StaleExits.load(); }
+	int64 GetNumDiscardedResults() const { return DiscardedResults.load(); }
+
+protected:
+	std::atomic<int64> Generation{ 0 };
+	std::atomic<int64> StaleExits{ 0 };
+	std::atomic<int64> DiscardedResults{ 0 };
+};
+
+
+/**
+ * FMeshProcessingOperator is the base class for the operators of the plugin Tools. The input mesh is
+ * shared with the Tool and only copied into the ResultMesh on the background thread, by CopyInputMesh().
+ * Subclasses call CheckStageCancelled() at their stage boundaries to exit early if the compute was
+ * cancelled or superseded by a newer generation.
+ *
+ * Operators also account for their memory: EstimatePeakMemory() predicts the peak before the compute starts,
+ * so that the Tool can enforce a memory limit, and subclasses call UpdateTrackedMemory() as their buffers
+ * grow, so that the Tool can report the current and peak usage while computing.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingOperator : public FDynamicMeshOperator
+{
+public:
+	virtual ~FMeshProcessingOperator() override {}
+
+	void SetInputMesh(TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> InputMeshIn)
+	{
+		InputMesh = InputMeshIn;
+	}
+
+	// set ability on protected transform.
+	void SetTransform(const FTransformSRT3d& XForm)
+	{
+		ResultTransform = XForm;
+	}
+
+	/** Set the generation counter of the Tool, this operator belongs to the current generation */
+	void SetGenerationCounter(TSharedPtr<FOperatorGenerationCounter, ESPMode::ThreadSafe> CounterIn);
+
+	int64 GetGeneration() const { return Generation; }
+
+	/** @return true if the Tool has started a newer generation since this operator was created */
+	bool IsSuperseded() const;
+
+	/** Timing and memory of a stage of CalculateResult(), recorded if bCollectStageStats is enabled */
+	struct FStageStats
+	{
+		const TCHAR* Name = nullptr;
+		double Seconds = 0;
+		/** process physical memory in use at the end of the stage, and the change over the stage */
+		uint64 UsedPhysical = 0;
+		int64 UsedPhysicalDelta = 0;
+		/** peak of the memory tracked by the operator at the end of the stage, see GetTrackedPeakMemory() */
+		uint64 TrackedPeakMemory = 0;
+	};
+
+	/** If true, each stage of CalculateResult() is timed, for benchmarking. Off by default as querying memory stats is not free. */
+	bool bCollectStageStats = false;
+
+	const TArray<FStageStats>& GetStageStats() const { return StageStats; }
+
+	/** @return estimate of the peak memory of CalculateResult() in bytes. Called on the game thread before the compute starts. */
+	virtual uint64 EstimatePeakMemory() const;
+
+	/**
+	 * Reduce the quality of the operator by one step, to reduce its peak memory (eg fewer subdivisions).
+	 * Called on the game thread before the compute starts.
+	 * @return false if the operator cannot be downgraded any further
+	 */
+	virtual bool Downgrade() { return false; }
+
+	/** Memory currently held by the operator buffers in bytes, as tracked by the operator. Can be called from any thread. */
+	uint64 GetTrackedCurrentMemory() const { return TrackedCurrentMemory.load(); }
+	/** Peak of GetTrackedCurrentMemory() so far. Can be called from any thread. */
+	uint64 GetTrackedPeakMemory() const { return TrackedPeakMemory.load(); }
+
+	/** @return approximate memory of a FDynamicMesh3 with the given element counts, in bytes */
+	static uint64 EstimateMeshMemory(int64 NumVertices, int64 NumTriangles, bool bHasAttributes);
+	/** @return approximate memory of the given mesh, including its attribute overlays, in bytes */
+	static uint64 EstimateMeshMemory(const FDynamicMesh3& Mesh);
+
+protected:
+	TSharedPtr<const FDynamicMesh3, ESPMode::ThreadSafe> InputMesh;
+
+	TSharedPtr<FOperatorGenerationCounter, ESPMode::ThreadSafe> GenerationCounter;
+	int64 Generation = 0;
+	bool bRecordedStaleExit = false;
+
+	TArray<FStageStats> StageStats;
+
+	std::atomic<uint64> TrackedCurrentMemory{ 0 };
+	std::atomic<uint64> TrackedPeakMemory{ 0 };
+
+	/** Set the tracked current memory to the size of ResultMesh plus AdditionalBytes (eg temporary normals buffers) */
+	void UpdateTrackedMemory(uint64 AdditionalBytes = 0);
+
+	/** Records a FStageStats for the enclosing scope, if bCollectStageStats is enabled */
+	class SAMPLEMODELINGMODEEXTENSION_API FScopedStage
+	{
+	public:
+		FScopedStage(FMeshProcessingOperator& Operator, const TCHAR* Name);
+		~FScopedStage();
+	protected:
+		FMeshProcessingOperator& Operator;
+		const TCHAR* Name;
+		double StartTime = 0;
+		uint64 StartUsedPhysical = 0;
+	};
+
+	/**
+	 * Check for cancellation or supersession at a stage boundary. If the operator should stop,
+	 * ResultInfo is set to Cancelled and a stale exit is recorded with the generation counter.
+	 * @return true if the operator should stop
+	 */
+	bool CheckStageCancelled(FProgressCancel* Progress);
+
+	/**
+	 * Copy InputMesh into ResultMesh, unless the operator was already cancelled or superseded.
+	 * @return false if the operator should stop
+	 */
+	bool CopyInputMesh(FProgressCancel* Progress);
+};
+
+
+}
+}
@@ -0,0 +1,92 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Operations/MeshNoiseOp.h"
+#include "Operations/MeshPlaneCutOp.h"
+#include "Operations/MeshChunkedExecution.h"
+#include "Operations/MeshProcessingOperationChain.h"
+#include "UObject/StrongObjectPtr.h"
+
+class FJsonObject;
+class UInteractiveToolPropertySet;
+class UMeshProcessingBPToolOperation;
+
+
+/**
+ * FMeshProcessingPreset is the configuration of a Noise, Plane Cut or Blueprint processing operation outside
+ * of a Tool, created from a JSON preset with the Operation name and the Tool settings of that Operation, eg
+ *   { "Operation": "Noise", "Properties": { "Subdivisions": 1, "NoiseType": "Perlin", "Scale": 2.0 } }
+ *   { "Operation": "PlaneCut", "PlaneAtBoundsCenter": true, "Properties": { "Rotation": { "Pitch": 90, "Yaw": 0, "Roll": 0 } } }
+ *   { "Operation": "BP", "Properties": { "Operation": "/Game/BP_MyOperation.BP_MyOperation_C" }, "Steps": [ "MeshProcessingRecomputeNormalsChainStep" ] }
+ * Steps are listed by class name with their default settings, or as { "Class": "<class name>", "Properties": { <step settings> } }.
+ * It is used by the bulk commandlet, and by the worker processes of FMeshProcessingWorkerPool.
+ *
+ * The preset is initialized on the game thread, and then only read, so that the operators of several meshes
+ * can be created from it concurrently. The Blueprint instances of Chain must only execute one mesh at a time,
+ * concurrent executions of a Blueprint chain each need their own instances, see MakeBlueprintChain().
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingPreset
+{
+public:
+	enum class EOperation : uint8
+	{
+		Noise,
+		PlaneCut,
+		Blueprint
+	};
+
+	EOperation Operation = EOperation::Noise;
+	bool bPlaneAtBoundsCenter = false;
+
+	TStrongObjectPtr<UInteractiveToolPropertySet> Properties;
+	// operator options copied from Properties
+	UE::Geometry::FMeshNoiseOp::FOptions NoiseOptions;
+	UE::Geometry::FMeshPlaneCutOp::FOptions PlaneCutOptions;
+
+	// Blueprint path
+	UE::Geometry::FMeshProcessingOperationChain Chain;
+	TArray<TStrongObjectPtr<UMeshProcessingBPToolOperation>> BlueprintInstances;
+	bool bNativeChain = false;
+	bool bChunkedExecution = false;
+	UE::Geometry::FMeshChunkedExecutionOptions ChunkOptions;
+
+	/** Parse an Operation name (Noise, PlaneCut, BP or Blueprint, case-insensitive) */
+	static bool ParseOperation(const FString& Name, EOperation& OperationOut);
+
+	/** Load a preset from a file path, or from a file named Preset in <Project>/Config/MeshProcessingPresets */
+	static bool LoadPresetJson(const FString& Preset, TSharedPtr<FJsonObject>& JsonOut);
+
+	/**
+	 * Create the preset JSON of the current settings of a Tool, eg to configure the same operation in a worker process.
+	 * Instanced AdditionalSteps of a Blueprint Tool are written with their class and settings.
+	 */
+	static FString MakePresetJsonString(EOperation Operation, const UInteractiveToolPropertySet* ToolProperties);
+
+	/**
+	 * Create the Tool property set of the Operation, apply the preset to it, and copy the operator options. Must be called on the game thread.
+	 * @param PresetJson the preset, may be null to use the default settings
+	 * @param OperationName if not empty, overrides the Operation of the preset
+	 */
+	bool Initialize(const TSharedPtr<FJsonObject>& PresetJson, const FString& OperationName);
+
+	/**
+	 * Create a copy of Chain with new Blueprint Operation instances, eg to execute it concurrently with Chain. Must be called on the game thread.
+	 * @param InstancesOut keeps the Blueprint instances alive, for as long as ChainOut is used
+	 */
+	void MakeBlueprintChain(UE::Geometry::FMeshProcessingOperationChain& ChainOut, TArray<TStrongObjectPtr<UMeshProcessingBPToolOperation>>& InstancesOut) const;
+
+	/** @return true if the preset is a Blueprint chain that cannot run as an operator, and must be executed with Chain.Execute() */
+	bool RequiresChainExecution() const
+	{
+		return Operation == EOperation::Blueprint && bNativeChain == false;
+	}
+
+	/**
+	 * Create the operator of the preset for InputMesh, in the local space of the mesh. Can be called from any thread.
+	 * @return null if RequiresChainExecution()
+	 */
+	TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeOperator(const TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe>& InputMesh) const;
+};
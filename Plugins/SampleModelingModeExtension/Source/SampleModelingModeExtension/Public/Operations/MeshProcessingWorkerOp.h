@@ -0,0 +1,52 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Operations/MeshProcessingOperator.h"
+#include <atomic>
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FMeshProcessingWorkerOp executes the operation of a FMeshProcessingPreset in a worker process of the
+ * FMeshProcessingWorkerPool, so that a Tool can run an operation that may crash or hang without risking the editor.
+ * The CalculateResult function runs in a background thread, and blocks it until the worker has finished.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingWorkerOp : public FMeshProcessingOperator
+{
+public:
+	/**
+	 * @param PresetJsonIn the operation, see FMeshProcessingPreset::MakePresetJsonString()
+	 * @param TimeoutSecondsIn the worker is terminated if the operation takes longer than this, 0 for no limit
+	 */
+	FMeshProcessingWorkerOp(const FString& PresetJsonIn, double TimeoutSecondsIn)
+		: PresetJson(PresetJsonIn), TimeoutSeconds(TimeoutSecondsIn)
+	{
+	}
+
+	virtual ~FMeshProcessingWorkerOp() override {}
+
+	// base class overrides this.  Results in updated ResultMesh. This function runs in a background thread!!
+	virtual void CalculateResult(FProgressCancel* Progress) override;
+
+	virtual uint64 EstimatePeakMemory() const override;
+
+	/**
+	 * A superseded or cancelled operator lets the worker finish its request, so that the process can be reused. If this flag is
+	 * set to true, eg once the Tool has shut down, the worker process is terminated instead.
+	 */
+	TSharedPtr<const std::atomic<bool>, ESPMode::ThreadSafe> AbortFlag;
+
+protected:
+	FString PresetJson;
+	double TimeoutSeconds = 0;
+};
+
+
+}
+}
@@ -0,0 +1,118 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+class FEvent;
+
+/**
+ * FMeshProcessingWorkerPool executes mesh processing operations in a pool of local worker processes (editor
+ * commandlets, see UMeshProcessingWorkerCommandlet), so that an operation that crashes, leaks or hangs - eg a
+ * user Blueprint on a large mesh - only takes down its worker, and not the editor or the bulk commandlet.
+ * The pool is configured by USampleModelingModeExtensionSettings, and the processes are started on first use
+ * and reused for subsequent requests, which avoids paying the process startup time per operation.
+ *
+ * The operation is described by a FMeshProcessingPreset JSON string. The preset and the input mesh are written
+ * into a named shared memory region that the worker reads directly, and the worker writes the result mesh into
+ * another region, in the flat layout of FMeshSharedMemoryLayout. The regions are sized up front from the mesh counts,
+ * so each mesh is written once per direction and never goes through pipes, files or an intermediate archive. A small
+ * control region per worker holds the request state, and a pair of interprocess semaphores wakes each side when the
+ * other one changes it.
+ *
+ * Each worker executes one request at a time, and the number of workers bounds the number of concurrent requests.
+ * Callers block in Execute() until a worker is free. The operating system places the processes on the available
+ * cores and memory nodes, WorkerProcessCount controls how many run concurrently.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshProcessingWorkerPool
+{
+public:
+	/** @return the module-wide pool */
+	static FMeshProcessingWorkerPool& Get();
+
+	FMeshProcessingWorkerPool();
+	~FMeshProcessingWorkerPool();
+
+	enum class EResult : uint8
+	{
+		Success,
+		// the operation or the request was invalid, the worker is still usable
+		Failed,
+		Cancelled,
+		// the worker did not finish within the timeout, and was terminated
+		TimedOut,
+		// the worker process exited while executing the request
+		Crashed
+	};
+
+	/**
+	 * Execute the operation of PresetJson on InputMesh in a worker process, and block until the result is available.
+	 * Can be called from any thread.
+	 * @param TimeoutSeconds the worker is terminated if the operation takes longer than this, 0 for no limit
+	 * @param CancelF if set, polled while waiting. The worker is asked to stop, and Execute() returns Cancelled once it has stopped or finished
+	 *        the request. The worker is not terminated, as restarting it costs far more than most requests (eg a superseded preview).
+	 * @param AbortF if set, polled while waiting. The worker is terminated, eg when the Tool that waits for the result shuts down.
+	 * @param ErrorOut set to a description of the failure, if the result is not Success
+	 */
+	EResult Execute(const FString& PresetJson, const UE::Geometry::FDynamicMesh3& InputMesh, UE::Geometry::FDynamicMesh3& ResultMesh,
+		double TimeoutSeconds, const TFunction<bool()>& CancelF, const TFunction<bool()>& AbortF, FString& ErrorOut);
+
+	/** Ask all idle worker processes to exit, and terminate them if they do not. Busy workers are terminated. The pool restarts processes on the next Execute(). */
+	void Shutdown();
+
+	struct FMetrics
+	{
+		int32 NumProcesses = 0;
+		int32 NumBusy = 0;
+		int32 NumStarted = 0;
+		int64 NumCompleted = 0;
+		int64 NumFailed = 0;
+		int64 NumCancelled = 0;
+		int64 NumTimedOut = 0;
+		int64 NumCrashed = 0;
+	};
+	FMetrics GetMetrics() const;
+
+	/**
+	 * Run the request loop of a worker process, until the host process exits or shuts the worker down.
+	 * Called by UMeshProcessingWorkerCommandlet on the game thread of the worker process.
+	 * @param ControlRegionName name of the control region created by the host
+	 * @param HostProcessID the worker exits once this process is no longer running
+	 * @return the process exit code
+	 */
+	static int32 RunWorker(const FString& ControlRegionName, uint32 HostProcessID);
+
+	static const TCHAR* LexToString(EResult Result);
+
+protected:
+	struct FWorkerProcess;
+
+	TArray<TUniquePtr<FWorkerProcess>> Workers;
+	mutable FCriticalSection Lock;
+	uint32 NextWorkerID = 0;
+	// triggered when a worker is released, wakes a request that waits for a free worker
+	FEvent* WorkerReleasedEvent = nullptr;
+
+	int32 NumStarted = 0;
+	std::atomic<int64> NumCompleted{ 0 };
+	std::atomic<int64> NumFailed{ 0 };
+	std::atomic<int64> NumCancelled{ 0 };
+	std::atomic<int64> NumTimedOut{ 0 };
+	std::atomic<int64> NumCrashed{ 0 };
+
+	// wait for a free worker, starting a process if the pool is not full. @return null if cancelled, or with ErrorOut set if no process could be started
+	FWorkerProcess* AcquireWorker(const TFunction<bool()>& CancelF, FString& ErrorOut);
+	void ReleaseWorker(FWorkerProcess* Worker);
+
+	// must be called with Lock held
+	bool StartProcess(FWorkerProcess& Worker);
+	// terminate the process of Worker and release its control region, it is restarted on next use
+	static void StopProcess(FWorkerProcess& Worker, bool bTerminate);
+
+	EResult ExecuteOnWorker(FWorkerProcess& Worker, const FString& PresetJson, const UE::Geometry::FDynamicMesh3& InputMesh,
+		UE::Geometry::FDynamicMesh3& ResultMesh, double TimeoutSeconds, const TFunction<bool()>& CancelF, const TFunction<bool()>& AbortF, FString& ErrorOut);
+};
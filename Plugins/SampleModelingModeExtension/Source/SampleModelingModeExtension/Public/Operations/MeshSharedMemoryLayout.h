@@ -0,0 +1,45 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FMeshSharedMemoryLayout is the layout of a FDynamicMesh3 in a shared memory region of FMeshProcessingWorkerPool: a small header
+ * with the element counts, followed by the raw per-ID arrays of the vertices, triangles and attributes (UV, normal and color
+ * overlays, material IDs and polygroup layers). Vertex, triangle and element IDs are preserved, including the holes of a
+ * non-compact mesh. The size of the block follows from the counts, so it is written in a single pass directly into the region,
+ * and the reader inserts the arrays into the mesh without an intermediate archive.
+ *
+ * Meshes with attributes outside of the layout (eg weight layers or generic attached attributes) are written with the
+ * FDynamicMesh3 serialization instead, behind the same header.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshSharedMemoryLayout
+{
+public:
+	/** @return the number of bytes that Write() writes for Mesh */
+	static uint64 GetSize(const FDynamicMesh3& Mesh);
+
+	/**
+	 * Write Mesh into Data, which must hold at least GetSize(Mesh) bytes and be 16-byte aligned
+	 * @return false if Size is too small
+	 */
+	static bool Write(const FDynamicMesh3& Mesh, uint8* Data, uint64 Size);
+
+	/**
+	 * Read a mesh written by Write() from Data
+	 * @return false if Data is not a valid mesh block
+	 */
+	static bool Read(const uint8* Data, uint64 Size, FDynamicMesh3& MeshOut);
+};
+
+
+}
+}
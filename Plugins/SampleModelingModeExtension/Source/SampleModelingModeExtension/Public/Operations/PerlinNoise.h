@@ -0,0 +1,33 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VectorTypes.h"
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * FPerlinNoise is 3D improved Perlin noise (reference permutation, quintic fade curve), that can also evaluate the
+ * analytic gradient of the noise together with its value. This allows the normal of a surface displaced by the noise
+ * to be computed at the same time as the displacement. Values are approximately in the range [-1, 1].
+ */
+struct SAMPLEMODELINGMODEEXTENSION_API FPerlinNoise
+{
+	/** @return the noise value at Position */
+	static double Evaluate(const FVector3d& Position);
+
+	/**
+	 * @param GradientOut set to the gradient of the noise at Position
+	 * @return the noise value at Position, which is the same as Evaluate(Position)
+	 */
+	static double EvaluateWithGradient(const FVector3d& Position, FVector3d& GradientOut);
+};
+
+
+}
+}
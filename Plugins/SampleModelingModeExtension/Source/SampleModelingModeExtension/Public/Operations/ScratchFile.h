@@ -0,0 +1,76 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * FScratchFile is a temporary file on local disk that is memory-mapped in windows, so that a large working array of an
+ * operator can live on disk instead of in memory. Only the currently mapped window is resident in the process: when a window
+ * is unmapped its pages are written back to the file, and the operating system can reclaim them. The file is deleted when
+ * the FScratchFile is destroyed.
+ *
+ * Mapping is implemented for Windows, Linux and Mac. Create() fails on other platforms, in which case callers should
+ * keep the array in memory instead.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FScratchFile
+{
+public:
+	FScratchFile() = default;
+	FScratchFile(const FScratchFile&) = delete;
+	FScratchFile& operator=(const FScratchFile&) = delete;
+	~FScratchFile();
+
+	/** @return the default directory of scratch files, <Project>/Saved/MeshProcessingScratch */
+	static FString GetDefaultDirectory();
+
+	/**
+	 * Create a file of Size bytes with a unique name in Directory. The contents of the file are undefined until written.
+	 * @return false if the file could not be created or mapping is not supported
+	 */
+	bool Create(const FString& Directory, uint64 Size);
+
+	bool IsValid() const { return FileSize > 0; }
+	uint64 GetSize() const { return FileSize; }
+
+	/**
+	 * Map the bytes [Offset, Offset+Size) of the file for reading and writing, replacing the current window
+	 * @return pointer to the bytes at Offset, or null on failure
+	 */
+	uint8* MapWindow(uint64 Offset, uint64 Size);
+
+	/** Unmap the current window, if any */
+	void UnmapWindow();
+
+	/**
+	 * Map the elements [StartIndex, StartIndex+Num) of the file viewed as an array of ElementType, replacing the current window
+	 * @return the mapped elements, empty on failure
+	 */
+	template<typename ElementType>
+	TArrayView<ElementType> MapElements(int64 StartIndex, int64 Num)
+	{
+		uint8* Window = MapWindow((uint64)StartIndex * sizeof(ElementType), (uint64)Num * sizeof(ElementType));
+		return (Window != nullptr) ? TArrayView<ElementType>((ElementType*)Window, (int32)Num) : TArrayView<ElementType>();
+	}
+
+	/** @return size of the current window in bytes, ie the resident memory of the file */
+	uint64 GetWindowSize() const { return WindowSize; }
+
+protected:
+	FString Path;
+	uint64 FileSize = 0;
+
+	// the file and its mapping object on Windows, the file descriptor on Linux and Mac
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+	int32 FileDescriptor = -1;
+
+	// the mapping starts at a page (or allocation granularity) boundary at or before the requested offset
+	uint8* MappedBase = nullptr;
+	uint64 MappedSize = 0;
+	uint64 WindowSize = 0;
+
+	void Close();
+};
@@ -0,0 +1,77 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "HAL/CriticalSection.h"
+#include "Async/Future.h"
+#include <atomic>
+
+
+/**
+ * FTessellationDiskCache keeps the PN tessellations computed by FMeshNoiseOp on disk, in <Project>/Saved/MeshProcessingCache,
+ * so that the Noise Tool can skip the tessellation of a mesh that it has tessellated before, in an earlier Tool invocation
+ * or editor session.
+ *
+ * Entries are content-addressed: the key is a hash of the serialized input mesh (including its attributes) and the
+ * subdivision level, so an edited asset never hits a stale entry. Each entry is a single file with a small header, the
+ * serialized tessellated mesh and its raw vertex normals, which is memory-mapped to load it. The total size of the entries
+ * is limited by USampleModelingModeExtensionSettings::TessellationDiskCacheLimitMB, and the least-recently used entries
+ * (by file modification time, which a hit updates) are deleted first.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FTessellationDiskCache
+{
+public:
+	/** @return the module-wide cache */
+	static FTessellationDiskCache& Get();
+
+	/** @return true if the cache is enabled in the settings */
+	static bool IsEnabled();
+
+	/** @return true if the tessellation is large enough that loading it is faster than computing it */
+	static bool IsWorthCaching(int64 NumInputTriangles, int32 Subdivisions);
+
+	/** @return the content hash of Mesh that is used as the cache key, never 0. This reads the whole mesh, so callers should keep it. */
+	static uint64 HashMesh(const UE::Geometry::FDynamicMesh3& Mesh);
+
+	/**
+	 * Load the tessellation of the mesh with hash MeshHash at the given level. Can be called from any thread.
+	 * @return false if there is no valid entry
+	 */
+	bool Load(uint64 MeshHash, int32 Subdivisions, UE::Geometry::FDynamicMesh3& MeshOut, TArray<FVector3d>& VertexNormalsOut);
+
+	/**
+	 * Write the tessellation of the mesh with hash MeshHash on the thread pool, and then evict entries until the cache fits into
+	 * the size limit. The mesh and normals are shared with the write, so they must not be modified. Can be called from any thread.
+	 */
+	void StoreAsync(uint64 MeshHash, int32 Subdivisions, TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> Mesh,
+		TSharedPtr<const TArray<FVector3d>, ESPMode::ThreadSafe> VertexNormals);
+
+	/** Wait until the pending writes are complete */
+	void Flush();
+
+	/** Delete all entries */
+	void Clear();
+
+	int64 GetNumHits() const { return NumHits.load(); }
+	int64 GetNumMisses() const { return NumMisses.load(); }
+
+protected:
+	mutable FCriticalSection Lock;
+	TArray<TFuture<void>> PendingStores;
+	// entries that are being written, so that concurrent operators do not write the same entry twice
+	TSet<FString> StoresInFlight;
+
+	std::atomic<int64> NumHits{ 0 };
+	std::atomic<int64> NumMisses{ 0 };
+
+	static FString GetCacheDirectory();
+	static FString GetEntryPath(uint64 MeshHash, int32 Subdivisions);
+
+	void Store(const FString& Path, uint64 MeshHash, int32 Subdivisions, const UE::Geometry::FDynamicMesh3& Mesh, const TArray<FVector3d>& VertexNormals);
+
+	// delete the least-recently used entries until the cache fits into the size limit
+	void Trim();
+};
@@ -0,0 +1,181 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+namespace UE
+{
+namespace Geometry
+{
+
+/**
+ * TVertexBatch is a contiguous structure-of-arrays copy of the vertex positions (and optionally normals) of a
+ * FDynamicMesh3, used to write per-vertex operators (eg displacements) as batch kernels over plain arrays,
+ * instead of indexed GetVertex()/SetVertex() calls on the sparse vertex list of the mesh.
+ *
+ * Usage is Gather() -> ParallelExecute(Kernel) -> Scatter(). Element i of the batch is vertex VertexIDs[i], the
+ * elements are in increasing vertex ID order, ie VertexIndicesItr() order. The arrays are 64-byte aligned so that kernels can be vectorized.
+ *
+ * Positions are stored relative to an Origin, which should be near the mesh (eg the bounds center) for a float
+ * batch, so that single precision covers the extent of the mesh rather than its distance from the world origin.
+ */
+template<typename RealType>
+class TVertexBatch
+{
+public:
+	typedef TArray<RealType, TAlignedHeapAllocator<64>> FRealArray;
+
+	TArray<int32> VertexIDs;
+	FRealArray PositionX, PositionY, PositionZ;
+	// empty unless normals were gathered
+	FRealArray NormalX, NormalY, NormalZ;
+
+	/** The batch positions are relative to this point */
+	FVector3d Origin = FVector3d::Zero();
+
+	/** Number of vertices processed by each ParallelExecute() task */
+	int32 BlockSize = 4096;
+
+	int32 Num() const { return VertexIDs.Num(); }
+	bool HasNormals() const { return NormalX.Num() == VertexIDs.Num(); }
+
+	/**
+	 * Copy the vertex positions of Mesh into the batch
+	 * @param VertexNormals if non-null, per-vertex normals indexed by vertex ID (eg FMeshNormals::GetNormals()) that are also copied
+	 * @param OriginIn the gathered positions are relative to this point
+	 */
+	void Gather(const FDynamicMesh3& Mesh, const TArray<FVector3d>* VertexNormals = nullptr, const FVector3d& OriginIn = FVector3d::Zero())
+	{
+		Gather(Mesh, VertexNormals, OriginIn, 0, Mesh.MaxVertexID());
+	}
+
+	/**
+	 * Copy the vertex positions of the vertices with IDs in [StartVertexID, EndVertexID) into the batch, eg to process a
+	 * large mesh in chunks of bounded memory. The other parameters are the same as for Gather().
+	 */
+	void Gather(const FDynamicMesh3& Mesh, const TArray<FVector3d>* VertexNormals, const FVector3d& OriginIn, int32 StartVertexID, int32 EndVertexID)
+	{
+		Origin = OriginIn;
+		EndVertexID = FMath::Min(EndVertexID, Mesh.MaxVertexID());
+		int32 NumVertices = (StartVertexID == 0 && EndVertexID == Mesh.MaxVertexID()) ? Mesh.VertexCount() : 0;
+		if (NumVertices == 0)
+		{
+			for (int32 vid = StartVertexID; vid < EndVertexID; ++vid)
+			{
+				NumVertices += (Mesh.IsVertex(vid)) ? 1 : 0;
+			}
+		}
+		VertexIDs.Reset(NumVertices);
+		PositionX.SetNumUninitialized(NumVertices);
+		PositionY.SetNumUninitialized(NumVertices);
+		PositionZ.SetNumUninitialized(NumVertices);
+		bool bNormals = (VertexNormals != nullptr);
+		NormalX.SetNumUninitialized(bNormals ? NumVertices : 0);
+		NormalY.SetNumUninitialized(bNormals ? NumVertices : 0);
+		NormalZ.SetNumUninitialized(bNormals ? NumVertices : 0);
+
+		int32 Index = 0;
+		for (int32 vid = StartVertexID; vid < EndVertexID; ++vid)
+		{
+			if (Mesh.IsVertex(vid) == false)
+			{
+				continue;
+			}
+			VertexIDs.Add(vid);
+			FVector3d Position = Mesh.GetVertex(vid) - Origin;
+			PositionX[Index] = (RealType)Position.X;
+			PositionY[Index] = (RealType)Position.Y;
+			PositionZ[Index] = (RealType)Position.Z;
+			if (bNormals)
+			{
+				const FVector3d& Normal = (*VertexNormals)[vid];
+				NormalX[Index] = (RealType)Normal.X;
+				NormalY[Index] = (RealType)Normal.Y;
+				NormalZ[Index] = (RealType)Normal.Z;
+			}
+			Index++;
+		}
+	}
+
+	/**
+	 * Copy the vertex positions of the listed vertices into the batch, eg to only process a region of the mesh. The
+	 * vertex IDs should be in increasing order, so that the mesh is read sequentially. The other parameters are the same as for Gather().
+	 */
+	void Gather(const FDynamicMesh3& Mesh, const TArray<FVector3d>* VertexNormals, const FVector3d& OriginIn, TArrayView<const int32> VertexIDsIn)
+	{
+		Origin = OriginIn;
+		int32 NumVertices = VertexIDsIn.Num();
+		VertexIDs.Reset(NumVertices);
+		VertexIDs.Append(VertexIDsIn.GetData(), NumVertices);
+		PositionX.SetNumUninitialized(NumVertices);
+		PositionY.SetNumUninitialized(NumVertices);
+		PositionZ.SetNumUninitialized(NumVertices);
+		bool bNormals = (VertexNormals != nullptr);
+		NormalX.SetNumUninitialized(bNormals ? NumVertices : 0);
+		NormalY.SetNumUninitialized(bNormals ? NumVertices : 0);
+		NormalZ.SetNumUninitialized(bNormals ? NumVertices : 0);
+
+		for (int32 Index = 0; Index < NumVertices; ++Index)
+		{
+			int32 vid = VertexIDs[Index];
+			FVector3d Position = Mesh.GetVertex(vid) - Origin;
+			PositionX[Index] = (RealType)Position.X;
+			PositionY[Index] = (RealType)Position.Y;
+			PositionZ[Index] = (RealType)Position.Z;
+			if (bNormals)
+			{
+				const FVector3d& Normal = (*VertexNormals)[vid];
+				NormalX[Index] = (RealType)Normal.X;
+				NormalY[Index] = (RealType)Normal.Y;
+				NormalZ[Index] = (RealType)Normal.Z;
+			}
+		}
+	}
+
+	/** Write the batch positions back into the vertices of Mesh, which must be the gathered mesh */
+	void Scatter(FDynamicMesh3& Mesh) const
+	{
+		for (int32 Index = 0; Index < VertexIDs.Num(); ++Index)
+		{
+			Mesh.SetVertex(VertexIDs[Index], Origin + FVector3d((double)PositionX[Index], (double)PositionY[Index], (double)PositionZ[Index]));
+		}
+	}
+
+	/**
+	 * Execute Kernel(StartIndex, EndIndex) on consecutive blocks of BlockSize elements, in parallel.
+	 * @param CancelF if set, polled before each block; remaining blocks are skipped once it returns true
+	 * @return false if execution was cancelled
+	 */
+	bool ParallelExecute(TFunctionRef<void(int32 StartIndex, int32 EndIndex)> Kernel, const TFunction<bool()>& CancelF = TFunction<bool()>()) const
+	{
+		int32 UseBlockSize = FMath::Max(1, BlockSize);
+		int32 NumBlocks = (VertexIDs.Num() + UseBlockSize - 1) / UseBlockSize;
+		std::atomic<bool> bCancelled{ false };
+		ParallelFor(NumBlocks, [&](int32 BlockIndex)
+		{
+			if (bCancelled || (CancelF && CancelF()))
+			{
+				bCancelled = true;
+				return;
+			}
+			int32 StartIndex = BlockIndex * UseBlockSize;
+			Kernel(StartIndex, FMath::Min(StartIndex + UseBlockSize, VertexIDs.Num()));
+		});
+		return bCancelled == false;
+	}
+
+	/** @return memory of the batch arrays for the given number of vertices, in bytes */
+	static uint64 EstimateMemory(int64 NumVertices, bool bNormals)
+	{
+		return (uint64)NumVertices * (sizeof(int32) + ((bNormals) ? 6 : 3) * sizeof(RealType));
+	}
+};
+
+
+}
+}
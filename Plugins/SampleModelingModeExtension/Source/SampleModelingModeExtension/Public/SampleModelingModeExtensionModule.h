@@ -6,7 +6,30 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 #include "ModelingModeToolExtensions.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
+SAMPLEMODELINGMODEEXTENSION_API DECLARE_LOG_CATEGORY_EXTERN(LogSampleModelingModeExtension, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("ModelingModeExtension"), STATGROUP_SampleModelingModeExtension, STATCAT_Advanced);
+
+// enable with -trace=cpu,SampleModelingModeExtension
+UE_TRACE_CHANNEL_EXTERN(SampleModelingModeExtensionChannel, SAMPLEMODELINGMODEEXTENSION_API);
+
+/**
+ * CPU profiler scope on the SampleModelingModeExtension trace channel, that is also recorded as a cycle stat.
+ * Stat must be declared with DECLARE_CYCLE_STAT(..., STATGROUP_SampleModelingModeExtension).
+ */
+#define SAMPLEMODELINGMODEEXTENSION_SCOPE_CYCLE_COUNTER(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, SampleModelingModeExtensionChannel); \
+	SCOPE_CYCLE_COUNTER(Stat)
+
+/**
+ * The module only registers itself as a Modeling Mode extension on startup. The Slate style, icons, UI commands and
+ * Tool Builders are created the first time Modeling Mode queries the extension Tools, so that editors that never enter
+ * Modeling Mode (eg headless automation) do not pay for them. The Tool Builders are created once and kept rooted.
+ */
 class FSampleModelingModeExtensionModule : public IModuleInterface, public IModelingModeToolExtension
 {
 public:
@@ -19,4 +42,12 @@ public:
 	virtual FText GetExtensionName() override;
 	virtual FText GetToolSectionName() override;
 	virtual void GetExtensionTools(const FExtensionToolQueryInfo& QueryInfo, TArray<FExtensionToolDescription>& ToolsOut) override;
+
+protected:
+	// created on the first GetExtensionTools() call, the Tool Builders are rooted until ShutdownModule()
+	TArray<FExtensionToolDescription> ExtensionTools;
+	bool bExtensionToolsInitialized = false;
+
+	// register the style and UI commands and create the Tool Builders, if this was not done yet
+	void InitializeExtensionTools();
 };
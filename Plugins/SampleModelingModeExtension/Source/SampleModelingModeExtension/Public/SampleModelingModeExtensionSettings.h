@@ -0,0 +1,94 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "SampleModelingModeExtensionSettings.generated.h"
+
+
+UENUM()
+enum class EMeshProcessingComputePriority : uint8
+{
+	Normal,
+	BelowNormal,
+	Lowest
+};
+
+
+/**
+ * Editor settings for the SampleModelingModeExtension Tools, in Editor Preferences > Plugins
+ */
+UCLASS(config = EditorPerProjectUserSettings, meta = (DisplayName = "Modeling Mode Extension"))
+class SAMPLEMODELINGMODEEXTENSION_API USampleModelingModeExtensionSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	virtual FName GetContainerName() const override { return FName("Editor"); }
+	virtual FName GetCategoryName() const override { return FName("Plugins"); }
+
+	/** Maximum estimated memory of all the background computes of a Tool together, in megabytes */
+	UPROPERTY(config, EditAnywhere, Category = Memory, meta = (ClampMin = "64", UIMin = "256", UIMax = "65536"))
+	int32 OperatorMemoryLimitMB = 8192;
+
+	/** If a compute would exceed the memory limit on its own, reduce its quality (eg the number of subdivisions) until it fits, instead of refusing it */
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	bool bDowngradeOverMemoryLimit = true;
+
+	/** Maximum memory of the converted input meshes that are kept for reuse by the next Tool on the same asset, in megabytes. 0 disables the cache. */
+	UPROPERTY(config, EditAnywhere, Category = Memory, meta = (ClampMin = "0", UIMin = "0", UIMax = "16384"))
+	int32 InputMeshCacheLimitMB = 2048;
+
+	/** Maximum size of the tessellated meshes that are kept in Saved/MeshProcessingCache, so that the Noise Tool can skip the tessellation of a mesh it has tessellated before, in megabytes. 0 disables the cache. */
+	UPROPERTY(config, EditAnywhere, Category = DiskCache, meta = (ClampMin = "0", UIMin = "0", UIMax = "65536"))
+	int32 TessellationDiskCacheLimitMB = 8192;
+
+	/**
+	 * Maximum memory of the per-vertex working arrays of a displacement operator, in megabytes. Larger meshes are displaced
+	 * in chunks of vertices that fit into this budget, with the same result. 0 disables chunking.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = Memory, meta = (ClampMin = "0", UIMin = "0", UIMax = "8192"))
+	int32 DisplacementBatchBudgetMB = 512;
+
+	/**
+	 * If the per-vertex normals of a displacement would exceed the batch budget, keep them in a memory-mapped scratch file in
+	 * Saved/MeshProcessingScratch, so that only the chunk of vertices that is being displaced is resident
+	 */
+	UPROPERTY(config, EditAnywhere, Category = Memory, meta = (EditCondition = "DisplacementBatchBudgetMB > 0"))
+	bool bDisplacementScratchFile = true;
+
+	/** Reduce the preview quality of the Tools while their settings are being changed, so that previews keep up with the target latency */
+	UPROPERTY(config, EditAnywhere, Category = Preview)
+	bool bAdaptivePreviewQuality = true;
+
+	/** Target time from a change of the Tool settings until the preview is updated, in milliseconds */
+	UPROPERTY(config, EditAnywhere, Category = Preview, meta = (ClampMin = "1", UIMin = "8", UIMax = "500", EditCondition = "bAdaptivePreviewQuality"))
+	int32 TargetPreviewLatencyMs = 33;
+
+	/** The preview is recomputed at full quality once the Tool settings have not changed for this many seconds */
+	UPROPERTY(config, EditAnywhere, Category = Preview, meta = (ClampMin = "0", UIMin = "0", UIMax = "5", EditCondition = "bAdaptivePreviewQuality"))
+	float FullQualityIdleSeconds = 0.5f;
+
+	/** Number of threads that run the Tool background computes. 0 uses half of the logical cores. */
+	UPROPERTY(config, EditAnywhere, Category = Threading, meta = (ClampMin = "0", UIMin = "0", UIMax = "64", ConfigRestartRequired = "true"))
+	int32 ComputePoolMaxThreads = 0;
+
+	/** Thread priority of the Tool background computes, below normal keeps the editor responsive while Tools are busy */
+	UPROPERTY(config, EditAnywhere, Category = Threading, meta = (ConfigRestartRequired = "true"))
+	EMeshProcessingComputePriority ComputePoolPriority = EMeshProcessingComputePriority::BelowNormal;
+
+	/** Mask of the cores that the Tool background computes may run on. 0 allows all cores. */
+	UPROPERTY(config, EditAnywhere, Category = Threading, AdvancedDisplay, meta = (ConfigRestartRequired = "true"))
+	int64 ComputePoolAffinityMask = 0;
+
+	/** Maximum number of worker processes that execute out-of-process operations concurrently. Workers are started on first use. */
+	UPROPERTY(config, EditAnywhere, Category = WorkerProcesses, meta = (ClampMin = "1", UIMin = "1", UIMax = "16"))
+	int32 WorkerProcessCount = 2;
+
+	/** An out-of-process operation that takes longer than this many seconds is abandoned, and its worker process terminated. 0 for no limit. */
+	UPROPERTY(config, EditAnywhere, Category = WorkerProcesses, meta = (ClampMin = "0", UIMin = "0", UIMax = "3600"))
+	float WorkerProcessTimeoutSeconds = 300.0f;
+
+	uint64 GetOperatorMemoryLimit() const { return (uint64)FMath::Max(64, OperatorMemoryLimitMB) * 1024 * 1024; }
+};
@@ -0,0 +1,90 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+struct FHitResult;
+
+
+/**
+ * FActorBoundsTree is a bounding-volume hierarchy over the world-space bounds of the visible Actors
+ * in a World that have primitive components. It is used to accelerate ray hit tests in dense levels,
+ * where only the Actors whose bounds are hit by the ray need to be traced individually.
+ *
+ * The tree is updated incrementally: a moved Actor refits the bounds of its leaf and the leaf's ancestors,
+ * new Actors are kept in a linear list until there are enough of them to justify a rebuild, and deleted
+ * Actors are skipped until the next rebuild. The tree is not thread-safe and should only be used on the game thread.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FActorBoundsTree
+{
+public:
+	/** Maximum number of Actors in each leaf */
+	int32 LeafSize = 8;
+
+	/** The tree is rebuilt when the number of Actors added since the last build exceeds this count */
+	int32 MaxUnsortedActors = 256;
+
+	/** Build the tree from all the valid Actors in World */
+	void Build(UWorld* World);
+
+	void Reset();
+
+	bool IsBuilt() const { return bBuilt; }
+
+	/** Update the bounds of an Actor that moved, or add it if it is not in the tree yet */
+	void UpdateActor(AActor* Actor);
+
+	/** Remove an Actor from the tree */
+	void RemoveActor(AActor* Actor);
+
+	/**
+	 * Find the nearest hit of the ray against the Actors in the tree. The ray is traced against the
+	 * collision of each Actor whose bounds are hit, in order of distance along the ray.
+	 * @return true if an Actor was hit
+	 */
+	bool FindNearestHit(const FRay& Ray, double MaxDistance, FHitResult& HitOut) const;
+
+	int32 GetNumActors() const { return ActorToEntry.Num(); }
+
+protected:
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		FBox Bounds;
+		int32 Leaf = -1;		// -1 for unsorted entries
+		bool bRemoved = false;
+	};
+	TArray<FEntry> Entries;
+	TMap<const AActor*, int32> ActorToEntry;
+
+	struct FNode
+	{
+		FBox Bounds;
+		int32 Parent = -1;
+		int32 Children[2] = { -1, -1 };
+		// range of EntryIndices for leaf nodes
+		int32 First = 0;
+		int32 Count = 0;
+
+		bool IsLeaf() const { return Children[0] < 0; }
+	};
+	TArray<FNode> Nodes;
+	TArray<int32> EntryIndices;
+	TArray<int32> UnsortedEntries;
+
+	TWeakObjectPtr<UWorld> World;
+	bool bBuilt = false;
+
+	static bool IsValidActor(const AActor* Actor);
+	static bool GetActorBounds(const AActor* Actor, FBox& BoundsOut);
+
+	void Rebuild();
+	int32 BuildNode(int32 Parent, int32 First, int32 Count);
+	void RefitFromLeaf(int32 LeafIndex);
+
+	bool TestEntry(const FEntry& Entry, const FRay& Ray, double& NearestDistance, FHitResult& HitOut) const;
+};
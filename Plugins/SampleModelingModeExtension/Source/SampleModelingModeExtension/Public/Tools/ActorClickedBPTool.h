@@ -6,8 +6,14 @@
 #include "CoreMinimal.h"
 #include "BaseTools/SingleClickTool.h"
 #include "GameFramework/Actor.h"
+#include "Engine/HitResult.h"
+#include "Spatial/ActorBoundsTree.h"
 #include "ActorClickedBPTool.generated.h"
 
+class URectangleMarqueeMechanic;
+struct FCameraRectangle;
+class UActorClickedBPTool;
+
 /**
  * UActorClickedBPToolOperation is intended to be used as a basis for Blueprints
  * that can process an Actor, which can then be configured as the BP operation in
@@ -35,6 +41,40 @@ public:
 	/** Blueprint to execute on Actor click */
 	UPROPERTY(EditAnywhere, Category = Options)
 	TSubclassOf<UActorClickedBPToolOperation> Operation;
+
+	/** If enabled, click-dragging a rectangle applies the Blueprint to all Actors inside it, instead of single clicks */
+	UPROPERTY(EditAnywhere, Category = Batch)
+	bool bMarqueeSelect = false;
+
+	/** Maximum time spent applying the Blueprint to Actors in each frame while a batch is running, in milliseconds */
+	UPROPERTY(EditAnywhere, Category = Batch, meta = (UIMin = "1", UIMax = "100", ClampMin = "0.1", ClampMax = "1000"))
+	float FrameBudgetMs = 10.0f;
+
+	/** If enabled, the Tool keeps its own bounding-volume hierarchy over the visible Actors to speed up click hit tests in dense levels */
+	UPROPERTY(EditAnywhere, Category = Performance)
+	bool bUseAccelerationTree = false;
+};
+
+
+/**
+ * Batch actions for a UActorClickedBPTool
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UActorClickedBPToolBatchActions : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+public:
+	TWeakObjectPtr<UActorClickedBPTool> ParentTool;
+
+	void Initialize(UActorClickedBPTool* ParentToolIn) { ParentTool = ParentToolIn; }
+
+	/** Apply the Blueprint to all Actors that were selected when the Tool was started */
+	UFUNCTION(CallInEditor, Category = Batch, meta = (DisplayPriority = 1))
+	void ApplyToSelection();
+
+	/** Stop the running batch. Actors that were already processed keep their changes, which can be undone as a single transaction. */
+	UFUNCTION(CallInEditor, Category = Batch, meta = (DisplayPriority = 2))
+	void CancelBatch();
 };
 
 
@@ -42,6 +82,10 @@ public:
  * UActorClickedBPTool is a Tool that executes an arbitrary Blueprint when an Actor in the active
  * level is clicked with the cursor. The Blueprint must be a subclass of UActorClickedBPToolOperation,
  * and is configured via the UActorClickedBPToolProperties.
+ *
+ * The Blueprint can also be applied to many Actors at once, either the Actors that were selected when
+ * the Tool started or the Actors inside a marquee rectangle. A batch reuses a single Operation instance,
+ * is spread over multiple frames with a per-frame time budget, and is recorded as a single transaction.
  */
 UCLASS()
 class SAMPLEMODELINGMODEEXTENSION_API UActorClickedBPTool : public USingleClickTool
@@ -49,16 +93,82 @@ class SAMPLEMODELINGMODEEXTENSION_API UActorClickedBPTool : public USingleClickT
 	GENERATED_BODY()
 
 public:
+	virtual void SetWorld(UWorld* World);
+	virtual void SetInitialSelection(const TArray<AActor*>& Actors);
+
 	virtual void Setup() override;
 	virtual void Shutdown(EToolShutdownType ShutdownType) override;
+	virtual void OnTick(float DeltaTime) override;
+	virtual void Render(IToolsContextRenderAPI* RenderAPI) override;
+	virtual void DrawHUD(FCanvas* Canvas, IToolsContextRenderAPI* RenderAPI) override;
 
 	virtual FInputRayHit IsHitByClick(const FInputDeviceRay& ClickPos) override;
 
 	virtual void OnClicked(const FInputDeviceRay& ClickPos) override;
 
+	/** Start applying the Blueprint to the given Actors over the next frames. Ignored if a batch is already running. */
+	void StartBatch(const TArray<AActor*>& Actors);
+	/** Stop the running batch, if any */
+	void CancelBatch();
+
+	bool IsBatchRunning() const { return bBatchRunning; }
+
+	void RequestAction_ApplyToSelection();
+
 public:
 	UPROPERTY()
 	TObjectPtr<UActorClickedBPToolProperties> PropertySet;
+
+	UPROPERTY()
+	TObjectPtr<UActorClickedBPToolBatchActions> BatchActions;
+
+protected:
+	TWeakObjectPtr<UWorld> TargetWorld;
+
+	TArray<TWeakObjectPtr<AActor>> InitialSelection;
+
+	UPROPERTY()
+	TObjectPtr<URectangleMarqueeMechanic> MarqueeMechanic;
+
+	// the Operation instance is reused for all clicks and batches, until the Operation type changes
+	UPROPERTY()
+	TObjectPtr<UActorClickedBPToolOperation> OperationInstance;
+
+	UActorClickedBPToolOperation* GetOperationInstance();
+
+	// the hit test result for the last ray is cached, as IsHitByClick() and OnClicked() query the same ray. The cache is
+	// invalidated every tick, after each click, and on Actor changes and undo/redo, so it never outlives a single click.
+	struct FCachedHit
+	{
+		bool bValid = false;
+		FRay Ray;
+		bool bHit = false;
+		FHitResult Hit;
+	};
+	FCachedHit CachedHit;
+
+	FActorBoundsTree ActorTree;
+
+	bool FindHit(const FRay& WorldRay, FHitResult& HitOut);
+	void InvalidateHitCache() { CachedHit.bValid = false; }
+
+	FDelegateHandle OnActorMovedHandle;
+	FDelegateHandle OnActorAddedHandle;
+	FDelegateHandle OnActorDeletedHandle;
+	FDelegateHandle OnPostUndoRedoHandle;
+	void OnActorChanged(AActor* Actor);
+	void OnActorDeleted(AActor* Actor);
+	void UpdateAccelerationTree();
+
+	void OnMarqueeRectangleFinished(const FCameraRectangle& Rectangle, bool bCancelled);
+
+	// batch state
+	bool bBatchRunning = false;
+	TArray<TWeakObjectPtr<AActor>> BatchActors;
+	int32 BatchIndex = 0;
+
+	void EndBatch(bool bCancelled);
+	void UpdateBatchMessage();
 };
 
 
@@ -69,5 +179,6 @@ class SAMPLEMODELINGMODEEXTENSION_API UActorClickedBPToolBuilder : public UInter
 	GENERATED_BODY()
 public:
 	virtual bool CanBuildTool(const FToolBuilderState& SceneState) const override { return true; }
+	// the Actor selection is passed to the Tool, for batch processing
 	virtual UInteractiveTool* BuildTool(const FToolBuilderState& SceneState) const override;
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractiveToolBuilder.h"
+#include "BaseTools/MultiSelectionTool.h"
+#include "Operations/MeshProcessingOperator.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Tools/ToolInputMeshCache.h"
+#include "BaseMultiMeshProcessingTool.generated.h"
+
+class UMeshProcessingPreview;
+class UBaseMultiMeshProcessingTool;
+
+
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UBaseMultiMeshProcessingToolBuilder : public UInteractiveToolWithToolTargetsBuilder
+{
+	GENERATED_BODY()
+public:
+	virtual bool CanBuildTool(const FToolBuilderState& SceneState) const override;
+	virtual UInteractiveTool* BuildTool(const FToolBuilderState& SceneState) const override;
+
+	// subclasses must implement this to create the specific Tool type
+	virtual UBaseMultiMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const
+	{
+		check(false);
+		return nullptr;
+	}
+
+protected:
+	virtual const FToolTargetTypeRequirements& GetTargetRequirements() const override;
+};
+
+
+
+/**
+ * Settings for processing multiple selected meshes in a UBaseMultiMeshProcessingTool
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UMultiMeshProcessingProperties : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+public:
+	/** Maximum number of target meshes that are computed concurrently in the background */
+	UPROPERTY(EditAnywhere, Category = MultipleTargets, meta = (UIMin = "1", UIMax = "32", ClampMin = "1", ClampMax = "512"))
+	int MaxConcurrentComputes = 8;
+};
+
+
+
+/**
+ * UBaseMultiMeshProcessingTool is a base Tool for mesh processing operations that are applied
+ * independently to each selected mesh. It provides the same API to subclasses as UBaseMeshProcessingTool,
+ * except that operators are created per target. Each target has its own background-compute preview, so
+ * previews update as each target finishes, and the number of concurrent computes is limited by
+ * UMultiMeshProcessingProperties::MaxConcurrentComputes. On Accept, all targets are updated in a single transaction.
+ *
+ * Each target has a FOperatorGenerationCounter that is advanced when its result is invalidated. Operators
+ * created by the subclass use it to exit early once superseded, and late results are discarded without
+ * updating the preview.
+ *
+ * The estimated peak memory of all running computes is limited by USampleModelingModeExtensionSettings.
+ * A compute that does not fit next to the running computes waits for them to finish, and a compute that
+ * exceeds the limit on its own is downgraded (see FMeshProcessingOperator::Downgrade()) or refused.
+ * The current and peak operator memory is shown in the Tool message area.
+ *
+ * The initial meshes and normals are taken from the FToolInputMeshCache, so that switching between Tools on the
+ * same assets does not convert them again. Meshes that are not cached are converted in the background: the Tool
+ * property sets (and eg Gizmos) are initialized immediately, the source objects stay visible while their input
+ * is loading, and the first compute of each target starts once its input is ready.
+ *
+ * If HasMeshTopologyChanged() is false, results on Static Mesh targets are committed with a FMeshVertexDeltaChange,
+ * so that the undo history only records the compressed change of the vertex positions and normals.
+ *
+ * While the Tool settings are being changed, a quality governor measures the preview latency and reduces the preview
+ * quality in steps defined by the subclass (see GetMaxPreviewQualityReduction()) to hold the target latency of
+ * USampleModelingModeExtensionSettings. Full quality is restored once the settings are idle, and on Accept.
+ *
+ * Subclasses can produce each result progressively, in refinement levels (see GetNumRefinementLevels()). The
+ * compute of a level starts once the previous level is shown, and invalidating the result restarts at level 0.
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UBaseMultiMeshProcessingTool : public UMultiSelectionTool
+{
+	GENERATED_BODY()
+
+public:
+	virtual void SetWorld(UWorld* World);
+
+	// UInteractiveTool API
+
+	virtual void Setup() override;
+	virtual void Shutdown(EToolShutdownType ShutdownType) override;
+	virtual void OnTick(float DeltaTime) override;
+
+	virtual bool HasCancel() const override { return true; }
+	virtual bool HasAccept() const override { return true; }
+	virtual bool CanAccept() const override;
+
+	/** @return number of operators that exited early because they were superseded, over all targets */
+	int64 GetNumStaleOperatorExits() const;
+	/** @return number of operator results that were discarded because they were superseded, over all targets */
+	int64 GetNumDiscardedResults() const;
+
+	/** @return memory currently tracked by the running computes, in bytes */
+	uint64 GetCurrentOperatorMemory() const;
+	/** @return peak of GetCurrentOperatorMemory() since the Tool started, in bytes */
+	uint64 GetPeakOperatorMemory() const { return PeakOperatorMemory; }
+
+protected:
+	// UBaseMultiMeshProcessingTool API - subclasses implement these
+
+	// create and register the Tool property sets. This is called before the initial meshes are ready, see IsInputReady()
+	virtual void InitializeProperties() {}
+	// called when the initial mesh of a target has become available
+	virtual void OnInputReady(int32 TargetIndex) {}
+	// called at the start of Shutdown(), before the previews are shut down
+	virtual void OnShutdown(EToolShutdownType ShutdownType) {}
+	// called when the result of an operator has been applied to the preview of a target
+	virtual void OnOperatorCompleted(int32 TargetIndex, const UE::Geometry::FMeshProcessingOperator* Operator) {}
+
+	// create a new operator for the given target, called on the Game Thread. The generation counter is set by the base class.
+	virtual TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeNewOperator(int32 TargetIndex)
+	{
+		check(false);
+		return nullptr;
+	}
+
+	// return the memory that the Tool keeps between computes for later operators (eg cached intermediate results), in bytes.
+	// It is counted against the operator memory limit, and released by ReleaseRetainedMemory() before a compute is downgraded or refused.
+	virtual uint64 GetRetainedMemory() const { return 0; }
+	virtual void ReleaseRetainedMemory() {}
+
+	// called on the game thread while a final compute runs on the compute pool on Accept, eg to execute work that the
+	// operator has queued for the game thread, as the Tool is no longer ticked
+	virtual void TickFinalCompute() {}
+
+	virtual bool RequiresInitialVtxNormals() const { return false; }
+	virtual bool HasMeshTopologyChanged() const { return true; }
+
+	// return true if the previews are computed at reduced quality, in which case the results are recomputed
+	// on Accept with operators created while IsFinalCompute() is true
+	virtual bool RequiresFinalCompute() const { return false; }
+
+	// return the number of progressively refined results of a target (eg increasing subdivision levels),
+	// MakeNewOperator() creates the operator for GetRefinementLevel(). Only the last level can be accepted.
+	virtual int32 GetNumRefinementLevels(int32 TargetIndex) const { return 1; }
+
+	// return the number of steps by which the preview quality can be reduced, MakeNewOperator() creates the operator for
+	// GetPreviewQualityReduction(). Results computed at reduced quality are recomputed at full quality on Accept.
+	virtual int32 GetMaxPreviewQualityReduction() const { return 0; }
+	// return a short description of the preview quality at the given reduction, for the Tool message
+	virtual FText GetPreviewQualityDescription(int32 QualityReduction) const;
+
+	virtual FText GetToolMessageString() const { return FText::GetEmpty(); }
+	virtual FText GetAcceptTransactionName() const;
+
+protected:
+	// helper functions for subclasses
+
+	// recompute the result for all targets
+	void InvalidateResult();
+	// recompute the result for a single target
+	void InvalidateResult(int32 TargetIndex);
+
+	int32 GetNumTargets() const { return ProcessingTargets.Num(); }
+	// @return true while operators are created for the final results on Accept
+	bool IsFinalCompute() const { return bFinalCompute; }
+	// @return the current reduction of the preview quality, or 0 for full quality (always during the final compute on Accept)
+	int32 GetPreviewQualityReduction() const;
+	// @return the operator memory limit from the settings, less GetRetainedMemory()
+	uint64 GetOperatorMemoryLimit() const;
+	// @return the refinement level that is computed next for the target, see GetNumRefinementLevels()
+	int32 GetRefinementLevel(int32 TargetIndex) const { return ProcessingTargets[TargetIndex].RefinementLevel; }
+	// @return true if the initial mesh (and normals) of the target have been loaded. The functions below are only valid for ready targets.
+	bool IsInputReady(int32 TargetIndex) const { return ProcessingTargets[TargetIndex].InitialMesh.IsValid(); }
+	// @return true if the initial meshes of all targets have been loaded
+	bool AreAllInputsReady() const;
+	const UE::Geometry::FDynamicMesh3& GetInitialMesh(int32 TargetIndex) const { return *ProcessingTargets[TargetIndex].InitialMesh; }
+	// the initial mesh is shared with operators, which copy it on the background thread
+	TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> GetSharedInitialMesh(int32 TargetIndex) const { return ProcessingTargets[TargetIndex].InitialMesh; }
+	const FTransform3d& GetPreviewTransform(int32 TargetIndex) const { return ProcessingTargets[TargetIndex].Transform; }
+	// the initial normals are shared with operators and other Tools, and must not be modified
+	TSharedPtr<const UE::Geometry::FMeshNormals, ESPMode::ThreadSafe> GetInitialVtxNormals(int32 TargetIndex) const { return ProcessingTargets[TargetIndex].InitialVtxNormals; }
+
+	// @return world-space bounding box of all the initial target meshes. The component bounds are used for targets that are not ready yet.
+	UE::Geometry::FAxisAlignedBox3d GetCombinedWorldBounds() const;
+
+protected:
+	UPROPERTY()
+	TArray<TObjectPtr<UMeshProcessingPreview>> Previews;
+
+	UPROPERTY()
+	TObjectPtr<UMultiMeshProcessingProperties> MultiMeshProperties = nullptr;
+
+	TWeakObjectPtr<UWorld> TargetWorld;
+
+	struct FProcessingTarget
+	{
+		// shared with the FToolInputMeshCache
+		TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> InitialMesh;
+		TSharedPtr<const UE::Geometry::FMeshNormals, ESPMode::ThreadSafe> InitialVtxNormals;
+		FTransform3d Transform;
+		// initial mesh that is being loaded in the background
+		TFuture<FToolInputMeshCache::FInput> PendingInput;
+
+		TSharedPtr<UE::Geometry::FOperatorGenerationCounter, ESPMode::ThreadSafe> Generation;
+
+		// a recompute has been requested but not started yet
+		bool bComputePending = false;
+		// refinement level of the pending or running compute
+		int32 RefinementLevel = 0;
+		// preview quality reduction of the last created operator, and of the shown result
+		int32 ComputeQualityReduction = 0;
+		int32 ResultQualityReduction = 0;
+		// the last requested compute exceeded the memory limit and was not started
+		bool bComputeRefused = false;
+		// operator created for a pending compute that is waiting for memory to become available
+		TUniquePtr<UE::Geometry::FMeshProcessingOperator> DeferredOperator;
+	};
+	TArray<FProcessingTarget> ProcessingTargets;
+
+	void InitializeProcessingTarget(int32 TargetIndex);
+	void InitializePreview(int32 TargetIndex);
+
+	// take the initial meshes that have finished loading, and show their previews
+	void UpdatePendingInputs();
+	int32 DisplayedNumLoading = -1;
+
+	// start pending computes, up to the concurrency and memory limits
+	void UpdatePendingComputes();
+
+	enum class EStartComputeResult
+	{
+		Started,
+		Deferred,
+		Refused,
+		// MakeNewOperator() returned no operator
+		Skipped
+	};
+	EStartComputeResult StartCompute(int32 TargetIndex, uint64 AvailableMemory);
+
+	// show the failed, refused or downgraded compute warning, if it differs from the one already shown
+	void DisplayComputeWarning(const FText& Message);
+	FText DisplayedComputeWarning;
+
+	// commit a topology-preserving result as a FMeshVertexDeltaChange. @return false if not possible, the result must then be committed in full
+	bool CommitVertexDeltaUpdate(int32 TargetIndex, const UE::Geometry::FDynamicMesh3& Result);
+
+	// quality governor state, see GetPreviewQualityReduction()
+	int32 QualityReduction = 0;
+	double SmoothedLatency = 0;
+	double LastLatency = 0;
+	double LastInteractionTime = 0;
+	bool bIdleFullQuality = false;
+	// set while the Tool itself invalidates the result, which is not an interaction
+	bool bInternalInvalidate = false;
+	// adapt the quality reduction to the latency of a completed compute
+	void UpdateQualityGovernor(double ComputeSeconds);
+	// recompute at full quality once the settings are idle
+	void UpdateIdleFullQuality();
+	bool HaveReducedQualityResults() const;
+
+	bool bFinalCompute = false;
+	// recompute the results of all targets at full quality on Accept, one at a time on the compute pool behind a cancellable progress
+	// dialog. Results that would exceed the memory limit, fail, or are cancelled keep the preview result.
+	void ComputeFinalResults(TArray<TUniquePtr<UE::Geometry::FDynamicMesh3>>& Results);
+
+	uint64 PeakOperatorMemory = 0;
+	uint64 DisplayedCurrentMemoryMB = MAX_uint64;
+	uint64 DisplayedPeakMemoryMB = MAX_uint64;
+	int32 DisplayedQualityReduction = -1;
+	int32 DisplayedLatencyMs = -1;
+	void UpdateMemoryMessage(bool bForce = false);
+};
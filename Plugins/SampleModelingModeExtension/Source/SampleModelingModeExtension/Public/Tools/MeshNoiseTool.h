@@ -4,7 +4,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "BaseTools/BaseMeshProcessingTool.h"
+#include "Tools/BaseMultiMeshProcessingTool.h"
+#include "Operations/MeshNoiseOp.h"
 #include "MeshNoiseTool.generated.h"
 
 
@@ -16,6 +17,20 @@ enum class EMeshNoiseToolNoiseType : uint8
 };
 
 
+UENUM()
+enum class EMeshNoiseToolMaskType : uint8
+{
+	/** Displace the whole mesh */
+	None,
+	/** Displace the vertices inside a box */
+	Volume,
+	/** Displace the vertices of the triangles in a PolyGroup */
+	PolyGroup,
+	/** Scale the displacement by a vertex weight map of the mesh */
+	WeightLayer
+};
+
+
 UCLASS()
 class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseProperties : public UInteractiveToolPropertySet
 {
@@ -41,6 +56,65 @@ public:
 	UPROPERTY(EditAnywhere, Category = Noise, meta = (UIMin = "0", ClampMin = "0", EditCondition = "NoiseType == EMeshNoiseToolNoiseType::Random"))
 	int Seed = 10;
 
+	/** Compute the preview in single precision, which is faster on large meshes. The result is recomputed in double precision on Accept. */
+	UPROPERTY(EditAnywhere, Category = Performance)
+	bool bFastPreview = false;
+
+	/**
+	 * Show the result at each subdivision level up to Subdivisions while the requested level is computed. The tessellation
+	 * of each level is kept while the Tool is active, so that changing the noise settings only recomputes the displacement.
+	 */
+	UPROPERTY(EditAnywhere, Category = Performance)
+	bool bProgressivePreview = true;
+
+	/**
+	 * Compute the displaced normals from the gradient of the Perlin noise, instead of recomputing them from the displaced mesh.
+	 * Meshes with split normals always recompute them.
+	 */
+	UPROPERTY(EditAnywhere, Category = Performance, meta = (EditCondition = "NoiseType == EMeshNoiseToolNoiseType::Perlin"))
+	bool bAnalyticNormals = true;
+
+};
+
+
+
+/**
+ * Settings of the region of the mesh that is displaced by a UMeshNoiseTool
+ */
+UCLASS()
+class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseMaskProperties : public UInteractiveToolPropertySet
+{
+	GENERATED_BODY()
+public:
+	/** Limit the displacement to a region of the mesh. Only the region and the blend rings around it are displaced and get new normals. */
+	UPROPERTY(EditAnywhere, Category = Mask)
+	EMeshNoiseToolMaskType MaskType = EMeshNoiseToolMaskType::None;
+
+	/** Center of the mask box, in world space */
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (TransientToolProperty, EditCondition = "MaskType == EMeshNoiseToolMaskType::Volume", EditConditionHides))
+	FVector VolumeCenter = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (TransientToolProperty, EditCondition = "MaskType == EMeshNoiseToolMaskType::Volume", EditConditionHides))
+	FRotator VolumeRotation = FRotator::ZeroRotator;
+
+	/** Half-size of the mask box along each of its axes */
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (TransientToolProperty, ClampMin = "0", EditCondition = "MaskType == EMeshNoiseToolMaskType::Volume", EditConditionHides))
+	FVector VolumeExtents = FVector(50.0, 50.0, 50.0);
+
+	/** Distance outside the mask box over which the displacement fades out */
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (UIMin = "0", UIMax = "100", ClampMin = "0", EditCondition = "MaskType == EMeshNoiseToolMaskType::Volume", EditConditionHides))
+	float VolumeFalloff = 10.0f;
+
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (ClampMin = "0", EditCondition = "MaskType == EMeshNoiseToolMaskType::PolyGroup", EditConditionHides))
+	int PolyGroupID = 0;
+
+	/** Index of the vertex weight map of the mesh */
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (ClampMin = "0", EditCondition = "MaskType == EMeshNoiseToolMaskType::WeightLayer", EditConditionHides))
+	int WeightLayer = 0;
+
+	/** Number of vertex rings around the masked region over which the displacement fades out */
+	UPROPERTY(EditAnywhere, Category = Mask, meta = (UIMin = "0", UIMax = "8", ClampMin = "0", ClampMax = "64", EditCondition = "MaskType != EMeshNoiseToolMaskType::None"))
+	int BlendRings = 2;
 };
 
 
@@ -49,45 +123,73 @@ public:
  * UMeshNoiseTool applies PN Tessellation and Perlin or Random noise to an input Mesh
  */
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseTool : public UBaseMeshProcessingTool
+class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseTool : public UBaseMultiMeshProcessingTool
 {
 	GENERATED_BODY()
 
 public:
 	UMeshNoiseTool();
 
+	/** Convert the Tool settings to operator options, this is also used to run the operator outside of the Tool (eg in commandlets) */
+	static UE::Geometry::FMeshNoiseOp::FOptions MakeOperatorOptions(const UMeshNoiseProperties* Properties);
+	static UE::Geometry::FMeshNoiseOp::FMaskOptions MakeMaskOptions(const UMeshNoiseMaskProperties* Properties);
+
 protected:
-	// UBaseMeshProcessingTool API implementation
+	// UBaseMultiMeshProcessingTool API implementation
 
 	virtual void InitializeProperties() override;
 	virtual void OnShutdown(EToolShutdownType ShutdownType) override;
+	virtual void OnOperatorCompleted(int32 TargetIndex, const UE::Geometry::FMeshProcessingOperator* Operator) override;
+	virtual void OnPropertyModified(UObject* PropertySet, FProperty* Property) override;
 
-	virtual TUniquePtr<UE::Geometry::FDynamicMeshOperator> MakeNewOperator() override;
+	virtual TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeNewOperator(int32 TargetIndex) override;
+	virtual uint64 GetRetainedMemory() const override;
+	virtual void ReleaseRetainedMemory() override;
 
-	virtual bool RequiresInitialVtxNormals() const { return true; }
+	virtual bool RequiresInitialVtxNormals() const override { return true; }
 	virtual bool HasMeshTopologyChanged() const override;
+	virtual bool RequiresFinalCompute() const override;
+	virtual int32 GetNumRefinementLevels(int32 TargetIndex) const override;
+	virtual int32 GetMaxPreviewQualityReduction() const override;
+	virtual FText GetPreviewQualityDescription(int32 QualityReduction) const override;
 
 	virtual FText GetToolMessageString() const override;
 	virtual FText GetAcceptTransactionName() const override;
 
-	// disable scaling to unit dimensions, this is a feature of UBaseMeshProcessingTool that is enabled by default
-	virtual bool RequiresScaleNormalization() const { return false; }
-
 protected:
 	//  settings for this Tool that will be exposed in Modeling Mode details panel
 	UPROPERTY()
 	TObjectPtr<UMeshNoiseProperties> NoiseProperties = nullptr;
+
+	UPROPERTY()
+	TObjectPtr<UMeshNoiseMaskProperties> MaskProperties = nullptr;
+
+	// tessellations of each target kept by progressive previews, at most two per target: the level of the last completed
+	// operator, and the level after it that the refinement computes next. These count against the operator memory limit.
+	TArray<TArray<UE::Geometry::FMeshNoiseOp::FTessellation, TFixedAllocator<2>>> TessellationCache;
+	// release the tessellations that can no longer be used with the current settings
+	void TrimTessellationCache();
+	// @return the cached tessellation of the target at the given level, or null
+	const UE::Geometry::FMeshNoiseOp::FTessellation* FindCachedTessellation(int32 TargetIndex, int32 Subdivisions) const;
+
+	// content hash of each target mesh for the FTessellationDiskCache, 0 until an operator has computed it
+	TArray<uint64> InputMeshHashes;
+
+	// Preview quality reductions first switch the displacement to single precision (unless bFastPreview already does),
+	// and then remove one subdivision level each. These return the preview settings for a quality reduction.
+	bool IsSinglePrecisionPreview(int32 QualityReduction) const;
+	int32 GetPreviewSubdivisions(int32 QualityReduction) const;
 };
 
 
 
 
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseToolBuilder : public UBaseMeshProcessingToolBuilder
+class SAMPLEMODELINGMODEEXTENSION_API UMeshNoiseToolBuilder : public UBaseMultiMeshProcessingToolBuilder
 {
 	GENERATED_BODY()
 public:
-	virtual UBaseMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
+	virtual UBaseMultiMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
 	{
 		return NewObject<UMeshNoiseTool>(Outer);
 	}
@@ -4,7 +4,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "BaseTools/BaseMeshProcessingTool.h"
+#include "Tools/BaseMultiMeshProcessingTool.h"
 #include "MeshPlaneCutTool.generated.h"
 
 class UCombinedTransformGizmo;
@@ -34,7 +34,7 @@ public:
  * positioning the plane.
  */
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshPlaneCutTool : public UBaseMeshProcessingTool
+class SAMPLEMODELINGMODEEXTENSION_API UMeshPlaneCutTool : public UBaseMultiMeshProcessingTool
 {
 	GENERATED_BODY()
 
@@ -42,24 +42,24 @@ public:
 	UMeshPlaneCutTool();
 
 protected:
-	// UBaseMeshProcessingTool API implementation
+	// UBaseMultiMeshProcessingTool API implementation
 
 	virtual void InitializeProperties() override;
 	virtual void OnShutdown(EToolShutdownType ShutdownType) override;
 
-	virtual TUniquePtr<UE::Geometry::FDynamicMeshOperator> MakeNewOperator() override;
+	virtual TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeNewOperator(int32 TargetIndex) override;
 
-	// Do not need vertex normals for this UBaseMeshProcessingTool
-	virtual bool RequiresInitialVtxNormals() const { return false; }
+	// Do not need vertex normals for this UBaseMultiMeshProcessingTool
+	virtual bool RequiresInitialVtxNormals() const override { return false; }
 	// If we change the mesh this must return true. Depends on what the Tool does...
 	virtual bool HasMeshTopologyChanged() const override;
+	// while the plane is being moved, the preview can skip filling the cut hole
+	virtual int32 GetMaxPreviewQualityReduction() const override;
+	virtual FText GetPreviewQualityDescription(int32 QualityReduction) const override;
 
 	virtual FText GetToolMessageString() const override;
 	virtual FText GetAcceptTransactionName() const override;
 
-	// disable scaling to unit dimensions, this is a feature of UBaseMeshProcessingTool that is enabled by default
-	virtual bool RequiresScaleNormalization() const { return false; }
-
 protected:
 	//  settings for this Tool that will be exposed in Modeling Mode details panel
 	UPROPERTY()
@@ -89,11 +89,11 @@ protected:
 
 
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshPlaneCutToolBuilder : public UBaseMeshProcessingToolBuilder
+class SAMPLEMODELINGMODEEXTENSION_API UMeshPlaneCutToolBuilder : public UBaseMultiMeshProcessingToolBuilder
 {
 	GENERATED_BODY()
 public:
-	virtual UBaseMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
+	virtual UBaseMultiMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
 	{
 		return NewObject<UMeshPlaneCutTool>(Outer);
 	}
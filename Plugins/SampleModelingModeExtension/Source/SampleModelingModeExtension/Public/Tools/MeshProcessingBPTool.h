@@ -4,7 +4,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "BaseTools/BaseMeshProcessingTool.h"
+#include "Tools/BaseMultiMeshProcessingTool.h"
+#include "Operations/MeshProcessingOperationChain.h"
+#include "Operations/MeshChunkedExecution.h"
+#include <atomic>
 #include "MeshProcessingBPTool.generated.h"
 
 class FBackgroundMeshProcessingExecutor;
@@ -55,11 +58,71 @@ public:
 	 * no calls to external UObjects or Subsystems are used, ie only basic Geometry Script 
 	 * operations are used with the TargetMesh.
 	 * 
-	 * (It's probably not a good idea to use this, it may stop working in the future!)
+	 * (It's probably not a good idea to use this, it may stop working in the future!
+	 *  Hot processing steps should be implemented as a native UMeshProcessingChainStep instead)
 	 */
 	UFUNCTION(BlueprintNativeEvent, Category = "Events")
 	bool GetEnableBackgroundExecution();
 	bool GetEnableBackgroundExecution_Implementation();
+
+	/**
+	 * Override GetIsLocalOperation in BP to indicate that the result of OnRecomputeMesh at any point of
+	 * the mesh only depends on a bounded neighbourhood of that point (eg per-vertex displacement).
+	 * Local operations that also enable background execution can be executed in parallel on spatial chunks
+	 * of the mesh, see UMeshProcessingBPToolProperties::bChunkedExecution.
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "Events")
+	bool GetIsLocalOperation();
+	bool GetIsLocalOperation_Implementation();
+};
+
+
+
+/**
+ * UMeshProcessingChainStep is the base class for an additional step in the operation chain
+ * of a UMeshProcessingBPTool. Subclasses create a native IMeshProcessingOperation, and
+ * all the steps of the chain are executed in a single background compute on a single mesh buffer.
+ */
+UCLASS(Abstract, EditInlineNew, DefaultToInstanced, CollapseCategories)
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingChainStep : public UObject
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * Create the Operation for this step. This is called on the Game Thread, and the Operation
+	 * must copy any settings it needs, as it may be executed after this step has been modified.
+	 */
+	virtual TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe> MakeOperation(const FMeshProcessingBPToolParameters& Parameters) const
+	PURE_VIRTUAL(UMeshProcessingChainStep::MakeOperation, return nullptr;);
+};
+
+
+/**
+ * Chain step that executes a UMeshProcessingBPToolOperation Blueprint. The Blueprint is
+ * executed on the Game Thread unless it enables background execution.
+ */
+UCLASS(meta = (DisplayName = "Blueprint Operation"))
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBlueprintChainStep : public UMeshProcessingChainStep
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, Category = Step)
+	TSubclassOf<UMeshProcessingBPToolOperation> Operation;
+
+	// Blueprint steps are instantiated by the UMeshProcessingBPTool, which must keep the Blueprint instance alive
+	virtual TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe> MakeOperation(const FMeshProcessingBPToolParameters& Parameters) const override { return nullptr; }
+};
+
+
+/**
+ * Native chain step that recomputes the mesh normals (overlay normals if the mesh has attributes, otherwise vertex normals)
+ */
+UCLASS(meta = (DisplayName = "Recompute Normals"))
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingRecomputeNormalsChainStep : public UMeshProcessingChainStep
+{
+	GENERATED_BODY()
+public:
+	virtual TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe> MakeOperation(const FMeshProcessingBPToolParameters& Parameters) const override;
 };
 
 
@@ -76,8 +139,35 @@ public:
 	UPROPERTY(EditAnywhere, Category = Operation)
 	TSubclassOf<UMeshProcessingBPToolOperation> Operation;
 
+	/** Additional steps executed after the Blueprint Operation, in order, in the same background compute */
+	UPROPERTY(EditAnywhere, Instanced, Category = Operation)
+	TArray<TObjectPtr<UMeshProcessingChainStep>> AdditionalSteps;
+
 	UPROPERTY(EditAnywhere, Category = Settings)
 	FMeshProcessingBPToolParameters Parameters;
+
+	/** Execute the operation chain in parallel on spatial chunks of the mesh. Only possible if all steps are thread-safe local operations. */
+	UPROPERTY(EditAnywhere, Category = ChunkedExecution)
+	bool bChunkedExecution = false;
+
+	/** Number of spatial chunks the mesh is split into */
+	UPROPERTY(EditAnywhere, Category = ChunkedExecution, meta = (UIMin = "2", UIMax = "64", ClampMin = "1", ClampMax = "256", EditCondition = "bChunkedExecution"))
+	int NumChunks = 8;
+
+	/** Number of triangle rings added around each chunk, this must cover the neighbourhood that the operations depend on */
+	UPROPERTY(EditAnywhere, Category = ChunkedExecution, meta = (UIMin = "0", UIMax = "8", ClampMin = "0", ClampMax = "64", EditCondition = "bChunkedExecution"))
+	int HaloWidth = 2;
+
+	/** Also execute the operation chain on the whole mesh and log the deviation of the chunked result (slow!) */
+	UPROPERTY(EditAnywhere, Category = ChunkedExecution, meta = (EditCondition = "bChunkedExecution"))
+	bool bValidateChunking = false;
+
+	/**
+	 * Execute the operation chain in a worker process, so that a Blueprint that crashes or hangs does not take down the editor.
+	 * The worker creates its own instances of the Blueprint and of the AdditionalSteps, with the settings of this Tool.
+	 */
+	UPROPERTY(EditAnywhere, Category = WorkerProcess)
+	bool bOutOfProcess = false;
 };
 
 
@@ -88,30 +178,69 @@ public:
  * and is configured via the UMeshProcessingBPToolProperties
  */
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBPTool : public UBaseMeshProcessingTool
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBPTool : public UBaseMultiMeshProcessingTool
 {
 	GENERATED_BODY()
 
 public:
 	UMeshProcessingBPTool();
 
+	/**
+	 * Create the operator this Tool uses to execute a Chain, outside of a Tool instance (eg for benchmarking).
+	 * This is only possible for thread-safe Chains that do not require a UDynamicMesh, ie native Operations.
+	 * @param ChunkOptions if non-null, the Chain is executed in spatial chunks
+	 */
+	static TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeNativeChainOperator(
+		const UE::Geometry::FMeshProcessingOperationChain& Chain,
+		const UE::Geometry::FMeshChunkedExecutionOptions* ChunkOptions = nullptr);
+
+	/**
+	 * Append the Operations configured in Properties to Chain, ie the Blueprint Operation followed by the AdditionalSteps.
+	 * @param MakeBlueprintOperationFunc creates the chain Operation for each Blueprint Operation type
+	 */
+	static void BuildOperationChain(const UMeshProcessingBPToolProperties* Properties,
+		TFunctionRef<TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe>(TSubclassOf<UMeshProcessingBPToolOperation>)> MakeBlueprintOperationFunc,
+		UE::Geometry::FMeshProcessingOperationChain& Chain);
+
+	/**
+	 * Wrap an instance of a Blueprint Operation as a chain Operation, outside of a Tool instance.
+	 * The caller must keep OperationInstance alive until the returned Operation is destroyed.
+	 */
+	static TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe> MakeBlueprintChainOperation(
+		UMeshProcessingBPToolOperation* OperationInstance, const FMeshProcessingBPToolParameters& Parameters);
+
 protected:
-	// UBaseMeshProcessingTool API implementation
+	// UBaseMultiMeshProcessingTool API implementation
 
 	virtual void InitializeProperties() override;
 	virtual void OnShutdown(EToolShutdownType ShutdownType) override;
 	virtual void OnTick(float DeltaTime) override;
+	virtual void TickFinalCompute() override;
 
-	virtual TUniquePtr<UE::Geometry::FDynamicMeshOperator> MakeNewOperator() override;
+	virtual TUniquePtr<UE::Geometry::FMeshProcessingOperator> MakeNewOperator(int32 TargetIndex) override;
 
-	virtual bool RequiresInitialVtxNormals() const { return false; }
+	virtual bool RequiresInitialVtxNormals() const override { return false; }
 	virtual bool HasMeshTopologyChanged() const override;
+	// the reduced-quality preview of large meshes executes the chain on a decimated proxy of the input
+	virtual int32 GetMaxPreviewQualityReduction() const override;
+	virtual FText GetPreviewQualityDescription(int32 QualityReduction) const override;
 
 	virtual FText GetToolMessageString() const override;
 	virtual FText GetAcceptTransactionName() const override;
 
-	// disable scaling to unit dimensions, this is a feature of UBaseMeshProcessingTool that is enabled by default
-	virtual bool RequiresScaleNormalization() const { return false; }
+protected:
+	// decimated proxy of each input mesh, built in the background the first time a reduced-quality preview is requested
+	struct FPreviewProxy
+	{
+		TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> Mesh;
+		TFuture<TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe>> PendingMesh;
+	};
+	TArray<FPreviewProxy> PreviewProxies;
+
+	// @return true if the input of the target is large enough to be previewed on a proxy
+	bool IsPreviewProxyTarget(int32 TargetIndex) const;
+	// @return the proxy of the target, or null if it is not built yet (which starts the build)
+	TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> GetPreviewProxy(int32 TargetIndex);
 
 protected:
 	// settings for this Tool that will be exposed in Modeling Mode details panel
@@ -122,17 +251,23 @@ protected:
 
 	// A helper class (defined in cpp) that is used to force execution of the Blueprint operation on the game thread
 	TSharedPtr<FBackgroundMeshProcessingExecutor> Executor;
+
+	// set on shutdown, so that the worker processes of out-of-process operators are terminated rather than left to finish
+	TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe> WorkerProcessAbortFlag;
+
+	// create a new instance of the Blueprint Operation class and wrap it in a chain Operation
+	TSharedPtr<UE::Geometry::IMeshProcessingOperation, ESPMode::ThreadSafe> MakeBlueprintOperation(TSubclassOf<UMeshProcessingBPToolOperation> OperationType);
 };
 
 
 
 
 UCLASS()
-class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBPToolBuilder : public UBaseMeshProcessingToolBuilder
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingBPToolBuilder : public UBaseMultiMeshProcessingToolBuilder
 {
 	GENERATED_BODY()
 public:
-	virtual UBaseMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
+	virtual UBaseMultiMeshProcessingTool* MakeNewToolInstance(UObject* Outer) const 
 	{
 		return NewObject<UMeshProcessingBPTool>(Outer);
 	}
@@ -0,0 +1,88 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Operations/MeshProcessingOperator.h"
+#include "MeshProcessingPreview.generated.h"
+
+class UPreviewMesh;
+class UMaterialInterface;
+
+
+/**
+ * UMeshProcessingPreview shows the result of a FMeshProcessingOperator that is computed in the background,
+ * similar to UMeshOpPreviewWithBackgroundCompute. The difference is that the owner starts computes explicitly,
+ * and results of cancelled, superseded or failed operators are discarded without ever touching the preview mesh.
+ */
+UCLASS(Transient)
+class SAMPLEMODELINGMODEEXTENSION_API UMeshProcessingPreview : public UObject
+{
+	GENERATED_BODY()
+public:
+	void Setup(UWorld* World, const FTransform& Transform, const TArray<UMaterialInterface*>& Materials, UMaterialInterface* WorkingMaterialIn);
+
+	/** Cancel any active compute and remove the preview from the world. @return the last valid result, if any */
+	TUniquePtr<UE::Geometry::FDynamicMesh3> Shutdown();
+
+	/** Show the given mesh as the current result, eg the input mesh before the first compute has finished */
+	void SetInitialResult(const UE::Geometry::FDynamicMesh3& Mesh);
+
+	void SetVisibility(bool bVisible);
+
+	/**
+	 * Start computing Operator in the background, any active compute is cancelled
+	 * @param bShowWorkingMaterial if false, the previous result stays visible while computing (eg when refining it), instead of switching to the working material
+	 */
+	void StartCompute(TUniquePtr<UE::Geometry::FMeshProcessingOperator> Operator, bool bShowWorkingMaterial = true);
+
+	/** Cancel the active compute, if any. The preview keeps showing the previous result. */
+	void CancelCompute();
+
+	/** Poll for a completed compute and update the preview mesh. Must be called every tick. */
+	void Tick(float DeltaTime);
+
+	bool IsComputing() const { return ActiveCompute.IsValid(); }
+
+	/** @return peak memory estimate of the active compute, in bytes, or 0 if there is none */
+	uint64 GetActiveComputeEstimatedMemory() const;
+	/** @return memory currently tracked by the active compute, in bytes, or 0 if there is none */
+	uint64 GetActiveComputeCurrentMemory() const;
+
+	/** @return true if the preview shows the result of the last started compute */
+	bool HaveValidResult() const { return bResultValid; }
+
+	const UE::Geometry::FDynamicMesh3* GetResultMesh() const { return ResultMesh.Get(); }
+
+	/** @return time from the start of the last applied compute until its result was applied, in seconds */
+	double GetLastComputeSeconds() const { return LastComputeSeconds; }
+
+	/** Broadcast when the result of a compute has been applied to the preview */
+	TMulticastDelegate<void(const UE::Geometry::FMeshProcessingOperator*)> OnOpCompleted;
+
+	/** Broadcast when a completed compute was discarded because it was superseded, cancelled or failed. The preview keeps showing the last valid result. */
+	TMulticastDelegate<void(const UE::Geometry::FMeshProcessingOperator*)> OnOpDiscarded;
+
+	/** The working material is shown after a compute has been active for this many seconds */
+	float WorkingMaterialDelay = 0.5f;
+
+public:
+	UPROPERTY()
+	TObjectPtr<UPreviewMesh> PreviewMesh;
+
+	UPROPERTY()
+	TObjectPtr<UMaterialInterface> WorkingMaterial;
+
+protected:
+	struct FActiveCompute;
+	TSharedPtr<FActiveCompute, ESPMode::ThreadSafe> ActiveCompute;
+
+	TUniquePtr<UE::Geometry::FDynamicMesh3> ResultMesh;
+	bool bResultValid = false;
+	bool bShowingWorkingMaterial = false;
+	double LastComputeSeconds = 0;
+
+	void SetShowingWorkingMaterial(bool bShow);
+};
@@ -0,0 +1,57 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InteractiveToolChange.h"
+#include "DynamicMesh/DynamicMesh3.h"
+
+class UStaticMesh;
+class UInteractiveToolManager;
+struct FMeshDescription;
+
+
+/**
+ * FMeshVertexDeltaChange is an undo record for an update of the LOD0 source MeshDescription of a Static Mesh that
+ * only modified its vertex positions and vertex instance normals/tangents, eg by a displacement Tool.
+ *
+ * Instead of the full MeshDescription (as recorded by UStaticMesh::Modify()), the change stores the XOR of the float
+ * bits of the values before and after the update. Positions that moved by a small amount mostly share their sign,
+ * exponent and high mantissa bits, so the XOR is split into byte planes and compressed. The encoding is lossless, and
+ * Apply() and Revert() are the same operation.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FMeshVertexDeltaChange : public FToolCommandChange
+{
+public:
+	/**
+	 * Update the LOD0 source MeshDescription of StaticMesh with the vertex positions and normals of Mesh, and emit a
+	 * FMeshVertexDeltaChange for the update into the active transaction of ToolManager. Mesh must have the topology
+	 * of the MeshDescription, ie it was converted from it and only its vertices were moved.
+	 * @return false if the update is not possible, in which case the Static Mesh was not modified
+	 */
+	static bool CommitVertexUpdate(UStaticMesh* StaticMesh, const UE::Geometry::FDynamicMesh3& Mesh,
+		UInteractiveToolManager* ToolManager, const FText& Description);
+
+	/** @return false if the values of Before and After are not of compatible meshes */
+	bool Initialize(const TArray<uint32>& Before, const TArray<uint32>& After);
+
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual FString ToString() const override;
+
+	uint64 GetCompressedSize() const { return (uint64)CompressedDelta.Num(); }
+	uint64 GetUncompressedSize() const { return (uint64)NumValues * sizeof(uint32); }
+
+	/** Append the bits of the vertex positions, and the vertex instance normals, tangents and binormal signs of Mesh to ValuesOut */
+	static void GatherValues(const FMeshDescription& Mesh, TArray<uint32>& ValuesOut);
+	/** Set the values gathered by GatherValues() */
+	static void ScatterValues(const TArray<uint32>& Values, FMeshDescription& Mesh);
+
+protected:
+	int32 NumValues = 0;
+	TArray<uint8> CompressedDelta;
+
+	// XOR the delta into the Static Mesh, in either direction
+	void ApplyDelta(UObject* Object) const;
+};
@@ -0,0 +1,87 @@
+// Distributed under the Boost Software License, Version 1.0.
+// https://www.boost.org/LICENSE_1_0.txt
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "HAL/CriticalSection.h"
+#include "Async/Future.h"
+
+class UToolTarget;
+struct FMeshDescription;
+
+
+/**
+ * FToolInputMeshCache keeps the converted input meshes of the plugin Tools, and their vertex normals,
+ * so that starting another Tool on the same asset does not convert the mesh and compute the normals again.
+ *
+ * Entries are keyed by the source asset and its change version (currently the ID of the Static Mesh
+ * source MeshDescription, which changes on each commit), so an edited asset is never returned from the cache.
+ * The cached meshes are immutable and shared with the Tools and their operators. The total memory of the
+ * entries is limited by USampleModelingModeExtensionSettings::InputMeshCacheLimitMB, and the least-recently
+ * used entries are evicted first. Entries that are still used by a Tool are kept alive by the Tool.
+ */
+class SAMPLEMODELINGMODEEXTENSION_API FToolInputMeshCache
+{
+public:
+	struct FInput
+	{
+		TSharedPtr<const UE::Geometry::FDynamicMesh3, ESPMode::ThreadSafe> Mesh;
+		// null unless normals were requested
+		TSharedPtr<const UE::Geometry::FMeshNormals, ESPMode::ThreadSafe> VertexNormals;
+	};
+
+	/** @return the module-wide cache */
+	static FToolInputMeshCache& Get();
+
+	/**
+	 * Get the input mesh of Target, and its vertex normals if bRequireNormals is true. These are returned from
+	 * the cache if possible, otherwise they are converted on the thread pool and added to the cache (on the game thread)
+	 * if the Target supports caching. Must be called on the game thread. The source MeshDescription of Target is read
+	 * by the conversion, so it must not be modified until the returned future is ready.
+	 */
+	TFuture<FInput> GetInputAsync(UToolTarget* Target, bool bRequireNormals);
+
+	/** Remove all entries */
+	void Reset();
+
+	/** @return memory of the cached entries, in bytes */
+	uint64 GetCachedMemory() const;
+
+	int64 GetNumHits() const { return NumHits; }
+	int64 GetNumMisses() const { return NumMisses; }
+
+protected:
+	struct FKey
+	{
+		TWeakObjectPtr<const UObject> Source;
+		FString Version;
+	};
+
+	struct FEntry
+	{
+		FKey Key;
+		FInput Input;
+		uint64 Memory = 0;
+		uint64 LastUsed = 0;
+	};
+	TArray<FEntry> Entries;
+	uint64 UseCounter = 0;
+	int64 NumHits = 0;
+	int64 NumMisses = 0;
+
+	mutable FCriticalSection Lock;
+
+	// @return false if the mesh of Target cannot be cached
+	static bool GetTargetKey(UToolTarget* Target, FKey& KeyOut);
+	static uint64 GetEntryMemory(const FInput& Input);
+
+	// convert MeshDescription unless Cached already has a mesh, and compute the normals if required
+	static FInput ConvertInput(FInput Cached, const FMeshDescription* MeshDescription, bool bRequireNormals);
+	void AddEntry(const FKey& Key, const FInput& Input);
+
+	// remove stale versions of Key.Source and evict entries until the cache fits into the memory limit
+	void Trim(const FKey* AddedKey);
+};
@@ -55,7 +55,15 @@ public class SampleModelingModeExtension : ModuleRules
 				"LevelEditor",
 				"StatusBar",
 				"EditorStyle",
-				"Projects"
+				"Projects",
+
+				"MeshDescription",
+				"StaticMeshDescription",
+				"MeshConversion",
+				"Json",
+				"JsonUtilities",
+				"AssetRegistry",
+				"DeveloperSettings"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);